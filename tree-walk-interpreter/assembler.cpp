@@ -0,0 +1,246 @@
+#include "assembler.h"
+
+#include <cassert>
+
+namespace lox {
+
+namespace {
+
+std::uint8_t Code(X64Assembler::Reg r) { return static_cast<std::uint8_t>(r); }
+std::uint8_t Code(X64Assembler::Xmm x) { return static_cast<std::uint8_t>(x); }
+
+}  // namespace
+
+void X64Assembler::Imm32(std::uint32_t v) {
+    for (int i = 0; i < 4; ++i) {
+        Byte(static_cast<std::uint8_t>(v >> (8 * i)));
+    }
+}
+
+void X64Assembler::Imm64(std::uint64_t v) {
+    for (int i = 0; i < 8; ++i) {
+        Byte(static_cast<std::uint8_t>(v >> (8 * i)));
+    }
+}
+
+void X64Assembler::Rex(bool w, std::uint8_t reg, std::uint8_t rm) {
+    std::uint8_t rex = 0x40 | (w ? 0x8 : 0) | (reg & 8 ? 0x4 : 0) |
+                       (rm & 8 ? 0x1 : 0);
+    if (rex != 0x40) {
+        Byte(rex);
+    }
+}
+
+void X64Assembler::Memory(std::uint8_t reg, std::int32_t disp) {
+    ModRm(0b10, reg, Code(Reg::RBX));
+    Imm32(static_cast<std::uint32_t>(disp));
+}
+
+void X64Assembler::Rel32(Label target) {
+    fixups_.push_back(Fixup{Position(), target});
+    Imm32(0);
+}
+
+X64Assembler::Label X64Assembler::NewLabel() {
+    labels_.push_back(kUnbound);
+    return std::size(labels_) - 1;
+}
+
+void X64Assembler::Bind(Label label) { labels_[label] = Position(); }
+
+void X64Assembler::Push(Reg r) {
+    Rex(false, 0, Code(r));
+    Byte(0x50 + (Code(r) & 7));
+}
+
+void X64Assembler::Pop(Reg r) {
+    Rex(false, 0, Code(r));
+    Byte(0x58 + (Code(r) & 7));
+}
+
+void X64Assembler::Mov(Reg dst, Reg src) {
+    Rex(true, Code(src), Code(dst));
+    Byte(0x89);
+    ModRm(0b11, Code(src), Code(dst));
+}
+
+void X64Assembler::Mov(Reg dst, std::uint32_t imm) {
+    Rex(false, 0, Code(dst));
+    Byte(0xB8 + (Code(dst) & 7));
+    Imm32(imm);
+}
+
+void X64Assembler::Mov(Reg dst, std::uint64_t imm) {
+    Rex(true, 0, Code(dst));
+    Byte(0xB8 + (Code(dst) & 7));
+    Imm64(imm);
+}
+
+void X64Assembler::Movzx(Reg dst, Reg src8) {
+    assert(Code(src8) < 4);
+    Rex(false, Code(dst), Code(src8));
+    Byte(0x0F);
+    Byte(0xB6);
+    ModRm(0b11, Code(dst), Code(src8));
+}
+
+void X64Assembler::Lea(Reg dst, std::int32_t disp) {
+    Rex(true, Code(dst), 0);
+    Byte(0x8D);
+    Memory(Code(dst), disp);
+}
+
+void X64Assembler::LoadByte(Reg dst8, std::int32_t disp) {
+    assert(Code(dst8) < 4);
+    Byte(0x8A);
+    Memory(Code(dst8), disp);
+}
+
+void X64Assembler::StoreByte(std::int32_t disp, Reg src8) {
+    assert(Code(src8) < 4);
+    Byte(0x88);
+    Memory(Code(src8), disp);
+}
+
+void X64Assembler::StoreByte(std::int32_t disp, std::uint8_t imm) {
+    Byte(0xC6);
+    Memory(0, disp);
+    Byte(imm);
+}
+
+void X64Assembler::CmpByte(std::int32_t disp, std::uint8_t imm) {
+    Byte(0x80);
+    Memory(7, disp);
+    Byte(imm);
+}
+
+void X64Assembler::Xor(Reg dst8, std::uint8_t imm) {
+    assert(Code(dst8) < 4);
+    Byte(0x80);
+    ModRm(0b11, 6, Code(dst8));
+    Byte(imm);
+}
+
+void X64Assembler::And(Reg dst8, Reg src8) {
+    assert(Code(dst8) < 4 && Code(src8) < 4);
+    Byte(0x20);
+    ModRm(0b11, Code(src8), Code(dst8));
+}
+
+void X64Assembler::Or(Reg dst8, Reg src8) {
+    assert(Code(dst8) < 4 && Code(src8) < 4);
+    Byte(0x08);
+    ModRm(0b11, Code(src8), Code(dst8));
+}
+
+void X64Assembler::Test(Reg a, Reg b) {
+    Rex(true, Code(b), Code(a));
+    Byte(0x85);
+    ModRm(0b11, Code(b), Code(a));
+}
+
+void X64Assembler::Setcc(Condition c, Reg dst8) {
+    assert(Code(dst8) < 4);
+    Byte(0x0F);
+    Byte(0x90 + static_cast<std::uint8_t>(c));
+    ModRm(0b11, 0, Code(dst8));
+}
+
+void X64Assembler::Movsd(Xmm dst, std::int32_t disp) {
+    Byte(0xF2);
+    Byte(0x0F);
+    Byte(0x10);
+    Memory(Code(dst), disp);
+}
+
+void X64Assembler::Movsd(std::int32_t disp, Xmm src) {
+    Byte(0xF2);
+    Byte(0x0F);
+    Byte(0x11);
+    Memory(Code(src), disp);
+}
+
+void X64Assembler::Movq(Xmm dst, Reg src) {
+    Byte(0x66);
+    Rex(true, Code(dst), Code(src));
+    Byte(0x0F);
+    Byte(0x6E);
+    ModRm(0b11, Code(dst), Code(src));
+}
+
+namespace {
+
+// Scalar double instructions share the F2 0F <op> /r encoding.
+void ScalarDouble(std::vector<std::uint8_t>& code, std::uint8_t prefix,
+                  std::uint8_t op, std::uint8_t dst, std::uint8_t src) {
+    code.push_back(prefix);
+    code.push_back(0x0F);
+    code.push_back(op);
+    code.push_back(static_cast<std::uint8_t>(0xC0 | dst << 3 | src));
+}
+
+}  // namespace
+
+void X64Assembler::Addsd(Xmm dst, Xmm src) {
+    ScalarDouble(code_, 0xF2, 0x58, Code(dst), Code(src));
+}
+
+void X64Assembler::Subsd(Xmm dst, Xmm src) {
+    ScalarDouble(code_, 0xF2, 0x5C, Code(dst), Code(src));
+}
+
+void X64Assembler::Mulsd(Xmm dst, Xmm src) {
+    ScalarDouble(code_, 0xF2, 0x59, Code(dst), Code(src));
+}
+
+void X64Assembler::Divsd(Xmm dst, Xmm src) {
+    ScalarDouble(code_, 0xF2, 0x5E, Code(dst), Code(src));
+}
+
+void X64Assembler::Xorpd(Xmm dst, Xmm src) {
+    ScalarDouble(code_, 0x66, 0x57, Code(dst), Code(src));
+}
+
+void X64Assembler::Ucomisd(Xmm a, Xmm b) {
+    ScalarDouble(code_, 0x66, 0x2E, Code(a), Code(b));
+}
+
+void X64Assembler::Jmp(Label target) {
+    Byte(0xE9);
+    Rel32(target);
+}
+
+void X64Assembler::Jcc(Condition c, Label target) {
+    Byte(0x0F);
+    Byte(0x80 + static_cast<std::uint8_t>(c));
+    Rel32(target);
+}
+
+void X64Assembler::Jmp(Reg target) {
+    Rex(false, 0, Code(target));
+    Byte(0xFF);
+    ModRm(0b11, 4, Code(target));
+}
+
+void X64Assembler::Call(Reg target) {
+    Rex(false, 0, Code(target));
+    Byte(0xFF);
+    ModRm(0b11, 2, Code(target));
+}
+
+std::vector<std::uint8_t> X64Assembler::Finish() {
+    for (const auto& fixup : fixups_) {
+        assert(labels_[fixup.Target] != kUnbound);
+        auto rel = static_cast<std::int64_t>(labels_[fixup.Target]) -
+                   static_cast<std::int64_t>(fixup.Position + 4);
+        auto value = static_cast<std::uint32_t>(static_cast<std::int32_t>(rel));
+        for (int i = 0; i < 4; ++i) {
+            code_[fixup.Position + i] =
+                static_cast<std::uint8_t>(value >> (8 * i));
+        }
+    }
+    fixups_.clear();
+    return std::move(code_);
+}
+
+}  // namespace lox
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace lox {
+
+// Just enough of an x86-64 assembler for the JIT. Memory operands are always
+// [rbx + disp32], the JIT keeps the registers of the Lox frame in rbx.
+class X64Assembler {
+   public:
+    enum class Reg : std::uint8_t {
+        RAX = 0,
+        RCX = 1,
+        RDX = 2,
+        RBX = 3,
+        RSP = 4,
+        RBP = 5,
+        RSI = 6,
+        RDI = 7,
+        R12 = 12,
+        R13 = 13,
+    };
+    enum class Xmm : std::uint8_t { XMM0 = 0, XMM1 = 1 };
+    // Condition codes as encoded in jcc and setcc.
+    enum class Condition : std::uint8_t {
+        B = 0x2,
+        AE = 0x3,
+        E = 0x4,
+        NE = 0x5,
+        BE = 0x6,
+        A = 0x7,
+        P = 0xA,
+        NP = 0xB,
+    };
+    using Label = std::size_t;
+
+   private:
+    std::vector<std::uint8_t> code_;
+    std::vector<std::size_t> labels_;  // Position of each bound label.
+    struct Fixup {
+        std::size_t Position;  // Of the rel32 to patch.
+        Label Target;
+    };
+    std::vector<Fixup> fixups_;
+
+    static constexpr std::size_t kUnbound = ~std::size_t(0);
+
+    void Byte(std::uint8_t b) { code_.push_back(b); }
+    void Imm32(std::uint32_t v);
+    void Imm64(std::uint64_t v);
+    // REX prefix, only emitted when it is needed.
+    void Rex(bool w, std::uint8_t reg, std::uint8_t rm);
+    void ModRm(std::uint8_t mod, std::uint8_t reg, std::uint8_t rm) {
+        Byte(static_cast<std::uint8_t>(mod << 6 | (reg & 7) << 3 | (rm & 7)));
+    }
+    // ModRM and displacement of [rbx + disp].
+    void Memory(std::uint8_t reg, std::int32_t disp);
+    void Rel32(Label target);
+
+   public:
+    Label NewLabel();
+    void Bind(Label label);
+
+    void Push(Reg r);
+    void Pop(Reg r);
+    void Mov(Reg dst, Reg src);
+    void Mov(Reg dst, std::uint32_t imm);  // Zero extends.
+    void Mov(Reg dst, std::uint64_t imm);
+    void Movzx(Reg dst, Reg src8);
+    void Lea(Reg dst, std::int32_t disp);
+    void LoadByte(Reg dst8, std::int32_t disp);
+    void StoreByte(std::int32_t disp, Reg src8);
+    void StoreByte(std::int32_t disp, std::uint8_t imm);
+    void CmpByte(std::int32_t disp, std::uint8_t imm);
+    void Xor(Reg dst8, std::uint8_t imm);
+    void And(Reg dst8, Reg src8);
+    void Or(Reg dst8, Reg src8);
+    void Test(Reg a, Reg b);
+    void Setcc(Condition c, Reg dst8);
+
+    void Movsd(Xmm dst, std::int32_t disp);
+    void Movsd(std::int32_t disp, Xmm src);
+    void Movq(Xmm dst, Reg src);
+    void Addsd(Xmm dst, Xmm src);
+    void Subsd(Xmm dst, Xmm src);
+    void Mulsd(Xmm dst, Xmm src);
+    void Divsd(Xmm dst, Xmm src);
+    void Xorpd(Xmm dst, Xmm src);
+    void Ucomisd(Xmm a, Xmm b);
+
+    void Jmp(Label target);
+    void Jcc(Condition c, Label target);
+    void Jmp(Reg target);
+    void Call(Reg target);
+    void Ret() { Byte(0xC3); }
+
+    std::size_t Position() const { return std::size(code_); }
+    std::size_t Position(Label label) const { return labels_[label]; }
+    // Resolve the jumps and return the machine code.
+    std::vector<std::uint8_t> Finish();
+};
+
+}  // namespace lox
@@ -0,0 +1,138 @@
+#include "batch.h"
+
+#include <list>
+#include <stdexcept>
+
+#include "eventLoop.h"
+#include "interpreter.h"
+#include "lox.h"
+#include "output.h"
+#include "snapshot.h"
+#include "threadPool.h"
+
+namespace lox {
+
+// Prepare source, with the errors captured in result. Return null if it
+// doesn't compile.
+static std::unique_ptr<Program> Compile(const std::string& source,
+                                        BatchResult& result) {
+    StringSink errors;
+    std::unique_ptr<Program> program;
+    {
+        Output out(errors);
+        Metrics stats;
+        program = Prepare(source, out, stats);
+    }
+    result.Output = std::move(errors.Text);
+    if (program == nullptr) {
+        result.Result = BatchResult::Status::COMPILE_ERROR;
+    }
+    return program;
+}
+
+// Start interpreter from snapshot if it isn't null, or count a corrupt one
+// as a compile error in result and return false.
+static bool Restore(Interpreter& interpreter, const Snapshot* snapshot,
+                    BatchResult& result) {
+    if (snapshot == nullptr) {
+        return true;
+    }
+    try {
+        snapshot->Restore(interpreter);
+    } catch (const std::runtime_error& e) {
+        result.Output += e.what();
+        result.Output += '\n';
+        result.Result = BatchResult::Status::COMPILE_ERROR;
+        return false;
+    }
+    return true;
+}
+
+// Run program on a new interpreter, started from snapshot if it isn't null,
+// with its output captured in result.
+static void Execute(const Program& program, const Snapshot* snapshot,
+                    BatchResult& result) {
+    StringSink sink;
+    {
+        Interpreter interpreter;
+        interpreter.Out.SetSink(sink);
+        if (!Restore(interpreter, snapshot, result)) {
+            return;
+        }
+        if (!interpreter.Interpret(program.Statements, program.Locals)) {
+            result.Result = BatchResult::Status::RUNTIME_ERROR;
+        }
+    }
+    result.Output += sink.Text;
+}
+
+std::vector<BatchResult> RunBatch(const std::vector<std::string>& sources,
+                                  std::size_t threads,
+                                  const Snapshot* snapshot) {
+    std::vector<BatchResult> results(std::size(sources));
+    ThreadPool pool(threads);
+    for (std::size_t i = 0; i < std::size(sources); ++i) {
+        pool.Submit([&sources, &results, snapshot, i] {
+            auto& result = results[i];
+            auto program = Compile(sources[i], result);
+            if (program != nullptr) {
+                Execute(*program, snapshot, result);
+            }
+        });
+    }
+    pool.Wait();
+    return results;
+}
+
+std::vector<BatchResult> RunConcurrent(const std::vector<std::string>& sources,
+                                       const Snapshot* snapshot) {
+    // A script of the loop, which keeps what it runs on alive until the
+    // loop is done.
+    struct Script {
+        std::unique_ptr<Program> Code;
+        StringSink Sink;
+        Interpreter Runner;
+    };
+    std::vector<BatchResult> results(std::size(sources));
+    std::list<Script> scripts;
+    EventLoop loop;
+    for (std::size_t i = 0; i < std::size(sources); ++i) {
+        auto& result = results[i];
+        auto program = Compile(sources[i], result);
+        if (program == nullptr) {
+            continue;
+        }
+        auto& script = scripts.emplace_back();
+        script.Code = std::move(program);
+        script.Runner.Out.SetSink(script.Sink);
+        if (!Restore(script.Runner, snapshot, result)) {
+            continue;
+        }
+        loop.Spawn(script.Runner, *script.Code,
+                   [&script, &result](bool ok) {
+                       if (!ok) {
+                           result.Result = BatchResult::Status::RUNTIME_ERROR;
+                       }
+                       script.Runner.Out.flush();
+                       result.Output += script.Sink.Text;
+                   });
+    }
+    loop.Run();
+    return results;
+}
+
+std::vector<BatchResult> RunBatch(
+    const std::vector<std::shared_ptr<const Program>>& programs,
+    std::size_t threads, const Snapshot* snapshot) {
+    std::vector<BatchResult> results(std::size(programs));
+    ThreadPool pool(threads);
+    for (std::size_t i = 0; i < std::size(programs); ++i) {
+        pool.Submit([&programs, &results, snapshot, i] {
+            Execute(*programs[i], snapshot, results[i]);
+        });
+    }
+    pool.Wait();
+    return results;
+}
+
+}  // namespace lox
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "program.h"
+
+namespace lox {
+
+class Snapshot;
+
+// What running one script of a batch did.
+struct BatchResult {
+    enum class Status { OK, COMPILE_ERROR, RUNTIME_ERROR };
+    Status Result = Status::OK;
+    // What it printed, and the errors that stopped it, the same as running
+    // the script on its own would print.
+    std::string Output;
+};
+
+// Run independent scripts at the same time, on a ThreadPool of threads
+// threads, and return what each did in the order of the scripts. Every run
+// gets an interpreter of its own, so the scripts don't see each other's
+// globals. The sources are prepared on the threads as well. If snapshot
+// isn't null every interpreter starts from it, a corrupt one counts as a
+// compile error of each script.
+std::vector<BatchResult> RunBatch(const std::vector<std::string>& sources,
+                                  std::size_t threads,
+                                  const Snapshot* snapshot = nullptr);
+// Run independent scripts interleaved on this thread, on one EventLoop:
+// while one waits in an async native such as sleep, the others run. Each
+// gets an interpreter of its own as with RunBatch, and the results are the
+// same.
+std::vector<BatchResult> RunConcurrent(const std::vector<std::string>& sources,
+                                       const Snapshot* snapshot = nullptr);
+// Likewise for prepared programs. They are only read, so the same one can
+// be in programs several times.
+std::vector<BatchResult> RunBatch(
+    const std::vector<std::shared_ptr<const Program>>& programs,
+    std::size_t threads, const Snapshot* snapshot = nullptr);
+
+}  // namespace lox
@@ -0,0 +1,127 @@
+// Scripts that wait for I/O in async natives: run one after the other, each
+// blocking while it waits, against interleaved on one EventLoop, where the
+// waits overlap.
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <list>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "batch.h"
+#include "benchmark.h"
+#include "eventLoop.h"
+#include "interpreter.h"
+#include "lox.h"
+#include "metrics.h"
+#include "output.h"
+#include "symbolTable.h"
+
+namespace {
+
+using TOut = lox::Interpreter::TOut;
+
+constexpr int kSleepers = 100;
+constexpr int kSleeps = 5;
+constexpr int kClients = 100;
+constexpr int kRequests = 200;
+
+// echo(value): a stand-in for a request to a local service, which answers
+// with value once a byte went through a pipe.
+std::shared_ptr<lox::Pending> Echo(lox::EventLoop& loop, TOut* args,
+                                   std::uint32_t) {
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC | O_NONBLOCK) < 0) {
+        throw std::system_error(errno, std::generic_category(), "pipe2");
+    }
+    char byte = 0;
+    if (write(fds[1], &byte, 1) != 1) {
+        throw std::system_error(errno, std::generic_category(), "write");
+    }
+    auto pending = std::make_shared<lox::Pending>();
+    loop.Watch(fds[0], EPOLLIN, [pending, fds, value = args[0]] {
+        char byte;
+        if (read(fds[0], &byte, 1) != 1) {
+            pending->Fail("The service didn't answer.");
+        } else {
+            pending->Complete(value);
+        }
+        close(fds[0]);
+        close(fds[1]);
+    });
+    return pending;
+}
+
+const lox::LoxNative kEcho{"echo", 1, nullptr, Echo};
+
+std::string GenSleeper() {
+    return "fun main() {\n"
+           "    for (var i = 0; i < " +
+           std::to_string(kSleeps) +
+           "; i = i + 1) sleep(0.002);\n"
+           "    print \"done\";\n"
+           "}\n"
+           "main();\n";
+}
+
+std::string GenClient() {
+    return "fun main() {\n"
+           "    var sum = 0;\n"
+           "    for (var i = 0; i < " +
+           std::to_string(kRequests) +
+           "; i = i + 1) sum = sum + echo(i);\n"
+           "    print sum;\n"
+           "}\n"
+           "main();\n";
+}
+
+// Interpreters with echo defined, writing to a sink.
+struct Client {
+    lox::StringSink Sink;
+    lox::Interpreter Runner;
+
+    Client() {
+        Runner.Out.SetSink(Sink);
+        Runner.Globals->Define(lox::Symbols().Intern("echo"), &kEcho);
+    }
+};
+
+}  // namespace
+
+int main() {
+    std::vector<std::string> sleepers(kSleepers, GenSleeper());
+    double seconds = lox::bench::BestOf(
+        3, [&] { lox::RunBatch(sleepers, 1); });
+    lox::bench::Report("sleep, one after the other", seconds, kSleepers,
+                       "scripts");
+    seconds = lox::bench::BestOf(3, [&] { lox::RunConcurrent(sleepers); });
+    lox::bench::Report("sleep, on an event loop", seconds, kSleepers,
+                       "scripts");
+
+    lox::StringSink errors;
+    lox::Output out(errors);
+    lox::Metrics stats;
+    auto program = lox::Prepare(GenClient(), out, stats);
+    constexpr double kAwaits = double{kClients} * kRequests;
+    seconds = lox::bench::BestOf(3, [&] {
+        for (int i = 0; i < kClients; ++i) {
+            Client client;
+            client.Runner.Interpret(program->Statements, program->Locals);
+        }
+    });
+    lox::bench::Report("echo, one after the other", seconds, kAwaits,
+                       "calls");
+    seconds = lox::bench::BestOf(3, [&] {
+        std::list<Client> clients;
+        lox::EventLoop loop;
+        for (int i = 0; i < kClients; ++i) {
+            loop.Spawn(clients.emplace_back().Runner, *program);
+        }
+        loop.Run();
+    });
+    lox::bench::Report("echo, on an event loop", seconds, kAwaits, "calls");
+}
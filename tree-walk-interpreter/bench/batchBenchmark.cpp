@@ -0,0 +1,84 @@
+// Throughput of running many small independent scripts with RunBatch, on
+// one thread and on more, from source and from one shared prepared program.
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "batch.h"
+#include "benchmark.h"
+#include "lox.h"
+#include "metrics.h"
+#include "output.h"
+
+namespace {
+
+constexpr int kScripts = 2000;
+
+// A small script like a service would evaluate: a class, a loop over a
+// list and a map, and a recursive function, sized by n.
+std::string GenScript(int n) {
+    return "class Counter {\n"
+           "    init() { this.count = 0; }\n"
+           "    add(x) { this.count = this.count + x; }\n"
+           "}\n"
+           "fun fib(n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }\n"
+           "fun run(n) {\n"
+           "    var counter = Counter();\n"
+           "    var xs = [];\n"
+           "    var seen = {};\n"
+           "    for (var i = 0; i < n; i = i + 1) {\n"
+           "        push(xs, i * 2);\n"
+           "        seen[\"k\" + \"x\"] = i;\n"
+           "        counter.add(xs[i]);\n"
+           "    }\n"
+           "    return counter.count + fib(12) + len(seen);\n"
+           "}\n"
+           "print run(" +
+           std::to_string(n) + ");\n";
+}
+
+void Run(const std::string& name, std::size_t threads,
+         const std::vector<std::string>& sources) {
+    double seconds = lox::bench::BestOf(
+        3, [&] { lox::RunBatch(sources, threads); });
+    lox::bench::Report(name + ", " + std::to_string(threads) + " threads",
+                       seconds, kScripts, "scripts");
+}
+
+void Run(const std::string& name, std::size_t threads,
+         const std::vector<std::shared_ptr<const lox::Program>>& programs) {
+    double seconds = lox::bench::BestOf(
+        3, [&] { lox::RunBatch(programs, threads); });
+    lox::bench::Report(name + ", " + std::to_string(threads) + " threads",
+                       seconds, kScripts, "scripts");
+}
+
+}  // namespace
+
+int main() {
+    std::vector<std::string> sources;
+    for (int i = 0; i < kScripts; ++i) {
+        sources.push_back(GenScript(100 + i % 100));
+    }
+
+    lox::StringSink errors;
+    lox::Output out(errors);
+    lox::Metrics stats;
+    std::shared_ptr<const lox::Program> program =
+        lox::Prepare(GenScript(150), out, stats);
+    std::vector<std::shared_ptr<const lox::Program>> programs(kScripts,
+                                                              program);
+
+    std::vector<std::size_t> thread_counts = {1, 2, 4};
+    std::size_t cores = std::thread::hardware_concurrency();
+    if (cores > 4) {
+        thread_counts.push_back(cores);
+    }
+    for (auto threads : thread_counts) {
+        Run("sources", threads, sources);
+    }
+    for (auto threads : thread_counts) {
+        Run("shared program", threads, programs);
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace lox::bench {
+
+// Run fn `repeat` times and return the fastest run in seconds, the minimum
+// is the least noisy estimate on a shared machine.
+template <typename Fn>
+double BestOf(int repeat, Fn&& fn) {
+    double best = 1e300;
+    for (int i = 0; i < repeat; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+inline void Report(const std::string& name, double seconds,
+                   double units, const char* unit) {
+    std::printf("%-32s %10.3f ms %14.0f %s/s\n", name.c_str(),
+                seconds * 1e3, units / seconds, unit);
+}
+
+// Small deterministic generator, so the generated programs are identical
+// between runs and machines.
+class Random {
+    std::uint64_t state_;
+
+   public:
+    explicit Random(std::uint64_t seed) : state_(seed) {}
+
+    std::uint32_t Next() {
+        state_ = state_ * 6364136223846793005ULL + 1442695040888963407ULL;
+        return static_cast<std::uint32_t>(state_ >> 33);
+    }
+
+    // Uniform in [0, n).
+    std::uint32_t Below(std::uint32_t n) { return Next() % n; }
+};
+
+}  // namespace lox::bench
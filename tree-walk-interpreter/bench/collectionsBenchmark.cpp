@@ -0,0 +1,139 @@
+// Throughput of the List and Map values: push and index on a list, insert
+// and lookup on a map with number and string keys, against std containers
+// holding the same values.
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "benchmark.h"
+#include "interpreter.h"
+#include "loxList.h"
+#include "loxMap.h"
+
+namespace {
+
+using TOut = lox::Interpreter::TOut;
+
+constexpr int kElements = 1 << 20;
+constexpr int kKeys = 1 << 16;
+constexpr int kLookups = 1 << 20;
+
+double Sum(const TOut& value) {
+    auto* d = std::get_if<double>(&value);
+    return d != nullptr ? *d : 1.0;
+}
+
+double ListPush() {
+    lox::LoxList list;
+    for (int i = 0; i < kElements; ++i) {
+        list.Elements.push_back(static_cast<double>(i));
+    }
+    return static_cast<double>(std::size(list.Elements));
+}
+
+double ListIndex(const lox::LoxList& list) {
+    double sum = 0;
+    for (int i = 0; i < kElements; ++i) {
+        sum += Sum(list.Elements[i]);
+    }
+    return sum;
+}
+
+// Keys as scripts produce them: string keys are built once and then looked
+// up with the same strings, like constants.
+std::vector<TOut> StringKeys() {
+    std::vector<TOut> keys;
+    for (int i = 0; i < kKeys; ++i) {
+        keys.push_back(lox::LoxString("key" + std::to_string(i)));
+    }
+    return keys;
+}
+
+std::vector<TOut> NumberKeys() {
+    std::vector<TOut> keys;
+    for (int i = 0; i < kKeys; ++i) {
+        keys.push_back(static_cast<double>(i));
+    }
+    return keys;
+}
+
+// Keys to look up, in a random order.
+std::vector<int> LookupOrder() {
+    lox::bench::Random random(42);
+    std::vector<int> order;
+    for (int i = 0; i < kLookups; ++i) {
+        order.push_back(static_cast<int>(random.Below(kKeys)));
+    }
+    return order;
+}
+
+double MapInsert(const std::vector<TOut>& keys) {
+    lox::LoxMap map;
+    for (int i = 0; i < kKeys; ++i) {
+        map.Insert(keys[i], static_cast<double>(i));
+    }
+    return static_cast<double>(map.size());
+}
+
+double MapLookup(const lox::LoxMap& map, const std::vector<TOut>& keys,
+                 const std::vector<int>& order) {
+    double sum = 0;
+    for (int i : order) {
+        sum += Sum(*map.Find(keys[i]));
+    }
+    return sum;
+}
+
+double StdMapLookup(const std::unordered_map<std::string, TOut>& map,
+                    const std::vector<std::string>& keys,
+                    const std::vector<int>& order) {
+    double sum = 0;
+    for (int i : order) {
+        sum += Sum(map.find(keys[i])->second);
+    }
+    return sum;
+}
+
+template <typename Fn>
+void Run(const std::string& name, double units, const char* unit, Fn&& fn) {
+    volatile double sink = 0;
+    double seconds = lox::bench::BestOf(5, [&] { sink = fn(); });
+    lox::bench::Report(name, seconds, units, unit);
+}
+
+}  // namespace
+
+int main() {
+    Run("List push", kElements, "push", ListPush);
+
+    lox::LoxList list;
+    for (int i = 0; i < kElements; ++i) {
+        list.Elements.push_back(static_cast<double>(i));
+    }
+    Run("List index", kElements, "index", [&] { return ListIndex(list); });
+
+    auto order = LookupOrder();
+    auto number_keys = NumberKeys();
+    auto string_keys = StringKeys();
+    Run("Map insert (numbers)", kKeys, "insert",
+        [&] { return MapInsert(number_keys); });
+    Run("Map insert (strings)", kKeys, "insert",
+        [&] { return MapInsert(string_keys); });
+
+    lox::LoxMap numbers;
+    lox::LoxMap strings;
+    std::unordered_map<std::string, TOut> std_strings;
+    std::vector<std::string> std_keys;
+    for (int i = 0; i < kKeys; ++i) {
+        numbers.Insert(number_keys[i], static_cast<double>(i));
+        strings.Insert(string_keys[i], static_cast<double>(i));
+        std_keys.push_back(std::get<lox::LoxString>(string_keys[i]).Str());
+        std_strings.emplace(std_keys.back(), static_cast<double>(i));
+    }
+    Run("Map lookup (numbers)", kLookups, "lookup",
+        [&] { return MapLookup(numbers, number_keys, order); });
+    Run("Map lookup (strings)", kLookups, "lookup",
+        [&] { return MapLookup(strings, string_keys, order); });
+    Run("std::unordered_map lookup", kLookups, "lookup",
+        [&] { return StdMapLookup(std_strings, std_keys, order); });
+}
@@ -0,0 +1,116 @@
+// Throughput of the F64Array kernels against plain loops over the same
+// arrays, which is what the compiler makes of element-by-element code.
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include "simd.h"
+
+namespace {
+
+constexpr std::size_t kElements = 1 << 16;
+constexpr int kRepeat = 200;
+
+std::vector<double> Numbers(std::uint64_t seed) {
+    lox::bench::Random random(seed);
+    std::vector<double> numbers(kElements);
+    for (auto& n : numbers) {
+        n = random.Below(1000) / 10.0;
+    }
+    return numbers;
+}
+
+// Keep the compiler from vectorizing the baseline loops, which it would
+// only do here, with the loop count and the arrays in plain sight. GCC has
+// the loop pragma from version 14 on, older ones turn vectorizing off for
+// the whole function.
+#if defined(__clang__)
+#define LOX_SCALAR _Pragma("clang loop vectorize(disable)")
+#define LOX_SCALAR_FUNCTION
+#elif defined(__GNUC__) && __GNUC__ >= 14
+#define LOX_SCALAR _Pragma("GCC novector")
+#define LOX_SCALAR_FUNCTION
+#elif defined(__GNUC__)
+#define LOX_SCALAR
+#define LOX_SCALAR_FUNCTION __attribute__((optimize("no-tree-vectorize")))
+#else
+#define LOX_SCALAR
+#define LOX_SCALAR_FUNCTION
+#endif
+
+LOX_SCALAR_FUNCTION
+double LoopAdd(const std::vector<double>& a, const std::vector<double>& b,
+               std::vector<double>& out) {
+    for (int r = 0; r < kRepeat; ++r) {
+        LOX_SCALAR
+        for (std::size_t i = 0; i < kElements; ++i) {
+            out[i] = a[i] + b[i];
+        }
+    }
+    return out[0];
+}
+
+LOX_SCALAR_FUNCTION
+double LoopDot(const std::vector<double>& a, const std::vector<double>& b) {
+    double sum = 0;
+    for (int r = 0; r < kRepeat; ++r) {
+        LOX_SCALAR
+        for (std::size_t i = 0; i < kElements; ++i) {
+            sum += a[i] * b[i];
+        }
+    }
+    return sum;
+}
+
+LOX_SCALAR_FUNCTION
+double LoopMax(const std::vector<double>& a) {
+    double max = 0;
+    for (int r = 0; r < kRepeat; ++r) {
+        LOX_SCALAR
+        for (std::size_t i = 0; i < kElements; ++i) {
+            max = a[i] > max ? a[i] : max;
+        }
+    }
+    return max;
+}
+
+template <typename Fn>
+void Run(const std::string& name, Fn&& fn) {
+    volatile double sink = 0;
+    double seconds = lox::bench::BestOf(5, [&] { sink = fn(); });
+    lox::bench::Report(name, seconds, 1.0 * kElements * kRepeat, "elements");
+}
+
+}  // namespace
+
+int main() {
+    std::printf("kernels: %s\n", lox::simd::InstructionSet());
+    auto a = Numbers(1);
+    auto b = Numbers(2);
+    std::vector<double> out(kElements);
+
+    Run("loop add", [&] { return LoopAdd(a, b, out); });
+    Run("f64Add", [&] {
+        for (int r = 0; r < kRepeat; ++r) {
+            lox::simd::Apply(lox::simd::Op::ADD, a.data(), false, b.data(),
+                             false, out.data(), kElements);
+        }
+        return out[0];
+    });
+    Run("loop dot", [&] { return LoopDot(a, b); });
+    Run("f64Dot", [&] {
+        double sum = 0;
+        for (int r = 0; r < kRepeat; ++r) {
+            sum += lox::simd::Dot(a.data(), b.data(), kElements);
+        }
+        return sum;
+    });
+    Run("loop max", [&] { return LoopMax(a); });
+    Run("f64Max", [&] {
+        double max = 0;
+        for (int r = 0; r < kRepeat; ++r) {
+            max += lox::simd::Max(a.data(), kElements);
+        }
+        return max;
+    });
+}
@@ -0,0 +1,72 @@
+// Runs the Lox programs in bench/workloads and reports the time of the
+// fastest of a few runs of each, with and without the JIT if there is one.
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include "interpreter.h"
+#include "optimizer.h"
+#include "parser.h"
+#include "resolver.h"
+#include "scanner.h"
+
+namespace {
+
+void RunSource(const std::string& source, bool jit, lox::OutputSink& sink) {
+    lox::Scanner scanner(source);
+    lox::Parser parser(scanner.ScanTokens());
+    auto statements = parser.Parse();
+
+    lox::Interpreter interpreter;
+    interpreter.JitEnabled = jit;
+    interpreter.Out.SetSink(sink);
+    lox::Resolver resolver(interpreter);
+    resolver.Resolve(statements);
+    lox::Optimizer(interpreter.locals).Optimize(statements);
+    interpreter.Interpret(statements);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::filesystem::path dir = argc > 1 ? argv[1] : LOX_WORKLOAD_DIR;
+
+    std::vector<std::filesystem::path> files;
+    for (auto& entry : std::filesystem::directory_iterator(dir)) {
+        if (entry.path().extension() == ".lox") {
+            files.push_back(entry.path());
+        }
+    }
+    std::sort(files.begin(), files.end());
+
+#if defined(LOX_COMPUTED_GOTO)
+    std::cout << "dispatch: computed goto" << std::endl;
+#else
+    std::cout << "dispatch: switch" << std::endl;
+#endif
+#if defined(LOX_JIT)
+    const bool modes[] = {false, true};
+#else
+    const bool modes[] = {false};
+#endif
+
+    for (auto& file : files) {
+        std::ifstream in(file);
+        std::stringstream source;
+        source << in.rdbuf();
+
+        for (bool jit : modes) {
+            // Keep the output of the programs out of the report.
+            lox::StringSink sink;
+            double seconds = lox::bench::BestOf(
+                3, [&] { RunSource(source.str(), jit, sink); });
+
+            lox::bench::Report(file.stem().string() + (jit ? " (jit)" : ""),
+                               seconds, 1, "runs");
+        }
+    }
+}
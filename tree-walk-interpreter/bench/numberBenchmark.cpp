@@ -0,0 +1,138 @@
+// Reading and printing numbers: scanning and running generated programs
+// full of number literals, and the number conversions on their own against
+// the atof and iostream ones they replace.
+#include <charconv>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmark.h"
+#include "interpreter.h"
+#include "optimizer.h"
+#include "output.h"
+#include "parser.h"
+#include "resolver.h"
+#include "scanner.h"
+
+namespace {
+
+constexpr int kStatements = 50000;
+
+// A number literal like scripts have: an integer, or one with a few
+// decimals.
+std::string GenNumber(lox::bench::Random& rnd) {
+    std::string number = std::to_string(rnd.Below(100000));
+    if (rnd.Below(2) != 0) {
+        number += "." + std::to_string(rnd.Below(1000000));
+    }
+    return number;
+}
+
+// Prints of arithmetic on literals. Most results have no short decimal
+// form, so printing them takes all digits of a double.
+std::string GenProgram() {
+    lox::bench::Random rnd(42);
+    std::string out;
+    for (int i = 0; i < kStatements; ++i) {
+        out += "print " + GenNumber(rnd) + " / " + GenNumber(rnd) + " + " +
+               GenNumber(rnd) + ";\n";
+    }
+    return out;
+}
+
+// Where the literals of source are, as [start, end) offsets.
+std::vector<std::pair<std::size_t, std::size_t>> Literals(
+    const std::string& source) {
+    std::vector<std::pair<std::size_t, std::size_t>> literals;
+    const char* digits = "0123456789.";
+    for (auto start = source.find_first_of("0123456789");
+         start != std::string::npos;) {
+        auto end = source.find_first_not_of(digits, start);
+        literals.emplace_back(start, end);
+        start = source.find_first_of("0123456789", end);
+    }
+    return literals;
+}
+
+void RunSource(const std::string& source, lox::OutputSink& sink) {
+    lox::Scanner scanner(source);
+    lox::Parser parser(scanner.ScanTokens());
+    auto statements = parser.Parse();
+
+    lox::Interpreter interpreter;
+    interpreter.Out.SetSink(sink);
+    lox::Resolver resolver(interpreter);
+    resolver.Resolve(statements);
+    lox::Optimizer(interpreter.locals).Optimize(statements);
+    interpreter.Interpret(statements);
+}
+
+template <typename Fn>
+void Run(const std::string& name, double units, const char* unit, Fn&& fn) {
+    volatile double sink = 0;
+    double seconds = lox::bench::BestOf(5, [&] { sink = fn(); });
+    lox::bench::Report(name, seconds, units, unit);
+}
+
+}  // namespace
+
+int main() {
+    const std::string source = GenProgram();
+    const auto literals = Literals(source);
+    const double count = static_cast<double>(std::size(literals));
+
+    Run("scan", count, "numbers", [&] {
+        lox::Scanner scanner(source);
+        return static_cast<double>(std::size(scanner.ScanTokens().Numbers));
+    });
+    Run("from_chars", count, "numbers", [&] {
+        double sum = 0;
+        for (auto [start, end] : literals) {
+            double value = 0;
+            std::from_chars(source.data() + start, source.data() + end, value);
+            sum += value;
+        }
+        return sum;
+    });
+    Run("atof(substr)", count, "numbers", [&] {
+        double sum = 0;
+        for (auto [start, end] : literals) {
+            sum += std::atof(source.substr(start, end - start).c_str());
+        }
+        return sum;
+    });
+
+    std::vector<double> values;
+    lox::bench::Random rnd(7);
+    for (int i = 0; i < kStatements; ++i) {
+        values.push_back(std::atof(GenNumber(rnd).c_str()) /
+                         std::atof(GenNumber(rnd).c_str()));
+    }
+    const double value_count = static_cast<double>(std::size(values));
+    // The iostream conversion prints 6 digits, so it writes less.
+    Run("WriteNumber", value_count, "numbers", [&] {
+        lox::StringSink sink;
+        lox::Output out(sink);
+        for (double value : values) {
+            lox::WriteNumber(out, value);
+            out << '\n';
+        }
+        out.flush();
+        return static_cast<double>(std::size(sink.Text));
+    });
+    Run("ostream <<", value_count, "numbers", [&] {
+        std::ostringstream out;
+        for (double value : values) {
+            out << value << '\n';
+        }
+        return static_cast<double>(std::size(out.str()));
+    });
+
+    Run("run and print", kStatements, "statements", [&] {
+        lox::StringSink sink;
+        RunSource(source, sink);
+        return static_cast<double>(std::size(sink.Text));
+    });
+}
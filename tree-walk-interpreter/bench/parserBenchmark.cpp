@@ -0,0 +1,109 @@
+// Scan and parse throughput on large generated, expression heavy programs.
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include "parser.h"
+#include "scanner.h"
+
+namespace {
+
+using lox::bench::Random;
+
+const char* kBinaryOps[] = {"+",  "-", "*",  "/",  "<",   "<=",
+                            ">",  ">=", "==", "!=", "and", "or"};
+
+// Identifiers are letters only: "va", "vb", ...
+std::string Name(std::uint32_t i) {
+    return std::string("v") + static_cast<char>('a' + i);
+}
+
+void GenExpr(Random& rnd, int depth, std::string& out) {
+    if (depth == 0) {
+        switch (rnd.Below(4)) {
+            case 0:
+                out += std::to_string(rnd.Below(1000));
+                break;
+            case 1:
+                out += Name(rnd.Below(16));
+                break;
+            case 2:
+                out += "\"s" + std::to_string(rnd.Below(100)) + "\"";
+                break;
+            default:
+                out += rnd.Below(2) ? "true" : "nil";
+                break;
+        }
+        return;
+    }
+
+    switch (rnd.Below(6)) {
+        case 0:
+            out += "(";
+            GenExpr(rnd, depth - 1, out);
+            out += ")";
+            break;
+        case 1:
+            out += rnd.Below(2) ? "-" : "!";
+            GenExpr(rnd, depth - 1, out);
+            break;
+        case 2:
+            out += "f" + Name(rnd.Below(4)) + "(";
+            GenExpr(rnd, depth - 1, out);
+            out += ", ";
+            GenExpr(rnd, depth - 1, out);
+            out += ")";
+            break;
+        default:
+            GenExpr(rnd, depth - 1, out);
+            out += " ";
+            out += kBinaryOps[rnd.Below(std::size(kBinaryOps))];
+            out += " ";
+            GenExpr(rnd, depth - 1, out);
+            break;
+    }
+}
+
+// A program of `statements` assignments and prints whose right hand sides
+// are random expression trees of the given depth.
+std::string GenProgram(int statements, int depth) {
+    Random rnd(42);
+    std::string out;
+    for (int i = 0; i < statements; ++i) {
+        out += (i % 3 == 0) ? "print " : Name(i % 16) + " = ";
+        GenExpr(rnd, depth, out);
+        out += ";\n";
+    }
+    return out;
+}
+
+void Run(int statements, int depth) {
+    const std::string source = GenProgram(statements, depth);
+    const double mb = static_cast<double>(std::size(source)) / (1 << 20);
+
+    std::size_t token_count = 0;
+    double scan = lox::bench::BestOf(5, [&] {
+        lox::Scanner scanner(source);
+        token_count = std::size(scanner.ScanTokens().Tokens);
+    });
+
+    lox::Scanner scanner(source);
+    const auto& tokens = scanner.ScanTokens();
+    double parse = lox::bench::BestOf(5, [&] {
+        lox::Parser parser(tokens);
+        auto statements = parser.Parse();
+    });
+
+    std::string label = "depth " + std::to_string(depth) + ", " +
+                        std::to_string(mb).substr(0, 4) + " MB";
+    lox::bench::Report("scan   " + label, scan, token_count, "tokens");
+    lox::bench::Report("parse  " + label, parse, token_count, "tokens");
+}
+
+}  // namespace
+
+int main() {
+    Run(20000, 4);
+    Run(2000, 8);
+    Run(200, 11);
+}
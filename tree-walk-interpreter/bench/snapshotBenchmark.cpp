@@ -0,0 +1,94 @@
+// Starting a new interpreter by running a prelude, against restoring the
+// Snapshot it left behind.
+#include <cstdio>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "benchmark.h"
+#include "interpreter.h"
+#include "lox.h"
+#include "metrics.h"
+#include "output.h"
+#include "snapshot.h"
+
+namespace {
+
+constexpr int kStarts = 50;
+
+// A prelude like a host would load before every script: helper functions,
+// a class, and tables that take some computing.
+std::string GenPrelude(int functions) {
+    std::string source;
+    for (int i = 0; i < functions; ++i) {
+        auto n = std::to_string(i);
+        source += "fun helper" + n + "(x) { var y = x * " + n +
+                  "; if (y > 100) return y - " + n + "; return y + 1; }\n";
+    }
+    source +=
+        "class Vec {\n"
+        "    init(x, y) { this.x = x; this.y = y; }\n"
+        "    add(o) { return Vec(this.x + o.x, this.y + o.y); }\n"
+        "}\n"
+        "var primes = [];\n"
+        "var squares = {};\n"
+        "var points = [];\n"
+        "fun build() {\n"
+        "    var composite = [];\n"
+        "    for (var n = 0; n < 50000; n = n + 1) push(composite, false);\n"
+        "    for (var n = 2; n < 50000; n = n + 1) {\n"
+        "        if (!composite[n]) {\n"
+        "            push(primes, n);\n"
+        "            for (var m = n * n; m < 50000; m = m + n) {\n"
+        "                composite[m] = true;\n"
+        "            }\n"
+        "        }\n"
+        "    }\n"
+        "    for (var i = 0; i < 2000; i = i + 1) {\n"
+        "        squares[i] = i * i;\n"
+        "        push(points, Vec(i, -i));\n"
+        "    }\n"
+        "}\n"
+        "build();\n";
+    return source;
+}
+
+}  // namespace
+
+int main() {
+    lox::StringSink errors;
+    lox::Output out(errors);
+    lox::Metrics stats;
+    std::unique_ptr<lox::Program> prelude =
+        lox::Prepare(GenPrelude(300), out, stats);
+
+    std::ostringstream image;
+    {
+        lox::Interpreter interpreter;
+        interpreter.Out.SetSink(errors);
+        interpreter.Interpret(prelude->Statements, prelude->Locals);
+        lox::Snapshot::Write(interpreter, image);
+    }
+    lox::Snapshot snapshot(image.str());
+    if (!errors.Text.empty()) {
+        std::fputs(errors.Text.c_str(), stderr);
+        return 1;
+    }
+    std::printf("image: %zu bytes\n", std::size(image.str()));
+
+    double seconds = lox::bench::BestOf(3, [&] {
+        for (int i = 0; i < kStarts; ++i) {
+            lox::Interpreter interpreter;
+            interpreter.Out.SetSink(errors);
+            interpreter.Interpret(prelude->Statements, prelude->Locals);
+        }
+    });
+    lox::bench::Report("run prelude", seconds, kStarts, "starts");
+    seconds = lox::bench::BestOf(3, [&] {
+        for (int i = 0; i < kStarts; ++i) {
+            lox::Interpreter interpreter;
+            snapshot.Restore(interpreter);
+        }
+    });
+    lox::bench::Report("restore snapshot", seconds, kStarts, "starts");
+}
@@ -0,0 +1,98 @@
+// Push/pop throughput of the interpreter's ValueStack against the
+// std::stack over std::deque the tree walking interpreter used, for the
+// pattern calls produce: push a few arguments, read them, drop them.
+#include <stack>
+#include <string>
+
+#include "benchmark.h"
+#include "interpreter.h"
+#include "valueStack.h"
+
+namespace {
+
+using TOut = lox::Interpreter::TOut;
+
+constexpr int kCalls = 1 << 20;
+constexpr int kArguments = 4;
+
+// Arguments are mostly doubles, with a string now and then.
+TOut Argument(int call, int i) {
+    if ((call + i) % 8 == 0) {
+        return lox::LoxString("argument");
+    }
+    return static_cast<double>(call + i);
+}
+
+double Sum(const TOut& value) {
+    auto* d = std::get_if<double>(&value);
+    return d != nullptr ? *d : 1.0;
+}
+
+double RunDeque() {
+    std::stack<TOut> stack;
+    double sum = 0;
+    for (int call = 0; call < kCalls; ++call) {
+        for (int i = 0; i < kArguments; ++i) {
+            stack.push(Argument(call, i));
+        }
+        for (int i = 0; i < kArguments; ++i) {
+            // The tree walker copied the top before popping it.
+            TOut value = stack.top();
+            stack.pop();
+            sum += Sum(value);
+        }
+    }
+    return sum;
+}
+
+double RunValueStack() {
+    lox::ValueStack<TOut> stack(lox::Interpreter::kStackCapacity);
+    double sum = 0;
+    for (int call = 0; call < kCalls; ++call) {
+        for (int i = 0; i < kArguments; ++i) {
+            if (!stack.Push(Argument(call, i))) {
+                return -1;
+            }
+        }
+        for (int i = 0; i < kArguments; ++i) {
+            sum += Sum(stack.Pop());
+        }
+    }
+    return sum;
+}
+
+// What frames do: grow by a register window and use it in place.
+double RunValueStackWindows() {
+    lox::ValueStack<TOut> stack(lox::Interpreter::kStackCapacity);
+    double sum = 0;
+    for (int call = 0; call < kCalls; ++call) {
+        auto base = stack.size();
+        if (!stack.Grow(base + kArguments)) {
+            return -1;
+        }
+        TOut* regs = stack.data() + base;
+        for (int i = 0; i < kArguments; ++i) {
+            regs[i] = Argument(call, i);
+        }
+        for (int i = 0; i < kArguments; ++i) {
+            sum += Sum(regs[i]);
+        }
+        stack.Shrink(base);
+    }
+    return sum;
+}
+
+template <typename Fn>
+void Run(const std::string& name, Fn&& fn) {
+    volatile double sink = 0;
+    double seconds = lox::bench::BestOf(5, [&] { sink = fn(); });
+    lox::bench::Report(name, seconds, 2.0 * kCalls * kArguments, "push+pop");
+}
+
+}  // namespace
+
+int main() {
+    Run("std::stack<TOut> (deque)", RunDeque);
+    Run("ValueStack push/pop", RunValueStack);
+    Run("ValueStack register window", RunValueStackWindows);
+}
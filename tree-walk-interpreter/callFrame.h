@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include "chunk.h"
+#include "loxFunction.h"
+
+namespace lox {
+
+// A call the Interpreter is running, or a LoxCoroutine keeps suspended.
+struct CallFrame {
+    std::shared_ptr<Chunk> Code;
+    // Where the frame continues once the function it called returns.
+    const Instruction* Ip;
+    // The upvalues of the closure that was called, kept alive by the
+    // closure in the callee register right below the frame.
+    const LoxFunction::Cell* Upvalues;
+    // Index of the first register of the frame in the stack, and of its
+    // first cell in the cells of the interpreter.
+    std::size_t Base;
+    std::size_t Cells;
+    // The function, null for the script.
+    const FunctionProto* Proto = nullptr;
+};
+
+}  // namespace lox
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "constantPool.h"
+#include "symbolTable.h"
+#include "syntaxTree.h"
+
+namespace lox {
+
+class NativeCode;
+class Shape;
+
+// The opcodes as an X-macro, so the enum and the dispatch table of the
+// interpreter loop can't get out of sync. R[x] is register x of the current
+// frame, operands that aren't used are 0.
+#define LOX_OPCODES(X)                                                    \
+    X(MOVE)          /* R[A] = R[B] */                                    \
+    X(CONSTANT)      /* R[A] = Constants[B] */                            \
+    X(TRUE)          /* R[A] = true */                                    \
+    X(FALSE)         /* R[A] = false */                                   \
+    X(GET_CELL)      /* R[A] = value of cell B of the frame */            \
+    X(SET_CELL)      /* value of cell B of the frame = R[A] */            \
+    X(NEW_CELL)      /* cell B of the frame = new cell holding R[A] */    \
+    X(GET_UPVALUE)   /* R[A] = value of upvalue B of the closure */       \
+    X(SET_UPVALUE)   /* value of upvalue B of the closure = R[A] */       \
+    X(GET_GLOBAL)    /* R[A] = global B */                                \
+    X(SET_GLOBAL)    /* global B = R[A] */                                \
+    X(DEFINE_GLOBAL) /* define global B as R[A] */                        \
+    X(ADD)           /* R[A] = R[B] + R[C], and so on */                  \
+    X(SUBTRACT)                                                           \
+    X(MULTIPLY)                                                           \
+    X(DIVIDE)                                                             \
+    X(GREATER)                                                            \
+    X(GREATER_EQUAL)                                                      \
+    X(LESS)                                                               \
+    X(LESS_EQUAL)                                                         \
+    X(EQUAL)                                                              \
+    X(NOT_EQUAL)                                                          \
+    X(NOT)           /* R[A] = !R[B] */                                   \
+    X(NEGATE)        /* R[A] = -R[B] */                                   \
+    /* The same for operands type inference proved to be doubles. */      \
+    X(ADD_NUM)                                                            \
+    X(SUBTRACT_NUM)                                                       \
+    X(MULTIPLY_NUM)                                                       \
+    X(DIVIDE_NUM)                                                         \
+    X(GREATER_NUM)                                                        \
+    X(GREATER_EQUAL_NUM)                                                  \
+    X(LESS_NUM)                                                           \
+    X(LESS_EQUAL_NUM)                                                     \
+    X(EQUAL_NUM)                                                          \
+    X(NOT_EQUAL_NUM)                                                      \
+    X(NEGATE_NUM)                                                         \
+    X(PRINT)         /* print R[A] */                                     \
+    X(JUMP)          /* continue at B */                                  \
+    X(JUMP_IF_FALSE) /* continue at B if R[A] is falsy */                 \
+    X(JUMP_IF_TRUE)  /* continue at B if R[A] is truthy */                \
+    X(FUNCTION)      /* R[A] = closure of Functions[B] */                 \
+    X(CALL)          /* R[A] = R[A](R[A + 1], ..., R[A + B]) */           \
+    X(RETURN)        /* return R[A] */                                    \
+    X(YIELD)         /* suspend the coroutine, its resume returns R[A] */ \
+    X(CLASS)         /* R[A] = new class named B */                       \
+    X(INHERIT)       /* class R[A] inherits from R[B] */                  \
+    X(METHOD)        /* method C of class R[A] = R[B] */                  \
+    /* Property accesses name Caches[C], their inline cache. */           \
+    X(GET_PROPERTY)  /* R[A] = R[B].name */                               \
+    X(SET_PROPERTY)  /* R[A].name = R[B] */                               \
+    X(INVOKE)        /* R[A] = R[A].name(R[A + 1], ..., R[A + B]) */      \
+    X(GET_SUPER)     /* R[A] = method C of class R[B] bound to R[B + 1] */ \
+    X(LIST)          /* R[A] = [R[B], ..., R[B + C - 1]] */               \
+    X(MAP)           /* R[A] = {R[B]: R[B + 1], ...} with C entries */    \
+    X(GET_INDEX)     /* R[A] = R[B][R[C]] */                              \
+    X(SET_INDEX)     /* R[A][R[B]] = R[C] */
+
+enum class OpCode : std::uint8_t {
+#define LOX_OPCODE_ENUM(name) name,
+    LOX_OPCODES(LOX_OPCODE_ENUM)
+#undef LOX_OPCODE_ENUM
+};
+
+struct Instruction {
+    OpCode Op;
+    std::uint16_t A;
+    std::uint32_t B;
+    std::uint32_t C;
+};
+
+// Where a closure gets an upvalue from when it is created: a cell of the
+// call creating it, or an upvalue of the function that call runs.
+struct Capture {
+    bool FromCell;
+    std::uint32_t Index;
+
+    bool operator==(const Capture& other) const {
+        return FromCell == other.FromCell && Index == other.Index;
+    }
+};
+
+// Inline cache of a property access: where the property was found on the
+// last instance it was used on, which holds for all instances of the same
+// Key shape.
+struct PropertyCache {
+    Symbol Name;
+    std::shared_ptr<const Shape> Key;
+    // A field, and for a store that added it, the shape it moved to.
+    std::uint32_t Slot = 0;
+    std::shared_ptr<Shape> Next;
+    // Or a method of the class.
+    std::optional<LoxFunction> Method;
+};
+
+// Compiled code of a function, or of the top level statements of a script.
+struct Chunk {
+    std::vector<Instruction> Code;
+    std::vector<std::uint32_t> Lines;  // Source line of each instruction.
+    // Shared by all chunks of the program, CONSTANT indexes it.
+    std::shared_ptr<ConstantPool> Constants;
+    std::vector<std::shared_ptr<const FunctionProto>> Functions;
+    // Size of the register window of a call, the arguments are passed in
+    // the first registers.
+    std::uint32_t MaxRegisters = 0;
+    // Locals that closures capture live in heap cells, so they survive the
+    // call. A call has NumCells of them, a closure of this function gets
+    // the Captures as its upvalues.
+    std::uint32_t NumCells = 0;
+    std::vector<Capture> Captures;
+    std::vector<PropertyCache> Caches;
+
+    // Tiering, see Jit. Hotness counts calls and loop iterations.
+    std::uint32_t Hotness = 0;
+    std::uint32_t Deopts = 0;
+    bool JitFailed = false;
+    std::shared_ptr<NativeCode> Native;
+
+    std::size_t Emit(OpCode op, std::uint32_t line, std::uint16_t a = 0,
+                     std::uint32_t b = 0, std::uint32_t c = 0) {
+        Code.push_back(Instruction{op, a, b, c});
+        Lines.push_back(line);
+        return std::size(Code) - 1;
+    }
+
+    std::uint32_t Line(const Instruction* ip) const {
+        return Lines[ip - Code.data()];
+    }
+};
+
+// What all closures of a function declaration share, created once when the
+// declaration is compiled.
+struct FunctionProto {
+    Token Name;
+    std::uint32_t Arity;
+    std::shared_ptr<Chunk> Code;
+    // Methods get the instance in their first register, in place of the
+    // callee, and return into it.
+    bool Method = false;
+};
+
+}  // namespace lox
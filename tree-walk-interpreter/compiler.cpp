@@ -0,0 +1,738 @@
+#include "compiler.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "lox.h"
+
+namespace lox {
+
+namespace {
+
+// Finds assignments in an expression.
+class AssignmentFinder final : public ExpressionVisitor {
+   public:
+    bool Found = false;
+
+    void Find(Expression& e) { e.Accept(*this); }
+
+    virtual void Visit(Literal&) override {}
+    virtual void Visit(BinaryExpr& b) override {
+        Find(*b.Left);
+        Find(*b.Right);
+    }
+    virtual void Visit(UnaryExpr& u) override { Find(*u.Expr); }
+    virtual void Visit(Grouping& g) override { Find(*g.Expr); }
+    virtual void Visit(Variable&) override {}
+    virtual void Visit(Assignment&) override { Found = true; }
+    virtual void Visit(Logical& lg) override {
+        Find(*lg.Left);
+        Find(*lg.Right);
+    }
+    virtual void Visit(Call& c) override {
+        Find(*c.Callee);
+        for (auto& a : c.Arguments) {
+            Find(*a);
+        }
+    }
+    virtual void Visit(Get& g) override { Find(*g.Object); }
+    // Fields aren't kept in registers, only the operands are of interest.
+    virtual void Visit(Set& s) override {
+        Find(*s.Object);
+        Find(*s.Value);
+    }
+    virtual void Visit(Super&) override {}
+    virtual void Visit(ListLiteral& l) override {
+        for (auto& e : l.Elements) {
+            Find(*e);
+        }
+    }
+    virtual void Visit(MapLiteral& m) override {
+        for (std::size_t i = 0; i < std::size(m.Keys); ++i) {
+            Find(*m.Keys[i]);
+            Find(*m.Values[i]);
+        }
+    }
+    virtual void Visit(Subscript& s) override {
+        Find(*s.Object);
+        Find(*s.Key);
+    }
+    virtual void Visit(SetSubscript& s) override {
+        Find(*s.Object);
+        Find(*s.Key);
+        Find(*s.Value);
+    }
+};
+
+bool HasAssignment(Expression& e) {
+    AssignmentFinder finder;
+    finder.Find(e);
+    return finder.Found;
+}
+
+// The opcode for operands known to be doubles.
+OpCode Numeric(OpCode op) {
+    switch (op) {
+        case OpCode::ADD:
+            return OpCode::ADD_NUM;
+        case OpCode::SUBTRACT:
+            return OpCode::SUBTRACT_NUM;
+        case OpCode::MULTIPLY:
+            return OpCode::MULTIPLY_NUM;
+        case OpCode::DIVIDE:
+            return OpCode::DIVIDE_NUM;
+        case OpCode::GREATER:
+            return OpCode::GREATER_NUM;
+        case OpCode::GREATER_EQUAL:
+            return OpCode::GREATER_EQUAL_NUM;
+        case OpCode::LESS:
+            return OpCode::LESS_NUM;
+        case OpCode::LESS_EQUAL:
+            return OpCode::LESS_EQUAL_NUM;
+        case OpCode::EQUAL:
+            return OpCode::EQUAL_NUM;
+        case OpCode::NOT_EQUAL:
+            return OpCode::NOT_EQUAL_NUM;
+        case OpCode::NEGATE:
+            return OpCode::NEGATE_NUM;
+        default:
+            return op;
+    }
+}
+
+bool IsNumber(const Expression& e) { return e.Type == StaticType::NUMBER; }
+
+}  // namespace
+
+std::shared_ptr<Chunk> Compiler::Compile(
+    const std::vector<std::unique_ptr<Statement>>& statements) {
+    chunk_ = std::make_shared<Chunk>();
+    chunk_->Constants = constants_;
+    functions_.push_back(Function{0, chunk_.get(), FunctionKind::FUNCTION});
+    try {
+        for (auto& s : statements) {
+            Compile(*s);
+        }
+        auto result = AllocRegister();
+        Emit(OpCode::FALSE, result);
+        Emit(OpCode::RETURN, result);
+    } catch (CompileError&) {
+        return nullptr;
+    }
+    functions_.pop_back();
+    return std::move(chunk_);
+}
+
+void Compiler::Compile(FunctionDeclaration& fun) {
+    auto enclosing = std::move(chunk_);
+    auto enclosing_line = line_;
+    auto enclosing_locals_top = locals_top_;
+    auto enclosing_next_register = next_register_;
+
+    chunk_ = std::make_shared<Chunk>();
+    chunk_->Constants = constants_;
+    functions_.push_back(
+        Function{std::size(scopes_), chunk_.get(), fun.Kind});
+    locals_top_ = 0;
+    next_register_ = 0;
+
+    // The parameters and the body share a scope. The arguments arrive in
+    // the first registers, after this for methods, captured ones move into
+    // a cell.
+    bool method = fun.Kind != FunctionKind::FUNCTION;
+    std::vector<Token> params;
+    if (method) {
+        params.push_back(ThisToken(fun.Name.Line));
+    }
+    params.insert(params.end(), fun.Params.begin(), fun.Params.end());
+    scopes_.push_back(Scope{0, {}});
+    for (std::size_t i = 0; i < std::size(params); ++i) {
+        AllocRegister();
+    }
+    locals_top_ = next_register_;
+    for (std::size_t i = 0; i < std::size(params); ++i) {
+        bool captured =
+            i < std::size(fun.CapturedParams) && fun.CapturedParams[i];
+        DeclareLocal(params[i], static_cast<Reg>(i), captured);
+    }
+    for (auto& s : fun.Body) {
+        Compile(*s);
+    }
+    // Falling of the end of a function returns nil, of an initializer this.
+    if (fun.Kind == FunctionKind::INITIALIZER) {
+        ReturnThis();
+    } else {
+        auto result = AllocRegister();
+        Emit(OpCode::CONSTANT, result, AddConstant(std::monostate()));
+        Emit(OpCode::RETURN, result);
+    }
+    scopes_.pop_back();
+    functions_.pop_back();
+    protos_[&fun] = std::make_shared<FunctionProto>(FunctionProto{
+        fun.Name, static_cast<std::uint32_t>(std::size(fun.Params)),
+        std::move(chunk_), method});
+
+    chunk_ = std::move(enclosing);
+    line_ = enclosing_line;
+    locals_top_ = enclosing_locals_top;
+    next_register_ = enclosing_next_register;
+}
+
+void Compiler::CompileTo(Expression& e, Reg dst) {
+    auto mark = next_register_;
+    auto enclosing_dst = dst_;
+    dst_ = dst;
+    e.Accept(*this);
+    dst_ = enclosing_dst;
+    next_register_ = mark;
+}
+
+Compiler::Reg Compiler::Operand(Expression& e) {
+    if (auto* var = dynamic_cast<Variable*>(&e)) {
+        auto location = Lookup(var, var->Name);
+        if (location.Where == Location::Kind::REGISTER) {
+            return static_cast<Reg>(location.Index);
+        }
+    }
+
+    auto temp = AllocRegister();
+    CompileTo(e, temp);
+    return temp;
+}
+
+Compiler::Reg Compiler::AllocRegister() {
+    if (next_register_ == kDiscard) {
+        lox::Error(line_, "Too many local variables/temporaries in function.");
+        throw CompileError{};
+    }
+    auto reg = next_register_++;
+    chunk_->MaxRegisters = std::max<std::uint32_t>(chunk_->MaxRegisters,
+                                                   next_register_);
+    return reg;
+}
+
+void Compiler::BeginScope() { scopes_.push_back(Scope{locals_top_, {}}); }
+
+void Compiler::EndScope() {
+    locals_top_ = scopes_.back().Base;
+    next_register_ = locals_top_;
+    scopes_.pop_back();
+}
+
+void Compiler::DeclareLocal(const Token& name, Reg value, bool captured) {
+    line_ = name.Line;
+    if (std::empty(scopes_)) {
+        Emit(OpCode::DEFINE_GLOBAL, value, name.Value);
+        return;
+    }
+
+    if (captured) {
+        // Every time the declaration runs it gets a new cell, so closures
+        // created in different loop iterations don't share it.
+        auto cell = chunk_->NumCells++;
+        Emit(OpCode::NEW_CELL, value, cell);
+        scopes_.back().Locals.insert_or_assign(name.Value, Local{true, cell});
+        return;
+    }
+
+    // The value was computed in the first free register, which now becomes
+    // the variable.
+    scopes_.back().Locals.insert_or_assign(name.Value, Local{false, value});
+    locals_top_ = value + 1;
+    next_register_ = locals_top_;
+}
+
+std::uint32_t Compiler::Upvalue(std::size_t function, std::size_t scope,
+                                const Local& local) {
+    assert(local.InCell);
+    // Closures get the cells of their direct parent, from further out they
+    // take them over from the upvalues of the parent.
+    Capture capture =
+        scope >= functions_[function - 1].FirstScope
+            ? Capture{true, local.Index}
+            : Capture{false, Upvalue(function - 1, scope, local)};
+
+    auto& captures = functions_[function].Code->Captures;
+    auto found = std::find(captures.begin(), captures.end(), capture);
+    if (found != captures.end()) {
+        return static_cast<std::uint32_t>(found - captures.begin());
+    }
+    captures.push_back(capture);
+    return static_cast<std::uint32_t>(std::size(captures) - 1);
+}
+
+void Compiler::PatchJump(std::size_t jump) {
+    chunk_->Code[jump].B = static_cast<std::uint32_t>(std::size(chunk_->Code));
+}
+
+std::uint32_t Compiler::AddConstant(const Literal::ValueType& value) {
+    return constants_->Add(value);
+}
+
+std::uint32_t Compiler::AddCache(Symbol name) {
+    chunk_->Caches.push_back(PropertyCache{name});
+    return static_cast<std::uint32_t>(std::size(chunk_->Caches) - 1);
+}
+
+void Compiler::ReturnThis() {
+    // this is the first local of the method, though captured it lives in a
+    // cell.
+    const auto& self = scopes_[functions_.back().FirstScope].Locals.at(
+        ThisToken(0).Value);
+    if (!self.InCell) {
+        Emit(OpCode::RETURN, static_cast<Reg>(self.Index));
+        return;
+    }
+    auto value = AllocRegister();
+    Emit(OpCode::GET_CELL, value, self.Index);
+    Emit(OpCode::RETURN, value);
+}
+
+Compiler::Location Compiler::Lookup(Expression* expr, const Token& name) {
+    auto distance = locals_.find(expr);
+    if (distance == locals_.end()) {
+        return {Location::Kind::GLOBAL, name.Value};
+    }
+
+    auto declared_in = std::size(scopes_) - 1 - distance->second;
+    const auto& local = scopes_[declared_in].Locals.at(name.Value);
+    auto function = std::size(functions_) - 1;
+    if (declared_in < functions_[function].FirstScope) {
+        return {Location::Kind::UPVALUE, Upvalue(function, declared_in, local)};
+    }
+    return {local.InCell ? Location::Kind::CELL : Location::Kind::REGISTER,
+            local.Index};
+}
+
+void Compiler::Visit(Literal& l) {
+    if (auto* b = std::get_if<bool>(&l.Value)) {
+        Emit(*b ? OpCode::TRUE : OpCode::FALSE, dst_);
+        return;
+    }
+    Emit(OpCode::CONSTANT, dst_, AddConstant(l.Value));
+}
+
+void Compiler::Visit(BinaryExpr& b) {
+    // A local used in place would see an assignment in the right operand,
+    // which happens after the left operand is evaluated.
+    Reg left;
+    if (HasAssignment(*b.Right)) {
+        left = AllocRegister();
+        CompileTo(*b.Left, left);
+    } else {
+        left = Operand(*b.Left);
+    }
+    Reg right = Operand(*b.Right);
+
+    line_ = b.Tok.Line;
+    OpCode op = OpCode::ADD;
+    switch (b.Tok.Type) {
+        case TokenType::PLUS:
+            op = OpCode::ADD;
+            break;
+        case TokenType::MINUS:
+            op = OpCode::SUBTRACT;
+            break;
+        case TokenType::STAR:
+            op = OpCode::MULTIPLY;
+            break;
+        case TokenType::SLASH:
+            op = OpCode::DIVIDE;
+            break;
+        case TokenType::GREATER:
+            op = OpCode::GREATER;
+            break;
+        case TokenType::GREATER_EQUAL:
+            op = OpCode::GREATER_EQUAL;
+            break;
+        case TokenType::LESS:
+            op = OpCode::LESS;
+            break;
+        case TokenType::LESS_EQUAL:
+            op = OpCode::LESS_EQUAL;
+            break;
+        case TokenType::EQUAL_EQUAL:
+            op = OpCode::EQUAL;
+            break;
+        case TokenType::BANG_EQUAL:
+            op = OpCode::NOT_EQUAL;
+            break;
+        default:
+            break;
+    }
+    if (IsNumber(*b.Left) && IsNumber(*b.Right)) {
+        op = Numeric(op);
+    }
+    Emit(op, dst_, left, right);
+}
+
+void Compiler::Visit(UnaryExpr& u) {
+    Reg operand = Operand(*u.Expr);
+
+    line_ = u.Op.Line;
+    OpCode op = OpCode::NOT;
+    if (u.Op.Type == TokenType::MINUS) {
+        op = IsNumber(*u.Expr) ? OpCode::NEGATE_NUM : OpCode::NEGATE;
+    }
+    Emit(op, dst_, operand);
+}
+
+void Compiler::Visit(Grouping& g) { CompileTo(*g.Expr, dst_); }
+
+void Compiler::Visit(Variable& v) {
+    auto location = Lookup(&v, v.Name);
+    line_ = v.Name.Line;
+    switch (location.Where) {
+        case Location::Kind::REGISTER:
+            if (location.Index != dst_) {
+                Emit(OpCode::MOVE, dst_, location.Index);
+            }
+            break;
+        case Location::Kind::CELL:
+            Emit(OpCode::GET_CELL, dst_, location.Index);
+            break;
+        case Location::Kind::UPVALUE:
+            Emit(OpCode::GET_UPVALUE, dst_, location.Index);
+            break;
+        case Location::Kind::GLOBAL:
+            Emit(OpCode::GET_GLOBAL, dst_, v.Name.Value);
+            break;
+    }
+}
+
+void Compiler::Visit(Assignment& a) {
+    auto location = Lookup(&a, a.Name);
+    if (location.Where == Location::Kind::REGISTER) {
+        // Evaluate straight into the variable, so "a = b + c" is one
+        // instruction.
+        auto reg = static_cast<Reg>(location.Index);
+        CompileTo(*a.Expr, reg);
+        if (dst_ != kDiscard && dst_ != reg) {
+            Emit(OpCode::MOVE, dst_, reg);
+        }
+        return;
+    }
+
+    Reg value = dst_ != kDiscard ? dst_ : AllocRegister();
+    CompileTo(*a.Expr, value);
+    line_ = a.Name.Line;
+    switch (location.Where) {
+        case Location::Kind::CELL:
+            Emit(OpCode::SET_CELL, value, location.Index);
+            break;
+        case Location::Kind::UPVALUE:
+            Emit(OpCode::SET_UPVALUE, value, location.Index);
+            break;
+        default:
+            Emit(OpCode::SET_GLOBAL, value, a.Name.Value);
+            break;
+    }
+}
+
+void Compiler::Visit(Logical& lg) {
+    // The result is written before the right operand is evaluated, so don't
+    // write it into a variable the right operand might read.
+    Reg result = (dst_ == kDiscard || dst_ < locals_top_) ? AllocRegister()
+                                                          : dst_;
+    CompileTo(*lg.Left, result);
+
+    line_ = lg.Op.Line;
+    // The left operand is the result if it decides the outcome.
+    auto end_jump = Emit(lg.Op.Type == TokenType::OR ? OpCode::JUMP_IF_TRUE
+                                                     : OpCode::JUMP_IF_FALSE,
+                         result);
+    CompileTo(*lg.Right, result);
+    PatchJump(end_jump);
+
+    if (dst_ != kDiscard && dst_ != result) {
+        Emit(OpCode::MOVE, dst_, result);
+    }
+}
+
+void Compiler::Visit(Call& c) {
+    // The callee and the arguments go in consecutive registers, which become
+    // the first registers of the called function. A method called right
+    // away gets the instance in place of the callee, without creating a
+    // bound method.
+    auto* method = dynamic_cast<Get*>(c.Callee.get());
+    Reg base = AllocRegister();
+    CompileTo(method != nullptr ? *method->Object : *c.Callee, base);
+    for (auto& a : c.Arguments) {
+        CompileTo(*a, AllocRegister());
+    }
+
+    line_ = c.Paren.Line;
+    auto arg_count = static_cast<std::uint32_t>(std::size(c.Arguments));
+    if (method != nullptr) {
+        Emit(OpCode::INVOKE, base, arg_count, AddCache(method->Name.Value));
+    } else {
+        Emit(OpCode::CALL, base, arg_count);
+    }
+    if (dst_ != kDiscard && dst_ != base) {
+        Emit(OpCode::MOVE, dst_, base);
+    }
+}
+
+void Compiler::Visit(Get& g) {
+    Reg object = Operand(*g.Object);
+    line_ = g.Name.Line;
+    Emit(OpCode::GET_PROPERTY, dst_, object, AddCache(g.Name.Value));
+}
+
+void Compiler::Visit(Set& s) {
+    Reg object;
+    if (HasAssignment(*s.Value)) {
+        object = AllocRegister();
+        CompileTo(*s.Object, object);
+    } else {
+        object = Operand(*s.Object);
+    }
+    // Don't overwrite a variable the object might be in.
+    Reg value = (dst_ == kDiscard || dst_ < locals_top_) ? AllocRegister()
+                                                         : dst_;
+    CompileTo(*s.Value, value);
+
+    line_ = s.Name.Line;
+    Emit(OpCode::SET_PROPERTY, object, value, AddCache(s.Name.Value));
+    if (dst_ != kDiscard && dst_ != value) {
+        Emit(OpCode::MOVE, dst_, value);
+    }
+}
+
+void Compiler::Visit(Super& s) {
+    // The superclass, with this in the register after it.
+    Reg superclass = AllocRegister();
+    CompileTo(*s.Superclass, superclass);
+    CompileTo(*s.This, AllocRegister());
+
+    line_ = s.Method.Line;
+    Emit(OpCode::GET_SUPER, dst_, superclass, s.Method.Value);
+}
+
+void Compiler::Visit(ListLiteral& l) {
+    // The elements go in consecutive registers.
+    Reg first = next_register_;
+    for (auto& e : l.Elements) {
+        CompileTo(*e, AllocRegister());
+    }
+    line_ = l.Bracket.Line;
+    Emit(OpCode::LIST, dst_, first,
+         static_cast<std::uint32_t>(std::size(l.Elements)));
+}
+
+void Compiler::Visit(MapLiteral& m) {
+    // Each key with its value after it, in consecutive registers.
+    Reg first = next_register_;
+    for (std::size_t i = 0; i < std::size(m.Keys); ++i) {
+        CompileTo(*m.Keys[i], AllocRegister());
+        CompileTo(*m.Values[i], AllocRegister());
+    }
+    line_ = m.Brace.Line;
+    Emit(OpCode::MAP, dst_, first,
+         static_cast<std::uint32_t>(std::size(m.Keys)));
+}
+
+void Compiler::Visit(Subscript& s) {
+    Reg object;
+    if (HasAssignment(*s.Key)) {
+        object = AllocRegister();
+        CompileTo(*s.Object, object);
+    } else {
+        object = Operand(*s.Object);
+    }
+    Reg key = Operand(*s.Key);
+
+    line_ = s.Bracket.Line;
+    Emit(OpCode::GET_INDEX, dst_, object, key);
+}
+
+void Compiler::Visit(SetSubscript& s) {
+    Reg object;
+    if (HasAssignment(*s.Key) || HasAssignment(*s.Value)) {
+        object = AllocRegister();
+        CompileTo(*s.Object, object);
+    } else {
+        object = Operand(*s.Object);
+    }
+    Reg key;
+    if (HasAssignment(*s.Value)) {
+        key = AllocRegister();
+        CompileTo(*s.Key, key);
+    } else {
+        key = Operand(*s.Key);
+    }
+    // Don't overwrite a variable the object or key might be in.
+    Reg value = (dst_ == kDiscard || dst_ < locals_top_) ? AllocRegister()
+                                                         : dst_;
+    CompileTo(*s.Value, value);
+
+    line_ = s.Bracket.Line;
+    Emit(OpCode::SET_INDEX, object, key, value);
+    if (dst_ != kDiscard && dst_ != value) {
+        Emit(OpCode::MOVE, dst_, value);
+    }
+}
+
+void Compiler::Visit(PrintStatement& p) {
+    Reg value = Operand(*p.Expr);
+    Emit(OpCode::PRINT, value);
+    next_register_ = locals_top_;
+}
+
+void Compiler::Visit(ExpressionStatement& e) {
+    bool discard = dynamic_cast<Assignment*>(e.Expr.get()) != nullptr ||
+                   dynamic_cast<Call*>(e.Expr.get()) != nullptr ||
+                   dynamic_cast<Set*>(e.Expr.get()) != nullptr ||
+                   dynamic_cast<SetSubscript*>(e.Expr.get()) != nullptr;
+    CompileTo(*e.Expr, discard ? kDiscard : AllocRegister());
+    next_register_ = locals_top_;
+}
+
+void Compiler::Visit(VariableDeclaration& vdecl) {
+    Reg value = AllocRegister();
+    if (vdecl.Initializer != nullptr) {
+        CompileTo(*vdecl.Initializer, value);
+    } else {
+        Emit(OpCode::FALSE, value);
+    }
+
+    DeclareLocal(vdecl.Name, value, vdecl.Captured);
+    next_register_ = locals_top_;
+}
+
+void Compiler::Visit(Block& blk) {
+    BeginScope();
+    for (auto& s : blk.Statements) {
+        Compile(*s);
+    }
+    EndScope();
+}
+
+void Compiler::Visit(IfStatement& i) {
+    Reg condition = Operand(*i.Condition);
+    auto else_jump = Emit(OpCode::JUMP_IF_FALSE, condition);
+    next_register_ = locals_top_;
+
+    Compile(*i.ThenBranch);
+    if (i.ElseBranch == nullptr) {
+        PatchJump(else_jump);
+        return;
+    }
+
+    auto end_jump = Emit(OpCode::JUMP);
+    PatchJump(else_jump);
+    Compile(*i.ElseBranch);
+    PatchJump(end_jump);
+}
+
+void Compiler::Visit(While& w) {
+    auto loop_start = static_cast<std::uint32_t>(std::size(chunk_->Code));
+    Reg condition = Operand(*w.Condition);
+    auto exit_jump = Emit(OpCode::JUMP_IF_FALSE, condition);
+    next_register_ = locals_top_;
+
+    Compile(*w.Body);
+    Emit(OpCode::JUMP, 0, loop_start);
+    PatchJump(exit_jump);
+}
+
+void Compiler::Visit(FunctionDeclaration& f) {
+    // A function that refers to itself captures its own cell, which has to
+    // exist before the closure is created.
+    bool in_cell = f.Captured && !std::empty(scopes_);
+    std::uint32_t cell = 0;
+    if (in_cell) {
+        cell = chunk_->NumCells++;
+        scopes_.back().Locals.insert_or_assign(f.Name.Value,
+                                               Local{true, cell});
+    }
+    if (protos_.count(&f) == 0) {
+        Compile(f);
+    }
+
+    line_ = f.Name.Line;
+    chunk_->Functions.push_back(protos_[&f]);
+    Reg value = AllocRegister();
+    if (in_cell) {
+        Emit(OpCode::FALSE, value);
+        Emit(OpCode::NEW_CELL, value, cell);
+    }
+    Emit(OpCode::FUNCTION, value,
+         static_cast<std::uint32_t>(std::size(chunk_->Functions) - 1));
+    if (in_cell) {
+        Emit(OpCode::SET_CELL, value, cell);
+    } else {
+        DeclareLocal(f.Name, value, false);
+    }
+    next_register_ = locals_top_;
+}
+
+void Compiler::Visit(ReturnStatement& r) {
+    line_ = r.Keyword.Line;
+    if (functions_.back().Kind == FunctionKind::INITIALIZER) {
+        ReturnThis();
+        next_register_ = locals_top_;
+        return;
+    }
+
+    Reg value;
+    if (r.Value != nullptr) {
+        value = Operand(*r.Value);
+    } else {
+        value = AllocRegister();
+        Emit(OpCode::FALSE, value);
+    }
+    Emit(OpCode::RETURN, value);
+    next_register_ = locals_top_;
+}
+
+void Compiler::Visit(YieldStatement& y) {
+    line_ = y.Keyword.Line;
+    Reg value;
+    if (y.Value != nullptr) {
+        value = Operand(*y.Value);
+    } else {
+        value = AllocRegister();
+        Emit(OpCode::FALSE, value);
+    }
+    Emit(OpCode::YIELD, value);
+    next_register_ = locals_top_;
+}
+
+void Compiler::Visit(ClassDeclaration& c) {
+    // The class is declared before its methods are created, so they can
+    // refer to it.
+    line_ = c.Name.Line;
+    Reg klass = AllocRegister();
+    Emit(OpCode::CLASS, klass, c.Name.Value);
+    DeclareLocal(c.Name, klass, c.Captured);
+
+    if (c.Superclass != nullptr) {
+        BeginScope();
+        Reg superclass = AllocRegister();
+        CompileTo(*c.Superclass, superclass);
+        line_ = c.Superclass->Name.Line;
+        Emit(OpCode::INHERIT, klass, superclass);
+        DeclareLocal(SuperToken(c.Name.Line), superclass, c.SuperCaptured);
+    }
+
+    for (auto& method : c.Methods) {
+        if (protos_.count(method.get()) == 0) {
+            Compile(*method);
+        }
+        line_ = method->Name.Line;
+        chunk_->Functions.push_back(protos_[method.get()]);
+        Reg closure = AllocRegister();
+        Emit(OpCode::FUNCTION, closure,
+             static_cast<std::uint32_t>(std::size(chunk_->Functions) - 1));
+        Emit(OpCode::METHOD, klass, closure, method->Name.Value);
+        next_register_ = closure;
+    }
+
+    if (c.Superclass != nullptr) {
+        EndScope();
+    }
+    next_register_ = locals_top_;
+}
+
+}  // namespace lox
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "chunk.h"
+#include "symbolTable.h"
+#include "syntaxTree.h"
+
+namespace lox {
+
+// Translates resolved statements to register bytecode.
+//
+// Every call gets a window of registers. The arguments arrive in the first
+// ones, then come the local variables, and the temporaries of the
+// expression being evaluated sit on top. Locals stay in registers and
+// instructions use them directly, unless the resolver found that a nested
+// function captures them. Those live in heap cells, which the closure
+// shares as its upvalues. Globals live in the global environment. Methods
+// have this as a hidden first parameter.
+class Compiler : ExpressionVisitor, StatementVisitor {
+   public:
+    using Reg = std::uint16_t;
+
+   private:
+    // Destination of an expression whose value is not used.
+    static constexpr Reg kDiscard = 0xFFFF;
+    // Thrown to stop compiling once an error is reported.
+    struct CompileError {};
+
+    struct Local {
+        bool InCell;
+        std::uint32_t Index;  // The register, or the cell.
+    };
+    struct Scope {
+        Reg Base;  // locals_top_ when the scope was entered.
+        std::unordered_map<Symbol, Local> Locals;
+    };
+    // A function being compiled, the script is the outermost one.
+    struct Function {
+        std::size_t FirstScope;
+        Chunk* Code;
+        FunctionKind Kind;
+    };
+
+    const std::map<Expression*, int>& locals_;
+    std::shared_ptr<ConstantPool> constants_;
+    std::shared_ptr<Chunk> chunk_;
+    std::uint32_t line_ = 0;  // Line of the last token seen.
+
+    std::vector<Scope> scopes_;
+    // The function being compiled and the ones it is nested in.
+    std::vector<Function> functions_;
+    // Registers below locals_top_ hold named variables, next_register_ is
+    // the first free one.
+    Reg locals_top_ = 0;
+    Reg next_register_ = 0;
+    // Register the visited expression should leave its value in.
+    Reg dst_ = kDiscard;
+    // The compiled functions, each declaration is compiled once.
+    std::unordered_map<const FunctionDeclaration*,
+                       std::shared_ptr<FunctionProto>>
+        protos_;
+
+   public:
+    Compiler(const std::map<Expression*, int>& locals,
+             std::shared_ptr<ConstantPool> constants)
+        : locals_(locals), constants_(std::move(constants)) {}
+
+    // Only reads the statements, so several compilers can compile the same
+    // ones at once. Their expression types must be inferred already, which
+    // the Optimizer does. Return null after reporting a compile error, such
+    // as a function that needs more registers than there are.
+    std::shared_ptr<Chunk> Compile(
+        const std::vector<std::unique_ptr<Statement>>& statements);
+
+   private:
+    void Compile(FunctionDeclaration& fun);
+    void Compile(Statement& s) { s.Accept(*this); }
+
+    // Evaluate e into dst, temporaries it needs are released afterwards.
+    void CompileTo(Expression& e, Reg dst);
+    // Return a register holding the value of e: the register of a local
+    // variable, or a fresh temporary.
+    Reg Operand(Expression& e);
+    // Report a compile error once the registers run out.
+    Reg AllocRegister();
+
+    void BeginScope();
+    void EndScope();
+    // Make the value of a declaration, computed in the first free register,
+    // a variable of the innermost scope.
+    void DeclareLocal(const Token& name, Reg value, bool captured);
+    // Return the upvalue of function for a local of an enclosing function,
+    // declared in scope. Closures of every function in between capture it.
+    std::uint32_t Upvalue(std::size_t function, std::size_t scope,
+                          const Local& local);
+
+    std::size_t Emit(OpCode op, Reg a = 0, std::uint32_t b = 0,
+                     std::uint32_t c = 0) {
+        return chunk_->Emit(op, line_, a, b, c);
+    }
+    void PatchJump(std::size_t jump);
+    std::uint32_t AddConstant(const Literal::ValueType& value);
+    // Return this from the method being compiled.
+    void ReturnThis();
+    // Return the index of a new inline cache for an access to property name.
+    std::uint32_t AddCache(Symbol name);
+
+    struct Location {
+        enum class Kind { REGISTER, CELL, UPVALUE, GLOBAL } Where;
+        std::uint32_t Index;  // Register, cell, upvalue or global symbol.
+    };
+    Location Lookup(Expression* expr, const Token& name);
+
+    virtual void Visit(Literal&) override;
+    virtual void Visit(BinaryExpr&) override;
+    virtual void Visit(UnaryExpr&) override;
+    virtual void Visit(Grouping&) override;
+    virtual void Visit(Variable&) override;
+    virtual void Visit(Assignment&) override;
+    virtual void Visit(Logical&) override;
+    virtual void Visit(Call&) override;
+    virtual void Visit(Get&) override;
+    virtual void Visit(Set&) override;
+    virtual void Visit(Super&) override;
+    virtual void Visit(ListLiteral&) override;
+    virtual void Visit(MapLiteral&) override;
+    virtual void Visit(Subscript&) override;
+    virtual void Visit(SetSubscript&) override;
+    virtual void Visit(PrintStatement&) override;
+    virtual void Visit(ExpressionStatement&) override;
+    virtual void Visit(VariableDeclaration& vdecl) override;
+    virtual void Visit(Block& blk) override;
+    virtual void Visit(IfStatement&) override;
+    virtual void Visit(While&) override;
+    virtual void Visit(FunctionDeclaration&) override;
+    virtual void Visit(ReturnStatement&) override;
+    virtual void Visit(YieldStatement&) override;
+    virtual void Visit(ClassDeclaration&) override;
+};
+
+}  // namespace lox
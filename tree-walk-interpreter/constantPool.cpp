@@ -0,0 +1,33 @@
+#include "constantPool.h"
+
+#include <cstring>
+
+namespace lox {
+
+std::uint32_t ConstantPool::Add(const Literal::ValueType& literal) {
+    auto index = static_cast<std::uint32_t>(std::size(values_));
+    if (auto* d = std::get_if<double>(&literal)) {
+        std::uint64_t bits;
+        std::memcpy(&bits, d, sizeof(bits));
+        auto [entry, added] = numbers_.try_emplace(bits, index);
+        if (added) {
+            values_.push_back(*d);
+        }
+        return entry->second;
+    }
+    if (auto* b = std::get_if<bool>(&literal)) {
+        values_.push_back(*b);
+        return index;
+    }
+
+    // Nil is the string "Nil".
+    auto* s = std::get_if<std::string>(&literal);
+    const std::string& chars = s != nullptr ? *s : "Nil";
+    auto [entry, added] = strings_.try_emplace(chars, index);
+    if (added) {
+        values_.push_back(LoxString(chars));
+    }
+    return entry->second;
+}
+
+}  // namespace lox
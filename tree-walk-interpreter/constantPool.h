@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "loxFunction.h"
+#include "syntaxTree.h"
+
+namespace lox {
+
+// The constants of all chunks of a program, stored once as ready to use
+// values. Every distinct literal is added once, so a string constant is
+// one shared LoxString however often it occurs or is evaluated.
+class ConstantPool {
+   public:
+    using TOut = LoxFunction::TOut;
+
+   private:
+    std::vector<TOut> values_;
+    // Doubles by bit pattern, so 0 and -0 stay apart.
+    std::unordered_map<std::uint64_t, std::uint32_t> numbers_;
+    std::unordered_map<std::string, std::uint32_t> strings_;
+
+   public:
+    // Return the index of the value of literal, adding it if it's new.
+    std::uint32_t Add(const Literal::ValueType& literal);
+
+    const TOut& operator[](std::uint32_t index) const {
+        return values_[index];
+    }
+    std::size_t size() const { return std::size(values_); }
+};
+
+}  // namespace lox
@@ -1,10 +1,11 @@
 #pragma once
 
-#include <map>
 #include <string>
+#include <unordered_map>
 #include <variant>
 
 #include "runtimeerror.h"
+#include "symbolTable.h"
 #include "syntaxTree.h"
 
 namespace lox {
@@ -14,7 +15,7 @@ class Environment {
    public:
     using ValueType = TOut;
     std::shared_ptr<Environment<ValueType>> enclosing = nullptr;
-    std::map<std::string, ValueType> values;
+    std::unordered_map<Symbol, ValueType> values;
 
    private:
 
@@ -22,8 +23,7 @@ class Environment {
     Environment();
     Environment(std::shared_ptr<Environment<ValueType>> env);
 
-    void Define(const std::string& name,
-                typename Environment<TOut>::ValueType value);
+    void Define(Symbol name, typename Environment<TOut>::ValueType value);
     void Assign(const Token& name, typename Environment<TOut>::ValueType value);
     void AssignAt(int distance, const Token& name, typename Environment<TOut>::ValueType value);
     ValueType Get(Token name);
@@ -39,7 +39,7 @@ Environment<T>::Environment(std::shared_ptr<Environment<T>> env)
     : enclosing(std::move(env)) {}
 
 template <typename T>
-void Environment<T>::Define(const std::string& name,
+void Environment<T>::Define(Symbol name,
                             typename Environment<T>::ValueType value) {
     values.insert_or_assign(name, value);
 }
@@ -47,7 +47,7 @@ void Environment<T>::Define(const std::string& name,
 template <typename T>
 void Environment<T>::Assign(const Token& name,
                             typename Environment<T>::ValueType value) {
-    auto v = values.find(name.Lexeme);
+    auto v = values.find(name.Value);
     if (v != values.end()) {
         v->second = value;
     } else {
@@ -56,15 +56,15 @@ void Environment<T>::Assign(const Token& name,
             enclosing->Assign(name, value);
             return;
         }
-        auto err_msg = std::string("Undefined variable'") + name.Lexeme +
-                       std::string("'.");
+        auto err_msg = std::string("Undefined variable'") +
+                       Symbols().Name(name.Value) + std::string("'.");
         throw RunTimeError{name, err_msg};
     }
 }
 
 template <typename T>
 typename Environment<T>::ValueType Environment<T>::Get(Token name) {
-    auto val = values.find(std::get<std::string>(name.Data));
+    auto val = values.find(name.Value);
 
     if (val == values.end()) {
         if (enclosing != nullptr)  // if not found here, check the enclosing
@@ -74,7 +74,7 @@ typename Environment<T>::ValueType Environment<T>::Get(Token name) {
         }
 
         throw RunTimeError{name, std::string("Undefined variable '") +
-                                     std::get<std::string>(name.Data) +
+                                     Symbols().Name(name.Value) +
                                      std::string("'.")};
     }
 
@@ -96,7 +96,7 @@ Environment<T>* Environment<T>::Ancestor(int distance)
 template<typename T>
 typename Environment<T>::ValueType Environment<T>::GetAt(int distance, Token name)
 {
-    return Ancestor(distance)->values.find(name.Lexeme)->second;
+    return Ancestor(distance)->values.find(name.Value)->second;
 }
 
 template<typename T>
@@ -105,7 +105,7 @@ void Environment<T>::AssignAt(
         const Token& name,
         typename Environment<T>::ValueType value)
 {
-    Ancestor(distance)->values.insert_or_assign(name.Lexeme, value);
+    Ancestor(distance)->values.insert_or_assign(name.Value, value);
 }
 
 }  // namespace lox
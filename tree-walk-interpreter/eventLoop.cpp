@@ -0,0 +1,178 @@
+#include "eventLoop.h"
+
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <system_error>
+#include <utility>
+
+#include "interpreter.h"
+
+namespace lox {
+
+void Pending::Complete(TOut value) {
+    if (done_) {
+        return;
+    }
+    done_ = true;
+    value_ = std::move(value);
+    if (auto wake = std::exchange(wake_, nullptr)) {
+        wake();
+    }
+}
+
+void Pending::Fail(std::string message) {
+    if (done_) {
+        return;
+    }
+    done_ = true;
+    failed_ = true;
+    error_ = std::move(message);
+    if (auto wake = std::exchange(wake_, nullptr)) {
+        wake();
+    }
+}
+
+[[noreturn]] static void ThrowErrno(const char* what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+EventLoop::EventLoop() : epoll_(epoll_create1(EPOLL_CLOEXEC)) {
+    if (epoll_ < 0) {
+        ThrowErrno("epoll_create1");
+    }
+}
+
+EventLoop::~EventLoop() {
+    for (int timer : timers_) {
+        close(timer);
+    }
+    close(epoll_);
+}
+
+void EventLoop::Spawn(Interpreter& interpreter, const Program& program,
+                      std::function<void(bool)> done) {
+    interpreter.Loop = this;
+    ready_.push_back(tasks_.insert(
+        tasks_.end(), Task{&interpreter, &program, std::move(done)}));
+}
+
+void EventLoop::Watch(int fd, std::uint32_t events,
+                      std::function<void()> ready) {
+    epoll_event event{};
+    event.events = events | EPOLLONESHOT;
+    event.data.fd = fd;
+    if (epoll_ctl(epoll_, EPOLL_CTL_ADD, fd, &event) < 0) {
+        ThrowErrno("epoll_ctl");
+    }
+    watches_.insert_or_assign(fd, std::move(ready));
+}
+
+void EventLoop::After(double seconds, std::function<void()> done) {
+    int timer = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (timer < 0) {
+        ThrowErrno("timerfd_create");
+    }
+    // A zero time disarms the timer, the shortest one fires at once.
+    seconds = seconds > 0 ? std::min(seconds, kMaxSeconds) : 0;
+    double whole = 0;
+    double fraction = std::modf(seconds, &whole);
+    itimerspec spec{};
+    spec.it_value.tv_sec = static_cast<time_t>(whole);
+    spec.it_value.tv_nsec = std::max(static_cast<long>(fraction * 1e9), 1L);
+    if (timerfd_settime(timer, 0, &spec, nullptr) < 0) {
+        close(timer);
+        ThrowErrno("timerfd_settime");
+    }
+    try {
+        Watch(timer, EPOLLIN, [this, timer, done = std::move(done)] {
+            timers_.erase(timer);
+            close(timer);
+            done();
+        });
+    } catch (...) {
+        close(timer);
+        throw;
+    }
+    timers_.insert(timer);
+}
+
+void EventLoop::Run() {
+    while (!std::empty(tasks_)) {
+        if (!std::empty(ready_)) {
+            auto task = ready_.front();
+            ready_.pop_front();
+            Step(task);
+        } else if (!std::empty(watches_)) {
+            Poll();
+        } else {
+            return;
+        }
+    }
+}
+
+void EventLoop::Step(TaskList::iterator task) {
+    auto& interpreter = *task->Runner;
+    Interpreter::RunState state;
+    if (task->Script != nullptr) {
+        const auto& program = *std::exchange(task->Script, nullptr);
+        state = interpreter.Start(program.Statements, program.Locals);
+    } else {
+        state = interpreter.Continue();
+    }
+
+    if (state == Interpreter::RunState::WAITING) {
+        auto& operation = *interpreter.Awaiting();
+        if (operation.Done()) {
+            ready_.push_back(task);
+        } else {
+            operation.wake_ = [this, task] { ready_.push_back(task); };
+        }
+        return;
+    }
+    interpreter.Loop = nullptr;
+    auto done = std::move(task->Done);
+    tasks_.erase(task);
+    if (done) {
+        done(state == Interpreter::RunState::FINISHED);
+    }
+}
+
+void EventLoop::Wait(Pending& pending) {
+    while (!pending.Done()) {
+        if (std::empty(watches_)) {
+            pending.Fail("The operation can't complete.");
+            return;
+        }
+        Poll();
+    }
+}
+
+void EventLoop::Poll() {
+    constexpr int kMaxEvents = 64;
+    epoll_event events[kMaxEvents];
+    int count = epoll_wait(epoll_, events, kMaxEvents, -1);
+    if (count < 0) {
+        if (errno == EINTR) {
+            return;
+        }
+        ThrowErrno("epoll_wait");
+    }
+    for (int i = 0; i < count; ++i) {
+        int fd = events[i].data.fd;
+        auto watch = watches_.find(fd);
+        if (watch == watches_.end()) {
+            continue;
+        }
+        auto ready = std::move(watch->second);
+        watches_.erase(watch);
+        epoll_ctl(epoll_, EPOLL_CTL_DEL, fd, nullptr);
+        ready();
+    }
+}
+
+}  // namespace lox
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "loxFunction.h"
+#include "program.h"
+
+namespace lox {
+
+class Interpreter;
+
+// An operation an async native started. The host completes it with the
+// value the call returns, or fails it with the message of the runtime error
+// the call throws, on the thread of the loop.
+class Pending {
+   public:
+    using TOut = LoxFunction::TOut;
+
+    // Only the first Complete or Fail counts.
+    void Complete(TOut value);
+    void Fail(std::string message);
+    bool Done() const { return done_; }
+
+   private:
+    friend class EventLoop;
+    friend class Interpreter;
+
+    bool done_ = false;
+    bool failed_ = false;
+    TOut value_ = false;
+    std::string error_;
+    // Continues whoever waits for it, once it is done.
+    std::function<void()> wake_;
+};
+
+// Runs scripts on one thread, each on an interpreter of its own, and
+// switches between them while they wait for I/O. A script that calls an
+// async native is parked, its frames stay on its interpreter, and the loop
+// runs the next ready script. Once the operation completes, from a
+// callback of Watch or After, the script is ready again and continues with
+// the result of the call. Waiting is epoll on Linux.
+//
+// Scripts on a loop run their calls in the interpreter, machine code can't
+// be parked in the middle of a call. An async native called where a script
+// can't park, from a native that calls back into Lox, waits for the
+// operation there, and the other scripts wait as well.
+class EventLoop {
+   public:
+    // The longest time After waits.
+    static constexpr double kMaxSeconds = 365 * 24 * 60 * 60;
+
+    EventLoop();
+    ~EventLoop();
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // Run program on interpreter as one of the scripts of the loop, from
+    // the next Run on. Both must live until it finished, then done gets
+    // false if a runtime error stopped it. The interpreter runs nothing
+    // else in the meantime.
+    void Spawn(Interpreter& interpreter, const Program& program,
+               std::function<void(bool)> done = nullptr);
+    // Call ready once, when fd is ready for events, EPOLLIN or EPOLLOUT.
+    // Each fd can only be watched once at a time. Throws std::system_error
+    // if fd can't be watched, such as a regular file.
+    void Watch(int fd, std::uint32_t events, std::function<void()> ready);
+    // Call done once seconds passed, at most kMaxSeconds.
+    void After(double seconds, std::function<void()> done);
+
+    // Run the scripts until they all finished, or the ones left wait for
+    // operations that nothing watched can complete.
+    void Run();
+    // Call the callbacks of watches until pending is done, without running
+    // scripts. It fails if nothing watched is left to complete it.
+    void Wait(Pending& pending);
+
+   private:
+    struct Task {
+        Interpreter* Runner;
+        // Null once started.
+        const Program* Script;
+        std::function<void(bool)> Done;
+    };
+    using TaskList = std::list<Task>;
+
+    int epoll_;
+    TaskList tasks_;
+    std::deque<TaskList::iterator> ready_;
+    std::unordered_map<int, std::function<void()>> watches_;
+    // The timerfds of After, closed once they fire.
+    std::unordered_set<int> timers_;
+
+    // Run task until it finishes or parks.
+    void Step(TaskList::iterator task);
+    // Wait for at least one watched fd and call its callback.
+    void Poll();
+};
+
+}  // namespace lox
@@ -1,61 +1,48 @@
 #include "interpreter.h"
 
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <iterator>
 #include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
 
+#include "compiler.h"
+#include "lox.h"
+#include "loxClass.h"
+#include "loxCoroutine.h"
+#include "loxF64Array.h"
 #include "loxFunction.h"
-#include "return.h"
+#include "loxList.h"
+#include "loxMap.h"
+#include "symbolTable.h"
+#if defined(LOX_JIT)
+#include "jit.h"
+#endif
 
 namespace lox {
 
 using namespace std::string_literals;
 
+// Value of a register that holds a double, which is not checked.
+static double Number(const Interpreter::TOut& value) {
+    assert(std::holds_alternative<double>(value));
+    return *std::get_if<double>(&value);
+}
+
 template <typename T>
 bool IsTruth(const T& val) {
     return std::visit(
         overload{[](bool b) { return b; }, [](auto _) { return false; }}, val);
 }
 
-void Interpreter::Visit(Literal& l) { stack_.push(EvalLiteral(l)); }
-
-void Interpreter::Visit(BinaryExpr& b) {
-    b.Left->Accept(*this);
-    auto l = stack_.top();
-    stack_.pop();
-
-    b.Right->Accept(*this);
-    auto r = stack_.top();
-    stack_.pop();
-
-    stack_.push(EvalBinExpr(b.Tok, l, r));
-}
-
-void Interpreter::Visit(UnaryExpr& u) {
-    u.Expr->Accept(*this);
-    auto e = stack_.top();
-    stack_.pop();
-
-    stack_.push(EvalUnExpr(u.Op, e));
-}
-
-void Interpreter::Visit(Grouping& g) {
-    g.Expr->Accept(*this);
-    auto e = stack_.top();
-    stack_.pop();
-
-    stack_.push(EvalGroup(e));
-}
-
 using TOut = Interpreter::TOut;
 static void RError(Token t, std::string message) {
     throw RunTimeError{t, std::string("Unsupported operation between doubles")};
 }
 
-TOut Interpreter::EvalLiteral(Literal& l) {
-    return std::visit(overload{[](std::monostate _) { return TOut("Nil"); },
-                               [](auto v) { return TOut(v); }},
-                      l.Value);
-}
-
 TOut Interpreter::EvalUnExpr(Token t, TOut v) {
     return std::visit(
         overload{
@@ -132,15 +119,15 @@ static TOut EvalBinBoolExpr(Token& t, const bool a, const bool b) {
     return {"Nil"};
 }
 
-static TOut EvalBinStringExpr(Token& t, const std::string& s_l,
-                              const std::string& s_r) {
+static TOut EvalBinStringExpr(Token& t, const LoxString& s_l,
+                              const LoxString& s_r) {
     switch (t.Type) {
         case TokenType::BANG_EQUAL:
             return s_l != s_r;
         case TokenType::EQUAL_EQUAL:
             return s_l == s_r;
         case TokenType::PLUS:
-            return s_l + s_r;
+            return LoxString::Concat(s_l, s_r);
         default:
             break;
     }
@@ -175,10 +162,10 @@ TOut Interpreter::EvalBinExpr(Token t, TOut l, TOut r) {
                     },
                     r);
             },
-            [&r, &t](std::string s_l) -> TOut {
+            [&r, &t](const LoxString& s_l) -> TOut {
                 return std::visit(
                     overload{
-                        [s_l, &t](std::string s_r) -> TOut {
+                        [&s_l, &t](const LoxString& s_r) -> TOut {
                             return EvalBinStringExpr(t, s_l, s_r);
                         },
                         [&t](auto _) -> TOut {
@@ -191,171 +178,1103 @@ TOut Interpreter::EvalBinExpr(Token t, TOut l, TOut r) {
             [&t](LoxFunction& l) -> TOut {
                 RError(t, "Unexpected callable");
                 return {"Nil"};
+            },
+            // Classes, instances, bound methods, lists, maps and natives
+            // are only equal to themselves.
+            [&r, &t](const auto& object) -> TOut {
+                using Object = std::decay_t<decltype(object)>;
+                auto* other = std::get_if<Object>(&r);
+                bool same = other != nullptr && *other == object;
+                switch (t.Type) {
+                    case TokenType::EQUAL_EQUAL:
+                        return same;
+                    case TokenType::BANG_EQUAL:
+                        return !same;
+                    default:
+                        break;
+                }
+                RError(t, "Operator not supported for objects.");
+                return {"Nil"};
             }},
         l);
 }
 
-void Interpreter::Visit(Variable& var) {
-    stack_.push(LookUpVariable(var.Name, &var));
+void Interpreter::CountString(const TOut& value) {
+    if (auto* s = std::get_if<LoxString>(&value)) {
+        ++Stats.StringsAllocated;
+        Stats.BytesAllocated += s->Length();
+    }
 }
 
-void Interpreter::Visit(VariableDeclaration& var) {
-    TOut value;
-    if (var.Initializer != nullptr) {
-        value = Eval(*(var.Initializer));
+// Write value as print shows it, lists and maps with their elements. open
+// are the lists and maps being written, one containing itself is written
+// as [...] or {...} the second time.
+static void Write(std::ostream& os, const TOut& value,
+                  std::vector<const void*>& open) {
+    auto is_open = [&open](const void* collection) {
+        return std::find(open.begin(), open.end(), collection) != open.end();
+    };
+    std::visit(
+        overload{
+            [&os](const LoxFunction& f) {
+                os << "<fn " << Symbols().Name(f.Proto().Name.Value) << ">";
+            },
+            [&os](const std::shared_ptr<const LoxBoundMethod>& m) {
+                os << "<fn " << Symbols().Name(m->Method.Proto().Name.Value)
+                   << ">";
+            },
+            [&os](const LoxNative* n) { os << "<native fn " << n->Name << ">"; },
+            [&os](const std::shared_ptr<LoxCoroutine>&) { os << "<coroutine>"; },
+            [&os](const std::shared_ptr<LoxClass>& c) { os << *c; },
+            [&os](const std::shared_ptr<LoxInstance>& i) { os << *i; },
+            [&](const std::shared_ptr<LoxList>& l) {
+                if (is_open(l.get())) {
+                    os << "[...]";
+                    return;
+                }
+                open.push_back(l.get());
+                os << "[";
+                const char* separator = "";
+                for (const auto& element : l->Elements) {
+                    os << separator;
+                    Write(os, element, open);
+                    separator = ", ";
+                }
+                os << "]";
+                open.pop_back();
+            },
+            [&os](const std::shared_ptr<LoxF64Array>& a) {
+                os << "F64Array[";
+                const char* separator = "";
+                for (double element : a->Elements) {
+                    os << separator;
+                    WriteNumber(os, element);
+                    separator = ", ";
+                }
+                os << "]";
+            },
+            [&](const std::shared_ptr<LoxMap>& m) {
+                if (is_open(m.get())) {
+                    os << "{...}";
+                    return;
+                }
+                open.push_back(m.get());
+                os << "{";
+                const char* separator = "";
+                m->ForEach([&](const TOut& key, const TOut& v) {
+                    os << separator;
+                    Write(os, key, open);
+                    os << ": ";
+                    Write(os, v, open);
+                    separator = ", ";
+                });
+                os << "}";
+                open.pop_back();
+            },
+            [&os](double number) { WriteNumber(os, number); },
+            [&os](const auto& v) { os << v; }},
+        value);
+}
+
+void Interpreter::Print(const TOut& value) {
+    // Functions print nothing.
+    if (std::holds_alternative<LoxFunction>(value) ||
+        std::holds_alternative<std::shared_ptr<const LoxBoundMethod>>(value) ||
+        std::holds_alternative<const LoxNative*>(value)) {
+        return;
+    }
+    std::vector<const void*> open;
+    Write(Out, value, open);
+    Out << '\n';
+}
+
+bool Interpreter::Interpret(
+    const std::vector<std::unique_ptr<Statement>>& statements,
+    const std::map<Expression*, int>& locals) {
+    auto state = Start(statements, locals);
+    while (state == RunState::WAITING) {
+        Loop->Wait(*waiting_.Operation);
+        state = Continue();
     }
-    environment_->Define(var.Name.Lexeme, value);
+    return state == RunState::FINISHED;
 }
 
-void Interpreter::Visit(PrintStatement& p) {
-    auto val = Eval(*p.Expr);
-    std::visit(overload{[](LoxFunction& c) {},
-                        [](auto v) { std::cout << v << std::endl; }},
-               val);
+Interpreter::RunState Interpreter::Start(
+    const std::vector<std::unique_ptr<Statement>>& statements,
+    const std::map<Expression*, int>& locals) {
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+    Compiler compiler(locals, constants_);
+    auto* enclosing_out = SetErrorOut(&Out);
+    auto script = compiler.Compile(statements);
+    SetErrorOut(enclosing_out);
+    Stats.Compile += Clock::now() - start;
+    if (Trace != nullptr) {
+        Trace->Phase("compile", start);
+    }
+    if (script == nullptr) {
+        Out.flush();
+        return RunState::FAILED;
+    }
+
+    return Execute([this, &script] {
+        script_base_ = std::size(stack_);
+        auto cells = std::size(cells_);
+        Grow(script_base_ + script->MaxRegisters, 0);
+        cells_.resize(cells + script->NumCells);
+        frames_.push_back(CallFrame{script, script->Code.data(), nullptr,
+                                    script_base_, cells});
+        if (Trace != nullptr) {
+            Trace->Enter(FrameName(frames_.back()));
+        }
+    });
 }
 
-void Interpreter::Visit(ExpressionStatement& s) { auto val = Eval(*s.Expr); }
+Interpreter::RunState Interpreter::Continue() {
+    return Execute([this] { Deliver(); });
+}
 
-void Interpreter::Interpret(
-    std::vector<std::unique_ptr<Statement>>& statements) {
+Interpreter::RunState Interpreter::Execute(
+    const std::function<void()>& enter) {
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
     try {
-        for (auto& s : statements) {
-            Execute(*s);
+        enter();
+        Run(0);
+        if (waiting_.Operation != nullptr) {
+            Stats.Execute += Clock::now() - start;
+            return RunState::WAITING;
         }
-
+        stack_.Shrink(script_base_);
     } catch (RunTimeError rte) {
-        while (!std::empty(stack_)) {
-            stack_.pop();
+        rte.Backtrace = Backtrace(rte.Operator.Line);
+        if (Trace != nullptr) {
+            Trace->Error(rte.ErrorMsg, rte.Operator.Line);
+            for (auto frame = frames_.rbegin(); frame != frames_.rend();
+                 ++frame) {
+                Trace->Exit(FrameName(*frame));
+            }
+        }
+        stack_.Shrink(0);
+        frames_.clear();
+        cells_.clear();
+        for (auto& resumption : resumptions_) {
+            resumption.Coroutine->Status = LoxCoroutine::State::DONE;
         }
-        ReportRunTimeError(rte);
+        resumptions_.clear();
+        waiting_ = Waiting{};
+        ReportRunTimeError(rte, Out);
+        Out.flush();
+        Stats.Execute += Clock::now() - start;
+        return RunState::FAILED;
     }
+    Stats.Execute += Clock::now() - start;
+    return RunState::FINISHED;
 }
 
-void Interpreter::Visit(Assignment& ass) {
-    auto val = Eval(*ass.Expr);
-    auto distance = locals.find(&ass);
-    if (distance != locals.end()) {
-        environment_->AssignAt(distance->second, ass.Name, val);
-    } else {
-        Globals->Assign(ass.Name, val);
-    }
-    stack_.push(val);
+[[noreturn]] static void Throw(std::uint32_t line, std::string message) {
+    throw RunTimeError{Token{0, 0, TokenType::LEFT_PAREN, line, 0},
+                       std::move(message)};
 }
 
-void Interpreter::ExecuteBlock(
-    std::vector<std::shared_ptr<Statement>>& statements,
-    std::shared_ptr<Environment<TOut>>& env) {
-    auto old_env = environment_;
-    environment_ = env;  // Assign the pointer.
-    try {
-        for (auto& s : statements) {
-            Execute(*s);
+[[noreturn]] static void StackOverflow(std::uint32_t line) {
+    Throw(line, "Stack overflow.");
+}
+
+TOut Interpreter::Call(const LoxFunction& function,
+                       std::vector<TOut>& arguments) {
+    auto base = std::size(stack_);
+    auto line = function.Proto().Name.Line;
+    for (auto& a : arguments) {
+        if (!stack_.Push(TOut(a))) {
+            stack_.Shrink(base);
+            StackOverflow(line);
         }
+    }
+    auto depth = std::size(frames_);
+    auto cells = std::size(cells_);
+    TOut result;
+    try {
+        PushFrame(function, std::size(arguments), base, line);
+        result = Run(depth);
     } catch (...) {
-        environment_ = old_env;  // reset the pointer on failure.
+        // Drop the frames of the call, so the next script doesn't run on
+        // in them.
+        if (Trace != nullptr) {
+            for (auto i = std::size(frames_); i > depth; --i) {
+                Trace->Exit(FrameName(frames_[i - 1]));
+            }
+        }
+        frames_.erase(frames_.begin() + depth, frames_.end());
+        cells_.resize(cells);
+        while (!std::empty(resumptions_) &&
+               resumptions_.back().Depth > depth) {
+            resumptions_.back().Coroutine->Status = LoxCoroutine::State::DONE;
+            resumptions_.pop_back();
+        }
+        stack_.Shrink(base);
         throw;
     }
-    environment_ = old_env;
+    stack_.Shrink(base);
+    return result;
 }
 
-void Interpreter::Visit(Block& blk) {
-    auto env = std::make_shared<Environment<TOut>>(environment_);
-    ExecuteBlock(blk.Statements, env);
+void Interpreter::Grow(std::size_t size, std::uint32_t line) {
+    if (!stack_.Grow(size)) {
+        StackOverflow(line);
+    }
 }
 
-void Interpreter::Visit(IfStatement& ifm) {
-    if (IsTruth(Eval(*ifm.Condition))) {
-        Execute(*ifm.ThenBranch);
-    } else if (ifm.ElseBranch != nullptr) {
-        Execute(*ifm.ElseBranch);
+void Interpreter::PushFrame(const LoxFunction& function, std::size_t arg_count,
+                            std::size_t base, std::uint32_t line) {
+    const auto& proto = function.Proto();
+    if (std::size(frames_) >= MaxFrames) {
+        StackOverflow(line);
+    }
+    if (arg_count != proto.Arity) {
+        std::string error_message =
+            "Expected"s + std::to_string(proto.Arity) +
+            " arguments but got "s + std::to_string(arg_count) + "."s;
+        throw RunTimeError{Token{0, 0, TokenType::LEFT_PAREN, line, 0},
+                           std::move(error_message)};
+    }
+
+    auto code = proto.Code;
+    auto upvalues = function.Upvalues();
+    Grow(base + code->MaxRegisters, line);
+    auto cells = std::size(cells_);
+    cells_.resize(cells + code->NumCells);
+    TierUp(*code);
+    frames_.push_back(
+        CallFrame{code, code->Code.data(), upvalues, base, cells, &proto});
+    ++Stats.Calls;
+    if (Trace != nullptr) {
+        Trace->Enter(FrameName(frames_.back()));
     }
 }
 
-void Interpreter::EvalOr(Logical& lg) {
-    auto left = Eval(*lg.Left);
-    if (IsTruth(left)) {
-        stack_.push(left);
-        return;
+bool Interpreter::CallValue(std::size_t callee, std::size_t arg_count,
+                            std::uint32_t line) {
+    auto& value = stack_[callee];
+    if (auto* function = std::get_if<LoxFunction>(&value)) {
+        PushFrame(*function, arg_count, callee + 1, line);
+        return true;
     }
-    stack_.push(Eval(*lg.Right));
-    return;
+
+    // Methods get the instance in place of the callee. It keeps its class
+    // alive, and so the method that runs.
+    if (auto* klass = std::get_if<std::shared_ptr<LoxClass>>(&value)) {
+        static const Symbol init = Symbols().Intern("init");
+        auto instance = std::make_shared<LoxInstance>(*klass);
+        const auto* initializer = instance->Class->FindMethod(init);
+        value = std::move(instance);
+        if (initializer != nullptr) {
+            PushFrame(*initializer, arg_count, callee, line);
+            return true;
+        }
+        if (arg_count != 0) {
+            Throw(line, "Expected 0 arguments but got "s +
+                            std::to_string(arg_count) + "."s);
+        }
+        return false;
+    }
+    if (auto* native = std::get_if<const LoxNative*>(&value)) {
+        const auto& function = **native;
+        if (arg_count != function.Arity) {
+            Throw(line, "Expected "s + std::to_string(function.Arity) +
+                            " arguments but got "s +
+                            std::to_string(arg_count) + "."s);
+        }
+        ++Stats.Calls;
+        if (function.Start != nullptr) {
+            Await(function, callee, line);
+            return false;
+        }
+        // resume is the one native that runs Lox code, which takes the
+        // interpreter.
+        if (function.Function == nullptr) {
+            Resume(callee, line);
+            return true;
+        }
+        value = function.Function(&stack_[callee + 1], line);
+        return false;
+    }
+    if (auto* bound =
+            std::get_if<std::shared_ptr<const LoxBoundMethod>>(&value)) {
+        auto method = *bound;
+        value = method->Receiver;
+        PushFrame(method->Method, arg_count, callee, line);
+        return true;
+    }
+
+    Throw(line, "Can only call functions and classes");
 }
 
-void Interpreter::EvalAnd(Logical& lg) {
-    auto left = Eval(*lg.Left);
-    if (IsTruth(left)) {
-        stack_.push(Eval(*lg.Right));
-        return;
+void Interpreter::Resume(std::size_t callee, std::uint32_t line) {
+    auto* argument =
+        std::get_if<std::shared_ptr<LoxCoroutine>>(&stack_[callee + 1]);
+    if (argument == nullptr) {
+        Throw(line, "Argument must be a coroutine.");
     }
-    stack_.push(left);  // return false;
+    auto coroutine = *argument;
+    if (coroutine->Status == LoxCoroutine::State::RUNNING) {
+        Throw(line, "Can't resume a running coroutine.");
+    }
+    if (coroutine->Status == LoxCoroutine::State::DONE) {
+        Throw(line, "Can't resume a finished coroutine.");
+    }
+
+    // It runs right after the registers of the frame resuming it.
+    const auto& caller = frames_.back();
+    Resumption resumption{coroutine, std::size(frames_),
+                          caller.Base + caller.Code->MaxRegisters, callee};
+    if (coroutine->Started()) {
+        Restore(*coroutine, resumption.Start, line);
+    } else {
+        Grow(resumption.Start + 1, line);
+        stack_[resumption.Start] = std::exchange(coroutine->Body, false);
+        CallValue(resumption.Start, 0, line);
+    }
+    coroutine->Status = LoxCoroutine::State::RUNNING;
+    resumptions_.push_back(std::move(resumption));
+}
+
+void Interpreter::Suspend() {
+    auto resumption = std::move(resumptions_.back());
+    resumptions_.pop_back();
+    auto& coroutine = *resumption.Coroutine;
+    auto depth = resumption.Depth;
+    auto start = resumption.Start;
+    // Callees can have fewer registers than the rest of their caller.
+    auto end = start;
+    for (auto i = depth; i < std::size(frames_); ++i) {
+        end = std::max(end, frames_[i].Base + frames_[i].Code->MaxRegisters);
+    }
+    auto cells = frames_[depth].Cells;
+
+    coroutine.Registers.assign(std::make_move_iterator(stack_.data() + start),
+                               std::make_move_iterator(stack_.data() + end));
+    coroutine.Cells.assign(std::make_move_iterator(cells_.begin() + cells),
+                           std::make_move_iterator(cells_.end()));
+    cells_.resize(cells);
+    for (auto i = depth; i < std::size(frames_); ++i) {
+        auto frame = std::move(frames_[i]);
+        frame.Base -= start;
+        frame.Cells -= cells;
+        coroutine.Frames.push_back(std::move(frame));
+    }
+    if (Trace != nullptr) {
+        for (auto frame = coroutine.Frames.rbegin();
+             frame != coroutine.Frames.rend(); ++frame) {
+            Trace->Exit(FrameName(*frame));
+        }
+    }
+    frames_.erase(frames_.begin() + depth, frames_.end());
+    coroutine.Status = LoxCoroutine::State::SUSPENDED;
 }
 
-void Interpreter::Visit(Logical& lg) {
-    if (lg.Op.Type == TokenType::OR) {
-        EvalOr(lg);
+void Interpreter::Restore(LoxCoroutine& coroutine, std::size_t start,
+                          std::uint32_t line) {
+    if (std::size(frames_) + std::size(coroutine.Frames) > MaxFrames) {
+        StackOverflow(line);
     }
-    if (lg.Op.Type == TokenType::AND) {
-        EvalAnd(lg);
+    Grow(start + std::size(coroutine.Registers), line);
+    std::move(coroutine.Registers.begin(), coroutine.Registers.end(),
+              stack_.data() + start);
+    auto cells = std::size(cells_);
+    cells_.insert(cells_.end(), std::make_move_iterator(coroutine.Cells.begin()),
+                  std::make_move_iterator(coroutine.Cells.end()));
+    for (auto& frame : coroutine.Frames) {
+        frame.Base += start;
+        frame.Cells += cells;
+        frames_.push_back(std::move(frame));
+        if (Trace != nullptr) {
+            Trace->Enter(FrameName(frames_.back()));
+        }
     }
+    // Clearing keeps the memory for the next time it yields.
+    coroutine.Registers.clear();
+    coroutine.Cells.clear();
+    coroutine.Frames.clear();
 }
 
-void Interpreter::Visit(While& whl) {
-    while (IsTruth(Eval(*whl.Condition))) {
-        Execute(*whl.Body);
+void Interpreter::Await(const LoxNative& function, std::size_t callee,
+                        std::uint32_t line) {
+    // What fails in the host is an error of the call.
+    std::shared_ptr<Pending> operation;
+    try {
+        if (Loop == nullptr && own_loop_ == nullptr) {
+            own_loop_ = std::make_unique<EventLoop>();
+        }
+        auto& loop = Loop != nullptr ? *Loop : *own_loop_;
+        operation = function.Start(loop, &stack_[callee + 1], line);
+    } catch (const std::system_error& e) {
+        Throw(line, e.what());
+    }
+    waiting_ = Waiting{std::move(operation), callee, line};
+    if (waiting_.Operation->Done()) {
+        Deliver();
+    } else if (Loop == nullptr) {
+        Block();
     }
 }
 
-void Interpreter::Visit(Call& c) {
-    auto callee = Eval(*c.Callee);
+void Interpreter::Block() {
+    try {
+        (Loop != nullptr ? *Loop : *own_loop_).Wait(*waiting_.Operation);
+    } catch (const std::system_error& e) {
+        Throw(waiting_.Line, e.what());
+    }
+    Deliver();
+}
 
-    std::vector<TOut> arguments;
-    for (auto& arg : c.Arguments) {
-        arguments.push_back(Eval(*arg));
+void Interpreter::Deliver() {
+    auto waiting = std::exchange(waiting_, Waiting{});
+    auto& operation = *waiting.Operation;
+    if (operation.failed_) {
+        Throw(waiting.Line, std::move(operation.error_));
     }
+    stack_[waiting.Callee] = std::move(operation.value_);
+}
 
-    stack_.push(std::visit(
-        overload{[&](LoxFunction& lf) -> TOut {
-                     if (std::size(arguments) != lf.Arity()) {
-                         std::string error_message =
-                             "Expected"s + std::to_string(lf.Arity()) +
-                             " arguments but got "s +
-                             std::to_string(std::size(arguments)) + "."s;
+bool Interpreter::Invoke(std::size_t receiver, std::size_t arg_count,
+                         PropertyCache& cache, std::uint32_t line) {
+    auto* instance =
+        std::get_if<std::shared_ptr<LoxInstance>>(&stack_[receiver]);
+    if (instance == nullptr) {
+        Throw(line, "Only instances have methods.");
+    }
+    auto& object = **instance;
+    if (cache.Key.get() != object.Layout.get()) {
+        Lookup(object, cache, line);
+    }
+    if (cache.Method.has_value()) {
+        PushFrame(*cache.Method, arg_count, receiver, line);
+        return true;
+    }
 
-                         throw RunTimeError{c.Paren, std::move(error_message)};
-                     }
-                     return lf.Call(*this, arguments);
-                 },
-                 [&c](auto _) -> TOut {
-                     throw RunTimeError{c.Paren,
-                                        "Can only call functions and classes"};
-                     return TOut{"Nil"};
-                 }},
-        callee));
+    // A field, which is called like any other value.
+    TOut callee = object.Fields[cache.Slot];
+    stack_[receiver] = std::move(callee);
+    return CallValue(receiver, arg_count, line);
 }
 
-void Interpreter::Visit(FunctionDeclaration& fd) {
-    environment_->Define(fd.Name.Lexeme, {LoxFunction(fd, environment_)});
+void Interpreter::GetProperty(TOut* regs, const Instruction& instr,
+                              PropertyCache& cache, std::uint32_t line) {
+    auto* instance = std::get_if<std::shared_ptr<LoxInstance>>(&regs[instr.B]);
+    if (instance == nullptr) {
+        Throw(line, "Only instances have properties.");
+    }
+    if (cache.Key.get() != (*instance)->Layout.get()) {
+        Lookup(**instance, cache, line);
+    }
+
+    // Copied first, the instance might be in the destination.
+    TOut value = cache.Method.has_value()
+                     ? TOut(std::make_shared<const LoxBoundMethod>(
+                           LoxBoundMethod{*instance, *cache.Method}))
+                     : (*instance)->Fields[cache.Slot];
+    regs[instr.A] = std::move(value);
 }
 
-void Interpreter::Visit(ReturnStatement& rstm) {
+void Interpreter::SetProperty(TOut* regs, const Instruction& instr,
+                              PropertyCache& cache, std::uint32_t line) {
+    auto* instance = std::get_if<std::shared_ptr<LoxInstance>>(&regs[instr.A]);
+    if (instance == nullptr) {
+        Throw(line, "Only instances have fields.");
+    }
+    auto& object = **instance;
+    if (cache.Key.get() != object.Layout.get()) {
+        // A new field goes in the next slot, and moves the instance on to
+        // the next shape.
+        auto slot = object.Layout->Find(cache.Name);
+        cache.Key = object.Layout;
+        cache.Method.reset();
+        if (slot != Shape::kNotFound) {
+            cache.Slot = slot;
+            cache.Next = nullptr;
+        } else {
+            cache.Slot = static_cast<std::uint32_t>(std::size(object.Fields));
+            cache.Next = object.Layout->Add(cache.Name);
+        }
+    }
+
+    if (cache.Next != nullptr) {
+        object.Layout = cache.Next;
+        object.Fields.push_back(regs[instr.B]);
+    } else {
+        object.Fields[cache.Slot] = regs[instr.B];
+    }
+}
+
+void Interpreter::Lookup(const LoxInstance& instance, PropertyCache& cache,
+                         std::uint32_t line) {
+    // Fields shadow methods.
+    auto slot = instance.Layout->Find(cache.Name);
+    if (slot != Shape::kNotFound) {
+        cache.Slot = slot;
+        cache.Method.reset();
+    } else if (const auto* method = instance.Class->FindMethod(cache.Name)) {
+        cache.Method = *method;
+    } else {
+        Throw(line, "Undefined property '"s + Symbols().Name(cache.Name) +
+                        "'."s);
+    }
+    cache.Key = instance.Layout;
+    cache.Next = nullptr;
+}
+
+void Interpreter::NewList(TOut* regs, const Instruction& instr) {
+    auto list = std::make_shared<LoxList>(
+        std::vector<TOut>(regs + instr.B, regs + instr.B + instr.C));
+    regs[instr.A] = std::move(list);
+}
+
+void Interpreter::NewMap(TOut* regs, const Instruction& instr,
+                         std::uint32_t line) {
+    auto map = std::make_shared<LoxMap>();
+    for (std::uint32_t i = 0; i < instr.C; ++i) {
+        const auto& key = regs[instr.B + 2 * i];
+        if (!LoxMap::Hashable(key)) {
+            Throw(line, "Map keys must be numbers, strings or booleans.");
+        }
+        map->Insert(key, regs[instr.B + 2 * i + 1]);
+    }
+    regs[instr.A] = std::move(map);
+}
+
+// The element at index of a list or array of size elements.
+static std::size_t ListIndex(std::size_t size, const TOut& index,
+                             std::uint32_t line) {
+    auto* number = std::get_if<double>(&index);
+    if (number == nullptr) {
+        Throw(line, "List index must be a number.");
+    }
+    if (!(*number >= 0 && *number < size)) {
+        Throw(line, "List index out of range.");
+    }
+    auto i = static_cast<std::size_t>(*number);
+    if (i != *number) {
+        Throw(line, "List index must be an integer.");
+    }
+    return i;
+}
+
+void Interpreter::GetIndex(TOut* regs, const Instruction& instr,
+                           std::uint32_t line) {
+    // Copied first, the list or map might be in the destination.
     TOut value;
-    if (rstm.Value != nullptr) {
-        value = Eval(*rstm.Value);
+    if (auto* list = std::get_if<std::shared_ptr<LoxList>>(&regs[instr.B])) {
+        const auto& elements = (*list)->Elements;
+        value = elements[ListIndex(std::size(elements), regs[instr.C], line)];
+    } else if (auto* array = std::get_if<std::shared_ptr<LoxF64Array>>(
+                   &regs[instr.B])) {
+        const auto& elements = (*array)->Elements;
+        value = elements[ListIndex(std::size(elements), regs[instr.C], line)];
+    } else if (auto* map =
+                   std::get_if<std::shared_ptr<LoxMap>>(&regs[instr.B])) {
+        const auto* found = (*map)->Find(regs[instr.C]);
+        if (found == nullptr) {
+            Throw(line, "Key not found.");
+        }
+        value = *found;
+    } else {
+        Throw(line, "Only lists, maps and F64Arrays can be indexed.");
     }
+    regs[instr.A] = std::move(value);
+}
 
-    throw Return(value);
+void Interpreter::SetIndex(TOut* regs, const Instruction& instr,
+                           std::uint32_t line) {
+    if (auto* list = std::get_if<std::shared_ptr<LoxList>>(&regs[instr.A])) {
+        auto& elements = (*list)->Elements;
+        elements[ListIndex(std::size(elements), regs[instr.B], line)] =
+            regs[instr.C];
+    } else if (auto* array = std::get_if<std::shared_ptr<LoxF64Array>>(
+                   &regs[instr.A])) {
+        auto& elements = (*array)->Elements;
+        auto i = ListIndex(std::size(elements), regs[instr.B], line);
+        auto* number = std::get_if<double>(&regs[instr.C]);
+        if (number == nullptr) {
+            Throw(line, "F64Array elements must be numbers.");
+        }
+        elements[i] = *number;
+    } else if (auto* map =
+                   std::get_if<std::shared_ptr<LoxMap>>(&regs[instr.A])) {
+        if (!LoxMap::Hashable(regs[instr.B])) {
+            Throw(line, "Map keys must be numbers, strings or booleans.");
+        }
+        (*map)->Insert(regs[instr.B], regs[instr.C]);
+    } else {
+        Throw(line, "Only lists, maps and F64Arrays can be indexed.");
+    }
 }
 
-void Interpreter::Resolve(Expression* expr, int depth) {
-    locals.insert({expr, depth});
+std::string Interpreter::FrameName(const CallFrame& frame) {
+    return frame.Proto != nullptr
+               ? Symbols().Name(frame.Proto->Name.Value) + "()"s
+               : "script"s;
+}
+
+std::vector<std::string> Interpreter::Backtrace(std::uint32_t line) const {
+    // Deep recursion shows the calls at both ends.
+    constexpr std::size_t kEnds = 8;
+    std::vector<std::string> trace;
+    auto depth = std::size(frames_);
+    for (std::size_t i = 0; i < depth; ++i) {
+        const auto& frame = frames_[depth - 1 - i];
+        if (i > 0) {
+            // Outer frames stopped right after their call.
+            line = frame.Code->Line(frame.Ip - 1);
+        }
+        if (depth > 2 * kEnds && i == kEnds) {
+            trace.push_back("... " + std::to_string(depth - 2 * kEnds) +
+                            " more calls");
+            i = depth - kEnds - 1;
+            continue;
+        }
+        trace.push_back("[line "s + std::to_string(line) + "] in " +
+                        FrameName(frame));
+    }
+    return trace;
+}
+
+void Interpreter::TierUp(Chunk& chunk) {
+#if defined(LOX_JIT)
+    if (JitEnabled && chunk.Native == nullptr && !chunk.JitFailed &&
+        ++chunk.Hotness >= Jit::kHotness) {
+        chunk.Native = Jit::Compile(chunk);
+        chunk.JitFailed = chunk.Native == nullptr;
+    }
+#endif
 }
 
-TOut Interpreter::LookUpVariable(Token name, Variable* expr) {
-    auto distance = locals.find(expr);
-    if (distance != locals.end()) {
-        return environment_->GetAt(distance->second, name);
+// The dispatch loop either jumps straight from one instruction to the next
+// through a table of label addresses (computed goto, a GCC/Clang extension),
+// or goes around a switch. With computed goto every instruction ends with
+// its own indirect jump, which predicts a lot better than the single shared
+// jump of a switch.
+#if defined(LOX_COMPUTED_GOTO)
+#define VM_LABEL(name) &&op_##name,
+#define VM_DISPATCH()                                                \
+    static const void* const dispatch_table[] = {                    \
+        LOX_OPCODES(VM_LABEL)};                                      \
+    VM_NEXT();
+#define VM_CASE(name) op_##name:
+#define VM_NEXT()                                                    \
+    do {                                                             \
+        instr = *ip++;                                               \
+        ++Stats.Instructions;                                        \
+        goto* dispatch_table[static_cast<std::size_t>(instr.Op)];    \
+    } while (false)
+#else
+#define VM_DISPATCH() \
+    for (;;)          \
+        switch (instr = *ip++, ++Stats.Instructions, instr.Op)
+#define VM_CASE(name) case OpCode::name:
+#define VM_NEXT() continue
+#endif
+
+// R[A] = R[B] op R[C], with a fast path for two doubles. Anything else is
+// handled by EvalBinExpr.
+#define VM_BINARY(token_type, op)                                         \
+    {                                                                    \
+        const TOut& l = regs[instr.B];                                   \
+        const TOut& r = regs[instr.C];                                   \
+        auto* a = std::get_if<double>(&l);                               \
+        auto* b = std::get_if<double>(&r);                               \
+        if (a != nullptr && b != nullptr) {                              \
+            auto result = *a op * b;                                     \
+            regs[instr.A] = result;                                      \
+        } else {                                                         \
+            regs[instr.A] = EvalBinExpr(token(token_type), l, r);        \
+            CountString(regs[instr.A]);                                  \
+        }                                                                \
+        VM_NEXT();                                                       \
+    }
+
+// R[A] = R[B] op R[C] on registers the compiler proved to hold doubles.
+#define VM_NUMERIC(op)                                                   \
+    {                                                                    \
+        regs[instr.A] = Number(regs[instr.B]) op Number(regs[instr.C]);  \
+        VM_NEXT();                                                       \
+    }
+
+TOut Interpreter::Run(std::size_t base_depth) {
+    CallFrame* frame = &frames_.back();
+    Chunk* chunk = frame->Code.get();
+    const Instruction* ip = frame->Ip;
+    // Registers of the frame.
+    TOut* regs = stack_.data() + frame->Base;
+    Instruction instr;
+
+    // Tokens for error messages and the generic operator implementations.
+    auto token = [&](TokenType type) {
+        return Token{0, 0, type, chunk->Line(ip - 1), 0};
+    };
+    auto name = [&] {
+        return Token{0, 0, TokenType::IDENTIFIER, chunk->Line(ip - 1),
+                     instr.B};
+    };
+
+#if defined(LOX_JIT)
+    // Instruction to enter the machine code of chunk at.
+    std::uint32_t native_ip = 0;
+    if (chunk->Native != nullptr) {
+        native_ip = static_cast<std::uint32_t>(ip - chunk->Code.data());
+        goto enter_native;
     }
-    return Globals->Get(name);
+#endif
+
+    VM_DISPATCH() {
+        VM_CASE(MOVE) {
+            ++Stats.ValuesCopied;
+            regs[instr.A] = regs[instr.B];
+            VM_NEXT();
+        }
+        VM_CASE(CONSTANT) {
+            regs[instr.A] = (*chunk->Constants)[instr.B];
+            VM_NEXT();
+        }
+        VM_CASE(TRUE) {
+            regs[instr.A] = true;
+            VM_NEXT();
+        }
+        VM_CASE(FALSE) {
+            regs[instr.A] = false;
+            VM_NEXT();
+        }
+        VM_CASE(GET_CELL) {
+            ++Stats.ValuesCopied;
+            regs[instr.A] = *cells_[frame->Cells + instr.B];
+            VM_NEXT();
+        }
+        VM_CASE(SET_CELL) {
+            ++Stats.ValuesCopied;
+            *cells_[frame->Cells + instr.B] = regs[instr.A];
+            VM_NEXT();
+        }
+        VM_CASE(NEW_CELL) {
+            ++Stats.CellsAllocated;
+            Stats.BytesAllocated += sizeof(TOut);
+            cells_[frame->Cells + instr.B] =
+                std::make_shared<TOut>(regs[instr.A]);
+            VM_NEXT();
+        }
+        VM_CASE(GET_UPVALUE) {
+            ++Stats.ValuesCopied;
+            regs[instr.A] = *frame->Upvalues[instr.B];
+            VM_NEXT();
+        }
+        VM_CASE(SET_UPVALUE) {
+            ++Stats.ValuesCopied;
+            *frame->Upvalues[instr.B] = regs[instr.A];
+            VM_NEXT();
+        }
+        VM_CASE(GET_GLOBAL) {
+            ++Stats.ValuesCopied;
+            regs[instr.A] = Globals->Get(name());
+            VM_NEXT();
+        }
+        VM_CASE(SET_GLOBAL) {
+            ++Stats.ValuesCopied;
+            Globals->Assign(name(), regs[instr.A]);
+            VM_NEXT();
+        }
+        VM_CASE(DEFINE_GLOBAL) {
+            Globals->Define(instr.B, regs[instr.A]);
+            VM_NEXT();
+        }
+        VM_CASE(ADD) VM_BINARY(TokenType::PLUS, +)
+        VM_CASE(SUBTRACT) VM_BINARY(TokenType::MINUS, -)
+        VM_CASE(MULTIPLY) VM_BINARY(TokenType::STAR, *)
+        VM_CASE(DIVIDE) VM_BINARY(TokenType::SLASH, /)
+        VM_CASE(GREATER) VM_BINARY(TokenType::GREATER, >)
+        VM_CASE(GREATER_EQUAL) VM_BINARY(TokenType::GREATER_EQUAL, >=)
+        VM_CASE(LESS) VM_BINARY(TokenType::LESS, <)
+        VM_CASE(LESS_EQUAL) VM_BINARY(TokenType::LESS_EQUAL, <=)
+        VM_CASE(EQUAL) VM_BINARY(TokenType::EQUAL_EQUAL, ==)
+        VM_CASE(NOT_EQUAL) VM_BINARY(TokenType::BANG_EQUAL, !=)
+        VM_CASE(NOT) {
+            if (auto* b = std::get_if<bool>(&regs[instr.B])) {
+                regs[instr.A] = !*b;
+            } else {
+                regs[instr.A] =
+                    EvalUnExpr(token(TokenType::BANG), regs[instr.B]);
+            }
+            VM_NEXT();
+        }
+        VM_CASE(NEGATE) {
+            if (auto* d = std::get_if<double>(&regs[instr.B])) {
+                regs[instr.A] = -*d;
+            } else {
+                regs[instr.A] =
+                    EvalUnExpr(token(TokenType::MINUS), regs[instr.B]);
+            }
+            VM_NEXT();
+        }
+        VM_CASE(ADD_NUM) VM_NUMERIC(+)
+        VM_CASE(SUBTRACT_NUM) VM_NUMERIC(-)
+        VM_CASE(MULTIPLY_NUM) VM_NUMERIC(*)
+        VM_CASE(DIVIDE_NUM) VM_NUMERIC(/)
+        VM_CASE(GREATER_NUM) VM_NUMERIC(>)
+        VM_CASE(GREATER_EQUAL_NUM) VM_NUMERIC(>=)
+        VM_CASE(LESS_NUM) VM_NUMERIC(<)
+        VM_CASE(LESS_EQUAL_NUM) VM_NUMERIC(<=)
+        VM_CASE(EQUAL_NUM) VM_NUMERIC(==)
+        VM_CASE(NOT_EQUAL_NUM) VM_NUMERIC(!=)
+        VM_CASE(NEGATE_NUM) {
+            regs[instr.A] = -Number(regs[instr.B]);
+            VM_NEXT();
+        }
+        VM_CASE(PRINT) {
+            Print(regs[instr.A]);
+            VM_NEXT();
+        }
+        VM_CASE(JUMP) {
+            const Instruction* target = chunk->Code.data() + instr.B;
+#if defined(LOX_JIT)
+            if (target < ip) {
+                // A loop, switch to machine code once it's hot.
+                TierUp(*chunk);
+                if (chunk->Native != nullptr) {
+                    native_ip = instr.B;
+                    goto enter_native;
+                }
+            }
+#endif
+            ip = target;
+            VM_NEXT();
+        }
+        VM_CASE(JUMP_IF_FALSE) {
+            if (!IsTruth(regs[instr.A])) {
+                ip = chunk->Code.data() + instr.B;
+            }
+            VM_NEXT();
+        }
+        VM_CASE(JUMP_IF_TRUE) {
+            if (IsTruth(regs[instr.A])) {
+                ip = chunk->Code.data() + instr.B;
+            }
+            VM_NEXT();
+        }
+        VM_CASE(FUNCTION) {
+            const auto& proto = chunk->Functions[instr.B];
+            const auto& captures = proto->Code->Captures;
+            std::shared_ptr<std::vector<LoxFunction::Cell>> upvalues;
+            if (!std::empty(captures)) {
+                upvalues = std::make_shared<std::vector<LoxFunction::Cell>>();
+                upvalues->reserve(std::size(captures));
+                ++Stats.ClosuresAllocated;
+                Stats.BytesAllocated +=
+                    std::size(captures) * sizeof(LoxFunction::Cell);
+                for (const auto& capture : captures) {
+                    upvalues->push_back(
+                        capture.FromCell ? cells_[frame->Cells + capture.Index]
+                                         : frame->Upvalues[capture.Index]);
+                }
+            }
+            regs[instr.A] = LoxFunction(proto, std::move(upvalues));
+            VM_NEXT();
+        }
+        VM_CASE(CALL) {
+            // The arguments become the first registers of the callee.
+            frame->Ip = ip;
+            if (!CallValue(frame->Base + instr.A, instr.B,
+                           chunk->Line(ip - 1))) {
+                goto called;
+            }
+        enter_frame:
+            // A new frame, or the innermost one of a coroutine resumed.
+            frame = &frames_.back();
+            chunk = frame->Code.get();
+            ip = frame->Ip;
+            regs = stack_.data() + frame->Base;
+#if defined(LOX_JIT)
+            if (chunk->Native != nullptr) {
+                native_ip = static_cast<std::uint32_t>(ip - chunk->Code.data());
+                goto enter_native;
+            }
+#endif
+            VM_NEXT();
+        }
+        VM_CASE(INVOKE) {
+            frame->Ip = ip;
+            if (Invoke(frame->Base + instr.A, instr.B,
+                       chunk->Caches[instr.C], chunk->Line(ip - 1))) {
+                goto enter_frame;
+            }
+        called:
+            if (waiting_.Operation != nullptr) {
+                // An async native started an operation. Park the script
+                // until it is done, unless this Run nests in a call from
+                // native code, which can only wait for it here.
+                if (base_depth == 0) {
+                    return false;
+                }
+                Block();
+            }
+            VM_NEXT();
+        }
+        VM_CASE(CLASS) {
+            regs[instr.A] = std::make_shared<LoxClass>(instr.B);
+            VM_NEXT();
+        }
+        VM_CASE(INHERIT) {
+            auto* superclass =
+                std::get_if<std::shared_ptr<LoxClass>>(&regs[instr.B]);
+            if (superclass == nullptr) {
+                throw RunTimeError{token(TokenType::LESS),
+                                   "Superclass must be a class."};
+            }
+            auto& klass = std::get<std::shared_ptr<LoxClass>>(regs[instr.A]);
+            klass->Superclass = *superclass;
+            klass->Methods = (*superclass)->Methods;
+            VM_NEXT();
+        }
+        VM_CASE(METHOD) {
+            std::get<std::shared_ptr<LoxClass>>(regs[instr.A])
+                ->Methods.insert_or_assign(instr.C,
+                                           std::get<LoxFunction>(regs[instr.B]));
+            VM_NEXT();
+        }
+        VM_CASE(GET_PROPERTY) {
+            GetProperty(regs, instr, chunk->Caches[instr.C],
+                        chunk->Line(ip - 1));
+            VM_NEXT();
+        }
+        VM_CASE(SET_PROPERTY) {
+            SetProperty(regs, instr, chunk->Caches[instr.C],
+                        chunk->Line(ip - 1));
+            VM_NEXT();
+        }
+        VM_CASE(LIST) {
+            NewList(regs, instr);
+            VM_NEXT();
+        }
+        VM_CASE(MAP) {
+            NewMap(regs, instr, chunk->Line(ip - 1));
+            VM_NEXT();
+        }
+        VM_CASE(GET_INDEX) {
+            GetIndex(regs, instr, chunk->Line(ip - 1));
+            VM_NEXT();
+        }
+        VM_CASE(SET_INDEX) {
+            SetIndex(regs, instr, chunk->Line(ip - 1));
+            VM_NEXT();
+        }
+        VM_CASE(GET_SUPER) {
+            const auto& superclass =
+                std::get<std::shared_ptr<LoxClass>>(regs[instr.B]);
+            const auto* method = superclass->FindMethod(instr.C);
+            if (method == nullptr) {
+                throw RunTimeError{token(TokenType::DOT),
+                                   "Undefined property '"s +
+                                       Symbols().Name(instr.C) + "'."s};
+            }
+            auto receiver =
+                std::get<std::shared_ptr<LoxInstance>>(regs[instr.B + 1]);
+            regs[instr.A] = std::make_shared<const LoxBoundMethod>(
+                LoxBoundMethod{std::move(receiver), *method});
+            VM_NEXT();
+        }
+        VM_CASE(RETURN) {
+#if defined(LOX_JIT)
+        do_return:
+#endif
+            TOut result = std::move(regs[instr.A]);
+            // Methods return into the register of the instance, functions
+            // into that of the callee.
+            bool method = frame->Proto != nullptr && frame->Proto->Method;
+            auto callee_slot = frame->Base - (method ? 0 : 1);
+            if (Trace != nullptr) {
+                Trace->Exit(FrameName(*frame));
+            }
+            cells_.resize(frame->Cells);
+            frames_.pop_back();
+            if (!std::empty(resumptions_) &&
+                std::size(frames_) == resumptions_.back().Depth) {
+                // The function of a coroutine returned, to the resume.
+                resumptions_.back().Coroutine->Status =
+                    LoxCoroutine::State::DONE;
+                callee_slot = resumptions_.back().Callee;
+                resumptions_.pop_back();
+            }
+            if (std::size(frames_) == base_depth) {
+                return result;
+            }
+
+            frame = &frames_.back();
+            chunk = frame->Code.get();
+            ip = frame->Ip;
+            regs = stack_.data() + frame->Base;
+            stack_[callee_slot] = std::move(result);
+            VM_NEXT();
+        }
+        VM_CASE(YIELD) {
+            if (std::empty(resumptions_)) {
+                Throw(chunk->Line(ip - 1), "Can only yield in a coroutine.");
+            }
+            // Run calls from native code nest on the C++ stack, which can't
+            // be suspended.
+            if (resumptions_.back().Depth < base_depth) {
+                Throw(chunk->Line(ip - 1), "Can't yield across a native call.");
+            }
+            frame->Ip = ip;
+            TOut value = std::move(regs[instr.A]);
+            auto callee = resumptions_.back().Callee;
+            Suspend();
+            if (std::size(frames_) == base_depth) {
+                return value;
+            }
+
+            frame = &frames_.back();
+            chunk = frame->Code.get();
+            ip = frame->Ip;
+            regs = stack_.data() + frame->Base;
+            stack_[callee] = std::move(value);
+            VM_NEXT();
+        }
+#if defined(LOX_JIT)
+    enter_native : {
+        // Keep the code alive, this frame might be the one that throws it
+        // away while outer frames still run it.
+        auto native = chunk->Native;
+        auto exit = native->Run(regs, *this, native_ip);
+        frame = &frames_.back();
+        regs = stack_.data() + frame->Base;
+        if (exit & NativeCode::kReturned) {
+            instr.A = static_cast<std::uint16_t>(exit & ~NativeCode::kReturned);
+            goto do_return;
+        }
+
+        if (jit_error_ != nullptr) {
+            std::rethrow_exception(std::exchange(jit_error_, nullptr));
+        }
+        // A guard failed, or a call nests too deep, let the interpreter
+        // handle the instruction.
+        ip = chunk->Code.data() + exit;
+        if (ip->Op != OpCode::CALL && ip->Op != OpCode::INVOKE &&
+            ++chunk->Deopts >= Jit::kMaxDeopts) {
+            chunk->Native = nullptr;
+            chunk->JitFailed = true;
+        }
+        VM_NEXT();
+    }
+#endif
+    }
+}
+
+#undef VM_LABEL
+#undef VM_DISPATCH
+#undef VM_CASE
+#undef VM_NEXT
+#undef VM_BINARY
+#undef VM_NUMERIC
+
+void Interpreter::Resolve(Expression* expr, int depth) {
+    locals.insert({expr, depth});
 }
 
 }  // namespace lox
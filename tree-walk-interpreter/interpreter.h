@@ -1,71 +1,201 @@
 #pragma once
+#include <exception>
 #include <functional>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <string>
 #include <variant>
-#include <map>
+#include <vector>
 
+#include "callFrame.h"
+#include "chunk.h"
 #include "environment.h"
+#include "eventLoop.h"
 #include "foldVisitor.h"
 #include "loxFunction.h"
+#include "metrics.h"
+#include "natives.h"
+#include "output.h"
 #include "runtimeerror.h"
 #include "syntaxTree.h"
+#include "valueStack.h"
 #include "variantOverload.h"
 
 namespace lox {
 
-void ReportRunTimeError(RunTimeError);
+void ReportRunTimeError(RunTimeError, std::ostream& os);
 
-class Interpreter : public StatementVisitor, public ExpressionVisitor {
+// Executes the bytecode the Compiler produces for resolved statements.
+class Interpreter {
    public:
-    using TOut = std::variant<bool, double, std::string, LoxFunction>;
-    std::stack<TOut> stack_;
+    using TOut = LoxFunction::TOut;
+    enum class RunState { FINISHED, FAILED, WAITING };
+    static constexpr std::size_t kMaxFrames = 10000;
     std::shared_ptr<Environment<TOut>> Globals =
         std::make_shared<Environment<TOut>>();
     std::map<Expression*, int> locals;
+    // Compile hot functions to machine code, if the build has a JIT.
+    bool JitEnabled = true;
+    // Calls deeper than this are a stack overflow error.
+    std::size_t MaxFrames = kMaxFrames;
+    Metrics Stats;
+    // Where calls and errors are traced to, if anywhere.
+    Tracer* Trace = nullptr;
+    // What print and runtime errors write, to standard output unless the
+    // host sets another sink. Flushed after a runtime error.
+    Output Out;
+    // Where the script parks while async natives wait, set by
+    // EventLoop::Spawn. Without one they block until their operation is
+    // done.
+    EventLoop* Loop = nullptr;
 
    private:
-    std::shared_ptr<Environment<TOut>> environment_ =
-        Globals;  // By default use global scope.
+    friend class Jit;
+    friend class Snapshot;
+
+    // A coroutine being resumed: its frames are those of frames_ from
+    // Depth on, and its registers those of stack_ from Start on. What it
+    // yields or returns goes to register Callee.
+    struct Resumption {
+        std::shared_ptr<LoxCoroutine> Coroutine;
+        std::size_t Depth;
+        std::size_t Start;
+        std::size_t Callee;
+    };
+    // The call of an async native a parked script waits for, its result
+    // goes to register Callee.
+    struct Waiting {
+        std::shared_ptr<Pending> Operation;
+        std::size_t Callee;
+        std::uint32_t Line;
+    };
+
+    // The register windows of all frames, each one starts right after the
+    // callee register of the caller.
+    ValueStack<TOut> stack_;
+    std::vector<CallFrame> frames_;
+    // The cells of the captured locals of all frames.
+    std::vector<LoxFunction::Cell> cells_;
+    // Constants of all code compiled so far.
+    std::shared_ptr<ConstantPool> constants_ =
+        std::make_shared<ConstantPool>();
+    // Error thrown while running machine code, which can't unwind through it.
+    std::exception_ptr jit_error_;
+    // Calls from machine code that are running, see Jit::Call.
+    std::uint32_t native_calls_ = 0;
+    // The coroutines being resumed, the innermost last.
+    std::vector<Resumption> resumptions_;
+    Waiting waiting_;
+    // Where async natives wait without a Loop.
+    std::unique_ptr<EventLoop> own_loop_;
+    // The size of the stack when the script started.
+    std::size_t script_base_ = 0;
     static TOut EvalUnExpr(Token t, TOut v);
-    static TOut EvalLiteral(Literal& l);
     static TOut EvalBinExpr(Token t, TOut l, TOut r);
-    static TOut EvalGroup(TOut v) { return v; }
-    void EvalAnd(Logical& lg);
-    void EvalOr(Logical& lg);
-    TOut LookUpVariable(Token name, Variable* expr);
+    void Print(const TOut& value);
+    // Count value in Stats if it is a string the interpreter just created.
+    void CountString(const TOut& value);
 
-   public:
-    virtual void Visit(Literal& l) override;
-    virtual void Visit(BinaryExpr& b) override;
-    virtual void Visit(UnaryExpr& u) override;
-    virtual void Visit(Grouping& g) override;
-    virtual void Visit(Variable& var) override;
-    virtual void Visit(Assignment& ass) override;
-    virtual void Visit(Logical& lg) override;
-    virtual void Visit(Call& c) override;
+    // Run the frames from depth on until the one at depth returns, or the
+    // coroutine resumed at depth yields, and return what it returns or
+    // yields. Run(0) also returns when the script parks.
+    TOut Run(std::size_t depth);
+    // Run the script set up by enter until it finishes, fails or parks.
+    RunState Execute(const std::function<void()>& enter);
+    // Count a call or loop iteration of chunk, and compile it once it's hot.
+    void TierUp(Chunk& chunk);
+    // Push the frame of a call to function, whose registers start at base
+    // and hold the arg_count arguments. The stack grows to fit all registers
+    // of the function.
+    void PushFrame(const LoxFunction& function, std::size_t arg_count,
+                   std::size_t base, std::uint32_t line);
+    // Call the value in register callee of the stack with the arg_count
+    // arguments after it. Return whether a frame was pushed, creating an
+    // instance of a class without initializer doesn't need one.
+    bool CallValue(std::size_t callee, std::size_t arg_count,
+                   std::uint32_t line);
+    // resume() of the coroutine in register callee + 1 of the stack: push
+    // its frames on top of the current frame, to run until it yields or
+    // returns what goes in register callee.
+    void Resume(std::size_t callee, std::uint32_t line);
+    // Move the frames of the innermost coroutine being resumed from
+    // frames_, stack_ and cells_ into it, and back.
+    void Suspend();
+    void Restore(LoxCoroutine& coroutine, std::size_t start,
+                 std::uint32_t line);
+    // Call the async native function with the arguments after register
+    // callee, and park the script on waiting_ until it is done, or put the
+    // result in register callee if it already is.
+    void Await(const LoxNative& function, std::size_t callee,
+               std::uint32_t line);
+    // Wait for the operation of waiting_ without parking, and put its
+    // result in its register.
+    void Block();
+    // Put the result of the operation of waiting_ in its register, or throw
+    // the error it failed with.
+    void Deliver();
+    // Call method cache.Name of the instance in register receiver of the
+    // stack, like CallValue.
+    bool Invoke(std::size_t receiver, std::size_t arg_count,
+                PropertyCache& cache, std::uint32_t line);
+    // GET_PROPERTY and SET_PROPERTY on the registers of the current frame.
+    void GetProperty(TOut* regs, const Instruction& instr,
+                     PropertyCache& cache, std::uint32_t line);
+    void SetProperty(TOut* regs, const Instruction& instr,
+                     PropertyCache& cache, std::uint32_t line);
+    // Fill cache with where its property is on instance.
+    static void Lookup(const LoxInstance& instance, PropertyCache& cache,
+                       std::uint32_t line);
+    // LIST, MAP, GET_INDEX and SET_INDEX on the registers of the current
+    // frame.
+    static void NewList(TOut* regs, const Instruction& instr);
+    static void NewMap(TOut* regs, const Instruction& instr,
+                       std::uint32_t line);
+    static void GetIndex(TOut* regs, const Instruction& instr,
+                         std::uint32_t line);
+    static void SetIndex(TOut* regs, const Instruction& instr,
+                         std::uint32_t line);
 
-    virtual void Visit(PrintStatement& p) override;
-    virtual void Visit(ExpressionStatement& s) override;
-    void ExecuteBlock(std::vector<std::shared_ptr<Statement>>&,
-                      std::shared_ptr<Environment<TOut>>& env);
-    virtual void Visit(Block& blk) override;
-    virtual void Visit(IfStatement& ifm) override;
-    virtual void Visit(While& whl) override;
-    virtual void Visit(FunctionDeclaration& whl) override;
-    virtual void Visit(VariableDeclaration& var) override;
-    virtual void Visit(ReturnStatement&) override;
+    // Grow the stack to size registers, or throw a stack overflow error at
+    // line.
+    void Grow(std::size_t size, std::uint32_t line);
+    static std::string FrameName(const CallFrame& frame);
+    // Describe the calls in frames_, for an error at line in the innermost.
+    std::vector<std::string> Backtrace(std::uint32_t line) const;
 
-    TOut Eval(Expression& expr) {
-        expr.Accept(*this);
-        auto answer = stack_.top();
-        stack_.pop();
-        return answer;
+   public:
+    // Registers the stack has room for, shared by all frames.
+    static constexpr std::size_t kStackCapacity = 1 << 18;
+
+    explicit Interpreter(std::size_t stack_capacity = kStackCapacity)
+        : stack_(stack_capacity) {
+        DefineNatives(*Globals);
     }
 
     void Resolve(Expression* expr, int depth);
 
-    void Execute(Statement& s) { s.Accept(*this); }
-    void Interpret(std::vector<std::unique_ptr<Statement>>& statements);
+    // Call function from native code, and return what it returns.
+    TOut Call(const LoxFunction& function, std::vector<TOut>& arguments);
+
+    // Compile statements, with the local variables resolved in locals, and
+    // run them until they finish, a runtime error stops them, or they park
+    // on Loop in an async native. Continue runs a parked script on once
+    // the operation it waits for is done.
+    RunState Start(const std::vector<std::unique_ptr<Statement>>& statements,
+                   const std::map<Expression*, int>& locals);
+    RunState Continue();
+    // The operation a parked script waits for, null if it isn't parked.
+    const std::shared_ptr<Pending>& Awaiting() const {
+        return waiting_.Operation;
+    }
+
+    // Like Start, but wait for the operations of async natives, and return
+    // false if a runtime error stopped the statements.
+    bool Interpret(const std::vector<std::unique_ptr<Statement>>& statements,
+                   const std::map<Expression*, int>& locals);
+    bool Interpret(const std::vector<std::unique_ptr<Statement>>& statements) {
+        return Interpret(statements, locals);
+    }
 };
 }  // namespace lox
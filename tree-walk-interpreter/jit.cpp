@@ -0,0 +1,622 @@
+#include "jit.h"
+
+#include <sys/mman.h>
+
+#include <cstring>
+#include <string>
+
+#include "assembler.h"
+
+namespace lox {
+
+static_assert(std::is_same_v<std::variant_alternative_t<0, Interpreter::TOut>,
+                             bool> &&
+                  std::is_same_v<
+                      std::variant_alternative_t<1, Interpreter::TOut>, double>,
+              "The JIT writes bools and doubles by variant index");
+
+namespace {
+
+constexpr std::uint8_t kBoolIndex = 0;
+constexpr std::uint8_t kDoubleIndex = 1;
+
+}  // namespace
+
+NativeCode::~NativeCode() { munmap(memory_, size_); }
+
+std::uint32_t NativeCode::Run(Interpreter::TOut* registers,
+                              Interpreter& interpreter,
+                              std::uint32_t ip) const {
+    using Entry = std::uint32_t (*)(Interpreter::TOut*, Interpreter*,
+                                    const void*);
+    auto* code = static_cast<const std::uint8_t*>(memory_);
+    return reinterpret_cast<Entry>(memory_)(registers, &interpreter,
+                                            code + entries_[ip]);
+}
+
+std::int32_t Jit::index_offset_ = -1;
+
+bool Jit::LayoutSupported() {
+    static const bool supported = [] {
+        TOut probe = 1.0;
+        if (static_cast<void*>(std::get_if<double>(&probe)) != &probe) {
+            return false;
+        }
+        probe = false;
+        if (static_cast<void*>(std::get_if<bool>(&probe)) != &probe) {
+            return false;
+        }
+
+        // Look for the byte that holds the index of every alternative.
+        TOut probes[] = {false, 1.0, LoxString("probe")};
+        for (std::size_t offset = sizeof(double); offset < sizeof(TOut);
+             ++offset) {
+            bool matches = true;
+            for (auto& p : probes) {
+                auto* bytes = reinterpret_cast<const std::uint8_t*>(&p);
+                matches = matches && bytes[offset] == p.index();
+            }
+            if (matches) {
+                index_offset_ = static_cast<std::int32_t>(offset);
+                break;
+            }
+        }
+        if (index_offset_ < 0) {
+            return false;
+        }
+
+        // Turn a bool into a double the way the machine code does.
+        TOut v = false;
+        double d = 2.5;
+        auto* bytes = reinterpret_cast<std::uint8_t*>(&v);
+        std::memcpy(bytes, &d, sizeof(d));
+        bytes[index_offset_] = kDoubleIndex;
+        auto* result = std::get_if<double>(&v);
+        return result != nullptr && *result == 2.5;
+    }();
+    return supported;
+}
+
+void Jit::StoreDouble(TOut* dst, double value) { *dst = value; }
+
+void Jit::StoreBool(TOut* dst, bool value) { *dst = value; }
+
+void Jit::Move(TOut* dst, const TOut* src) { *dst = *src; }
+
+void Jit::LoadConstant(Interpreter* interpreter, std::uint32_t pc) {
+    const auto& frame = interpreter->frames_.back();
+    const auto& instr = frame.Code->Code[pc];
+    interpreter->stack_[frame.Base + instr.A] =
+        (*frame.Code->Constants)[instr.B];
+}
+
+bool Jit::GetGlobal(Interpreter* interpreter, std::uint32_t pc) {
+    const auto& frame = interpreter->frames_.back();
+    const auto& instr = frame.Code->Code[pc];
+    Token name{0, 0, TokenType::IDENTIFIER, frame.Code->Lines[pc], instr.B};
+    try {
+        interpreter->stack_[frame.Base + instr.A] =
+            interpreter->Globals->Get(name);
+        return true;
+    } catch (RunTimeError&) {
+        // The interpreter raises it again.
+        return false;
+    } catch (...) {
+        interpreter->jit_error_ = std::current_exception();
+        return false;
+    }
+}
+
+bool Jit::SetGlobal(Interpreter* interpreter, std::uint32_t pc) {
+    const auto& frame = interpreter->frames_.back();
+    const auto& instr = frame.Code->Code[pc];
+    Token name{0, 0, TokenType::IDENTIFIER, frame.Code->Lines[pc], instr.B};
+    try {
+        interpreter->Globals->Assign(
+            name, interpreter->stack_[frame.Base + instr.A]);
+        return true;
+    } catch (RunTimeError&) {
+        return false;
+    } catch (...) {
+        interpreter->jit_error_ = std::current_exception();
+        return false;
+    }
+}
+
+bool Jit::Print(Interpreter* interpreter, std::uint32_t pc) {
+    const auto& frame = interpreter->frames_.back();
+    try {
+        interpreter->Print(
+            interpreter->stack_[frame.Base + frame.Code->Code[pc].A]);
+        return true;
+    } catch (...) {
+        interpreter->jit_error_ = std::current_exception();
+        return false;
+    }
+}
+
+bool Jit::GetProperty(Interpreter* interpreter, std::uint32_t pc) {
+    const auto& frame = interpreter->frames_.back();
+    auto& chunk = *frame.Code;
+    const auto& instr = chunk.Code[pc];
+    try {
+        interpreter->GetProperty(interpreter->stack_.data() + frame.Base,
+                                 instr, chunk.Caches[instr.C],
+                                 chunk.Lines[pc]);
+        return true;
+    } catch (RunTimeError&) {
+        return false;
+    } catch (...) {
+        interpreter->jit_error_ = std::current_exception();
+        return false;
+    }
+}
+
+bool Jit::SetProperty(Interpreter* interpreter, std::uint32_t pc) {
+    const auto& frame = interpreter->frames_.back();
+    auto& chunk = *frame.Code;
+    const auto& instr = chunk.Code[pc];
+    try {
+        interpreter->SetProperty(interpreter->stack_.data() + frame.Base,
+                                 instr, chunk.Caches[instr.C],
+                                 chunk.Lines[pc]);
+        return true;
+    } catch (RunTimeError&) {
+        return false;
+    } catch (...) {
+        interpreter->jit_error_ = std::current_exception();
+        return false;
+    }
+}
+
+bool Jit::Collection(Interpreter* interpreter, std::uint32_t pc) {
+    const auto& frame = interpreter->frames_.back();
+    const auto& chunk = *frame.Code;
+    const auto& instr = chunk.Code[pc];
+    auto* regs = interpreter->stack_.data() + frame.Base;
+    try {
+        switch (instr.Op) {
+            case OpCode::LIST:
+                Interpreter::NewList(regs, instr);
+                break;
+            case OpCode::MAP:
+                Interpreter::NewMap(regs, instr, chunk.Lines[pc]);
+                break;
+            case OpCode::GET_INDEX:
+                Interpreter::GetIndex(regs, instr, chunk.Lines[pc]);
+                break;
+            default:
+                Interpreter::SetIndex(regs, instr, chunk.Lines[pc]);
+                break;
+        }
+        return true;
+    } catch (RunTimeError&) {
+        return false;
+    } catch (...) {
+        interpreter->jit_error_ = std::current_exception();
+        return false;
+    }
+}
+
+Jit::TOut* Jit::Call(Interpreter* interpreter, std::uint32_t pc) {
+    // Errors can't unwind through the machine code, so they are passed on
+    // to the interpreter loop that entered it.
+    try {
+        // Every call from machine code nests a Run on the C++ stack. Past
+        // the limit the machine code exits to the interpreter at the call
+        // instead, which makes it without recursing. So do calls in a
+        // coroutine, which could yield, and calls of a script on an event
+        // loop, which could park.
+        if (interpreter->native_calls_ >= kMaxNativeCalls ||
+            !std::empty(interpreter->resumptions_) ||
+            interpreter->Loop != nullptr) {
+            return nullptr;
+        }
+        auto& frame = interpreter->frames_.back();
+        auto base = frame.Base;
+        auto code = frame.Code;
+        const auto& instr = code->Code[pc];
+        auto line = code->Lines[pc];
+
+        frame.Ip = code->Code.data() + pc + 1;
+        auto depth = std::size(interpreter->frames_);
+        bool pushed =
+            instr.Op == OpCode::INVOKE
+                ? interpreter->Invoke(base + instr.A, instr.B,
+                                      code->Caches[instr.C], line)
+                : interpreter->CallValue(base + instr.A, instr.B, line);
+        if (!pushed) {
+            return interpreter->stack_.data() + base;
+        }
+        ++interpreter->native_calls_;
+        TOut result;
+        try {
+            result = interpreter->Run(depth);
+        } catch (...) {
+            --interpreter->native_calls_;
+            throw;
+        }
+        --interpreter->native_calls_;
+
+        interpreter->stack_[base + instr.A] = std::move(result);
+        return interpreter->stack_.data() + base;
+    } catch (...) {
+        interpreter->jit_error_ = std::current_exception();
+        return nullptr;
+    }
+}
+
+class Jit::Translator {
+    using Reg = X64Assembler::Reg;
+    using Xmm = X64Assembler::Xmm;
+    using Condition = X64Assembler::Condition;
+    using Label = X64Assembler::Label;
+
+    const Chunk& chunk_;
+    X64Assembler a_;
+    std::vector<Label> instructions_;  // Label of each instruction.
+    std::vector<Label> deopts_;        // Exit to the interpreter at each one.
+    Label epilogue_;
+    std::uint32_t pc_ = 0;
+
+    static std::int32_t Value(std::uint32_t r) {
+        return static_cast<std::int32_t>(r * sizeof(TOut));
+    }
+    static std::int32_t Index(std::uint32_t r) {
+        return Value(r) + index_offset_;
+    }
+
+    template <typename F>
+    void CallHelper(F* helper) {
+        a_.Mov(Reg::RAX, reinterpret_cast<std::uint64_t>(helper));
+        a_.Call(Reg::RAX);
+    }
+    // helper(interpreter, pc)
+    template <typename F>
+    void CallRuntime(F* helper) {
+        a_.Mov(Reg::RDI, Reg::R12);
+        a_.Mov(Reg::RSI, pc_);
+        CallHelper(helper);
+    }
+
+    void GuardDouble(std::uint32_t r) {
+        a_.CmpByte(Index(r), kDoubleIndex);
+        a_.Jcc(Condition::NE, deopts_[pc_]);
+    }
+    void GuardBool(std::uint32_t r) {
+        a_.CmpByte(Index(r), kBoolIndex);
+        a_.Jcc(Condition::NE, deopts_[pc_]);
+    }
+
+    // Store xmm0 in register r. Registers that hold a bool or a double are
+    // overwritten in place, anything else has to be destroyed first.
+    void StoreDouble(std::uint32_t r) {
+        auto slow = a_.NewLabel();
+        auto done = a_.NewLabel();
+        a_.CmpByte(Index(r), kDoubleIndex);
+        a_.Jcc(Condition::A, slow);
+        a_.Movsd(Value(r), Xmm::XMM0);
+        a_.StoreByte(Index(r), kDoubleIndex);
+        a_.Jmp(done);
+        a_.Bind(slow);
+        a_.Lea(Reg::RDI, Value(r));
+        CallHelper(&Jit::StoreDouble);
+        a_.Bind(done);
+    }
+    // Store al in register r.
+    void StoreBool(std::uint32_t r) {
+        auto slow = a_.NewLabel();
+        auto done = a_.NewLabel();
+        a_.CmpByte(Index(r), kDoubleIndex);
+        a_.Jcc(Condition::A, slow);
+        a_.StoreByte(Value(r), Reg::RAX);
+        a_.StoreByte(Index(r), kBoolIndex);
+        a_.Jmp(done);
+        a_.Bind(slow);
+        a_.Movzx(Reg::RSI, Reg::RAX);
+        a_.Lea(Reg::RDI, Value(r));
+        CallHelper(&Jit::StoreBool);
+        a_.Bind(done);
+    }
+
+    // Instructions on operands type inference proved to be doubles need no
+    // guards.
+    static bool Numeric(OpCode op) {
+        return op >= OpCode::ADD_NUM && op <= OpCode::NEGATE_NUM;
+    }
+
+    void LoadOperands(const Instruction& instr) {
+        if (!Numeric(instr.Op)) {
+            GuardDouble(instr.B);
+            GuardDouble(instr.C);
+        }
+        a_.Movsd(Xmm::XMM0, Value(instr.B));
+        a_.Movsd(Xmm::XMM1, Value(instr.C));
+    }
+    void Compare(const Instruction& instr, Condition c, bool swap) {
+        LoadOperands(instr);
+        if (swap) {
+            a_.Ucomisd(Xmm::XMM1, Xmm::XMM0);
+        } else {
+            a_.Ucomisd(Xmm::XMM0, Xmm::XMM1);
+        }
+        a_.Setcc(c, Reg::RAX);
+        StoreBool(instr.A);
+    }
+    // An unordered comparison, with a NaN, sets the parity flag, which
+    // makes == false and != true.
+    void Equality(const Instruction& instr, bool equal) {
+        LoadOperands(instr);
+        a_.Ucomisd(Xmm::XMM0, Xmm::XMM1);
+        if (equal) {
+            a_.Setcc(Condition::E, Reg::RAX);
+            a_.Setcc(Condition::NP, Reg::RCX);
+            a_.And(Reg::RAX, Reg::RCX);
+        } else {
+            a_.Setcc(Condition::NE, Reg::RAX);
+            a_.Setcc(Condition::P, Reg::RCX);
+            a_.Or(Reg::RAX, Reg::RCX);
+        }
+        StoreBool(instr.A);
+    }
+
+    // Only bool true is truthy.
+    void JumpIfTruth(std::uint32_t r, bool truth, Label target) {
+        if (truth) {
+            auto skip = a_.NewLabel();
+            a_.CmpByte(Index(r), kBoolIndex);
+            a_.Jcc(Condition::NE, skip);
+            a_.CmpByte(Value(r), 0);
+            a_.Jcc(Condition::NE, target);
+            a_.Bind(skip);
+        } else {
+            a_.CmpByte(Index(r), kBoolIndex);
+            a_.Jcc(Condition::NE, target);
+            a_.CmpByte(Value(r), 0);
+            a_.Jcc(Condition::E, target);
+        }
+    }
+
+    void Translate(const Instruction& instr) {
+        switch (instr.Op) {
+            case OpCode::MOVE: {
+                auto generic = a_.NewLabel();
+                auto done = a_.NewLabel();
+                a_.CmpByte(Index(instr.B), kDoubleIndex);
+                a_.Jcc(Condition::NE, generic);
+                a_.Movsd(Xmm::XMM0, Value(instr.B));
+                StoreDouble(instr.A);
+                a_.Jmp(done);
+                a_.Bind(generic);
+                a_.Lea(Reg::RDI, Value(instr.A));
+                a_.Lea(Reg::RSI, Value(instr.B));
+                CallHelper(&Jit::Move);
+                a_.Bind(done);
+                break;
+            }
+            case OpCode::CONSTANT: {
+                auto* d = std::get_if<double>(&(*chunk_.Constants)[instr.B]);
+                if (d == nullptr) {
+                    CallRuntime(&Jit::LoadConstant);
+                    break;
+                }
+                std::uint64_t bits;
+                std::memcpy(&bits, d, sizeof(bits));
+                a_.Mov(Reg::RAX, bits);
+                a_.Movq(Xmm::XMM0, Reg::RAX);
+                StoreDouble(instr.A);
+                break;
+            }
+            case OpCode::TRUE:
+            case OpCode::FALSE:
+                a_.Mov(Reg::RAX,
+                       std::uint32_t{instr.Op == OpCode::TRUE ? 1u : 0u});
+                StoreBool(instr.A);
+                break;
+            case OpCode::GET_GLOBAL:
+            case OpCode::SET_GLOBAL:
+                CallRuntime(instr.Op == OpCode::GET_GLOBAL ? &Jit::GetGlobal
+                                                           : &Jit::SetGlobal);
+                a_.Test(Reg::RAX, Reg::RAX);
+                a_.Jcc(Condition::E, deopts_[pc_]);
+                break;
+            case OpCode::ADD:
+            case OpCode::SUBTRACT:
+            case OpCode::MULTIPLY:
+            case OpCode::DIVIDE:
+            case OpCode::ADD_NUM:
+            case OpCode::SUBTRACT_NUM:
+            case OpCode::MULTIPLY_NUM:
+            case OpCode::DIVIDE_NUM:
+                LoadOperands(instr);
+                if (instr.Op == OpCode::ADD || instr.Op == OpCode::ADD_NUM) {
+                    a_.Addsd(Xmm::XMM0, Xmm::XMM1);
+                } else if (instr.Op == OpCode::SUBTRACT ||
+                           instr.Op == OpCode::SUBTRACT_NUM) {
+                    a_.Subsd(Xmm::XMM0, Xmm::XMM1);
+                } else if (instr.Op == OpCode::MULTIPLY ||
+                           instr.Op == OpCode::MULTIPLY_NUM) {
+                    a_.Mulsd(Xmm::XMM0, Xmm::XMM1);
+                } else {
+                    a_.Divsd(Xmm::XMM0, Xmm::XMM1);
+                }
+                StoreDouble(instr.A);
+                break;
+            case OpCode::GREATER:
+            case OpCode::GREATER_NUM:
+                Compare(instr, Condition::A, false);
+                break;
+            case OpCode::GREATER_EQUAL:
+            case OpCode::GREATER_EQUAL_NUM:
+                Compare(instr, Condition::AE, false);
+                break;
+            case OpCode::LESS:
+            case OpCode::LESS_NUM:
+                Compare(instr, Condition::A, true);
+                break;
+            case OpCode::LESS_EQUAL:
+            case OpCode::LESS_EQUAL_NUM:
+                Compare(instr, Condition::AE, true);
+                break;
+            case OpCode::EQUAL:
+            case OpCode::EQUAL_NUM:
+                Equality(instr, true);
+                break;
+            case OpCode::NOT_EQUAL:
+            case OpCode::NOT_EQUAL_NUM:
+                Equality(instr, false);
+                break;
+            case OpCode::NOT:
+                GuardBool(instr.B);
+                a_.LoadByte(Reg::RAX, Value(instr.B));
+                a_.Xor(Reg::RAX, 1);
+                StoreBool(instr.A);
+                break;
+            case OpCode::NEGATE:
+            case OpCode::NEGATE_NUM:
+                if (!Numeric(instr.Op)) {
+                    GuardDouble(instr.B);
+                }
+                a_.Movsd(Xmm::XMM0, Value(instr.B));
+                a_.Mov(Reg::RAX, std::uint64_t{1} << 63);
+                a_.Movq(Xmm::XMM1, Reg::RAX);
+                a_.Xorpd(Xmm::XMM0, Xmm::XMM1);
+                StoreDouble(instr.A);
+                break;
+            case OpCode::PRINT:
+                CallRuntime(&Jit::Print);
+                a_.Test(Reg::RAX, Reg::RAX);
+                a_.Jcc(Condition::E, deopts_[pc_]);
+                break;
+            case OpCode::JUMP:
+                a_.Jmp(instructions_[instr.B]);
+                break;
+            case OpCode::JUMP_IF_FALSE:
+            case OpCode::JUMP_IF_TRUE:
+                JumpIfTruth(instr.A, instr.Op == OpCode::JUMP_IF_TRUE,
+                            instructions_[instr.B]);
+                break;
+            case OpCode::GET_PROPERTY:
+            case OpCode::SET_PROPERTY:
+                CallRuntime(instr.Op == OpCode::GET_PROPERTY
+                                ? &Jit::GetProperty
+                                : &Jit::SetProperty);
+                a_.Test(Reg::RAX, Reg::RAX);
+                a_.Jcc(Condition::E, deopts_[pc_]);
+                break;
+            case OpCode::LIST:
+            case OpCode::MAP:
+            case OpCode::GET_INDEX:
+            case OpCode::SET_INDEX:
+                CallRuntime(&Jit::Collection);
+                a_.Test(Reg::RAX, Reg::RAX);
+                a_.Jcc(Condition::E, deopts_[pc_]);
+                break;
+            case OpCode::CALL:
+            case OpCode::INVOKE:
+                CallRuntime(&Jit::Call);
+                a_.Test(Reg::RAX, Reg::RAX);
+                a_.Jcc(Condition::E, deopts_[pc_]);
+                a_.Mov(Reg::RBX, Reg::RAX);
+                break;
+            case OpCode::RETURN:
+                a_.Mov(Reg::RAX, NativeCode::kReturned | instr.A);
+                a_.Jmp(epilogue_);
+                break;
+            default:
+                // Rejected by Translatable.
+                break;
+        }
+    }
+
+   public:
+    explicit Translator(const Chunk& chunk) : chunk_(chunk) {}
+
+    bool Translatable() const {
+        for (const auto& instr : chunk_.Code) {
+            switch (instr.Op) {
+                case OpCode::GET_CELL:
+                case OpCode::SET_CELL:
+                case OpCode::NEW_CELL:
+                case OpCode::GET_UPVALUE:
+                case OpCode::SET_UPVALUE:
+                case OpCode::DEFINE_GLOBAL:
+                case OpCode::FUNCTION:
+                case OpCode::CLASS:
+                case OpCode::INHERIT:
+                case OpCode::METHOD:
+                case OpCode::GET_SUPER:
+                case OpCode::YIELD:
+                    return false;
+                default:
+                    break;
+            }
+        }
+        return true;
+    }
+
+    // The code takes the registers, the interpreter and the address of the
+    // instruction to start at.
+    std::vector<std::uint8_t> Translate(std::vector<std::uint32_t>& entries) {
+        for (std::size_t i = 0; i < std::size(chunk_.Code); ++i) {
+            instructions_.push_back(a_.NewLabel());
+            deopts_.push_back(a_.NewLabel());
+        }
+        epilogue_ = a_.NewLabel();
+
+        // Three pushes keep the stack 16 byte aligned for the helpers.
+        a_.Push(Reg::RBX);
+        a_.Push(Reg::R12);
+        a_.Push(Reg::R13);
+        a_.Mov(Reg::RBX, Reg::RDI);
+        a_.Mov(Reg::R12, Reg::RSI);
+        a_.Jmp(Reg::RDX);
+
+        for (pc_ = 0; pc_ < std::size(chunk_.Code); ++pc_) {
+            a_.Bind(instructions_[pc_]);
+            Translate(chunk_.Code[pc_]);
+        }
+
+        for (pc_ = 0; pc_ < std::size(chunk_.Code); ++pc_) {
+            a_.Bind(deopts_[pc_]);
+            a_.Mov(Reg::RAX, pc_);
+            a_.Jmp(epilogue_);
+        }
+        a_.Bind(epilogue_);
+        a_.Pop(Reg::R13);
+        a_.Pop(Reg::R12);
+        a_.Pop(Reg::RBX);
+        a_.Ret();
+
+        for (auto label : instructions_) {
+            entries.push_back(static_cast<std::uint32_t>(a_.Position(label)));
+        }
+        return a_.Finish();
+    }
+};
+
+std::shared_ptr<NativeCode> Jit::Compile(const Chunk& chunk) {
+    Translator translator(chunk);
+    if (!LayoutSupported() || !translator.Translatable()) {
+        return nullptr;
+    }
+
+    std::vector<std::uint32_t> entries;
+    auto code = translator.Translate(entries);
+
+    // Write the code, then make it executable but no longer writable.
+    auto size = std::size(code);
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        return nullptr;
+    }
+    std::memcpy(memory, code.data(), size);
+    if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, size);
+        return nullptr;
+    }
+    return std::make_shared<NativeCode>(memory, size, std::move(entries));
+}
+
+}  // namespace lox
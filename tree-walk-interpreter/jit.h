@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "chunk.h"
+#include "interpreter.h"
+
+namespace lox {
+
+// Machine code of a chunk in executable memory. It can be entered before any
+// instruction, works on the registers of the interpreter frame in place, and
+// exits either because the function returned or to let the interpreter
+// continue at some instruction.
+class NativeCode {
+    void* memory_;
+    std::size_t size_;
+    // Offset of the code of each instruction.
+    std::vector<std::uint32_t> entries_;
+
+   public:
+    // Exit code when the function returned, anything else is the
+    // instruction to continue at.
+    static constexpr std::uint32_t kReturned = 0x80000000;  // | register
+
+    NativeCode(void* memory, std::size_t size,
+               std::vector<std::uint32_t> entries)
+        : memory_(memory), size_(size), entries_(std::move(entries)) {}
+    ~NativeCode();
+    NativeCode(const NativeCode&) = delete;
+    NativeCode& operator=(const NativeCode&) = delete;
+
+    std::uint32_t Run(Interpreter::TOut* registers, Interpreter& interpreter,
+                      std::uint32_t ip) const;
+};
+
+// Baseline compiler from register bytecode to x86-64.
+//
+// Every instruction is translated on its own. Arithmetic speculates that its
+// operands are doubles and guards on the type of each, a failed guard exits
+// to the interpreter at that instruction, which handles the general case.
+// Globals, printing, properties and calls go through helpers of the
+// interpreter. Chunks that use environments or create classes are left to
+// the interpreter.
+class Jit {
+   public:
+    // Calls plus loop iterations before a chunk is compiled.
+    static constexpr std::uint32_t kHotness = 1000;
+    // Failed guards before the machine code of a chunk is thrown away.
+    static constexpr std::uint32_t kMaxDeopts = 100;
+    // Calls from machine code nested on the C++ stack, deeper calls are left
+    // to the interpreter.
+    static constexpr std::uint32_t kMaxNativeCalls = 256;
+
+    // Return nullptr if the chunk can't be compiled.
+    static std::shared_ptr<NativeCode> Compile(const Chunk& chunk);
+
+   private:
+    using TOut = Interpreter::TOut;
+
+    // The machine code writes doubles and bools straight into the variants,
+    // which needs to know where the variant keeps its index.
+    static bool LayoutSupported();
+    static std::int32_t index_offset_;
+
+    // Helpers called by the machine code, pc is the instruction they
+    // implement. The ones returning bool return false to exit to the
+    // interpreter, before anything happened for a runtime error, which it
+    // raises again. Other errors can't unwind through the machine code, they
+    // are kept in jit_error_ for the interpreter to rethrow.
+    static void StoreDouble(TOut* dst, double value);
+    static void StoreBool(TOut* dst, bool value);
+    static void Move(TOut* dst, const TOut* src);
+    static void LoadConstant(Interpreter* interpreter, std::uint32_t pc);
+    static bool GetGlobal(Interpreter* interpreter, std::uint32_t pc);
+    static bool SetGlobal(Interpreter* interpreter, std::uint32_t pc);
+    static bool Print(Interpreter* interpreter, std::uint32_t pc);
+    static bool GetProperty(Interpreter* interpreter, std::uint32_t pc);
+    static bool SetProperty(Interpreter* interpreter, std::uint32_t pc);
+    // LIST, MAP, GET_INDEX and SET_INDEX.
+    static bool Collection(Interpreter* interpreter, std::uint32_t pc);
+    // Return the registers of the frame, which move if the stack grows, or
+    // nullptr to exit to the interpreter at the call, which rethrows what it
+    // threw if anything. Implements CALL and INVOKE.
+    static TOut* Call(Interpreter* interpreter, std::uint32_t pc);
+
+    class Translator;
+};
+
+}  // namespace lox
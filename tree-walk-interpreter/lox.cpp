@@ -1,47 +1,131 @@
 #include "lox.h"
 
+#include <chrono>
+#include <fstream>
 #include <iostream>
+#include <stdexcept>
+#include <utility>
 
 #include "interpreter.h"
+#include "optimizer.h"
 #include "parser.h"
 #include "scanner.h"
 #include "resolver.h"
+#include "snapshot.h"
 
 namespace lox {
 
-static bool HadError = false;
-static bool HadRunTimeError = false;
 static Interpreter intp;
+static bool DumpAst = false;
+// Scripts can be prepared on several threads at once, each reports its
+// errors to the stream of the Prepare running on its thread.
+static thread_local std::ostream* ErrorOut = nullptr;
+static thread_local bool HadError = false;
 
 void Report(int line, std::string where, std::string message) {
-    std::cout << "[line " << line << "] Error" << where << ": " << message
-              << std::endl;
+    auto& os = ErrorOut != nullptr ? *ErrorOut : intp.Out;
+    os << "[line " << line << "] Error" << where << ": " << message << '\n';
     HadError = true;
 }
 
 void Error(int line, std::string message) { Report(line, "", message); }
 
-void ReportRunTimeError(RunTimeError re) {
-    std::cout << re.ErrorMsg << std::endl
-              << "line[" << re.Operator.Line << "]" << std::endl;
-    HadRunTimeError = true;
+std::ostream* SetErrorOut(std::ostream* out) {
+    return std::exchange(ErrorOut, out);
 }
 
-void Run(const std::string& source) {
+void ReportRunTimeError(RunTimeError re, std::ostream& os) {
+    os << re.ErrorMsg << "\nline[" << re.Operator.Line << "]\n";
+    // Errors in the script itself are clear from the line.
+    if (std::size(re.Backtrace) > 1) {
+        for (auto& call : re.Backtrace) {
+            os << call << '\n';
+        }
+    }
+}
+
+// Add the time since start to phase, and trace it as name.
+static void EndPhase(Metrics::Duration& phase, Tracer* trace, const char* name,
+                     std::chrono::steady_clock::time_point start) {
+    phase += std::chrono::steady_clock::now() - start;
+    if (trace != nullptr) {
+        trace->Phase(name, start);
+    }
+}
+
+std::unique_ptr<Program> Prepare(const std::string& source, std::ostream& out,
+                                 Metrics& stats, Tracer* trace) {
+    HadError = false;
+    struct Restore {
+        std::ostream* Out;
+        ~Restore() { SetErrorOut(Out); }
+    } restore{SetErrorOut(&out)};
+
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
     Scanner scanner(source);
     auto tokens = scanner.ScanTokens();
+    EndPhase(stats.Scan, trace, "scan", start);
+
+    start = Clock::now();
     Parser p(tokens);
-    auto statements = p.Parse();
+    auto program = std::make_unique<Program>();
+    program->Statements = p.Parse();
+    EndPhase(stats.Parse, trace, "parse", start);
+
+    if (HadError) {
+        return nullptr;
+    }
+
+    start = Clock::now();
+    Resolver resolver(program->Locals);
+    resolver.Resolve(program->Statements);
+    EndPhase(stats.Resolve, trace, "resolve", start);
 
     if (HadError) {
-        HadError=false;
-        return;
+        return nullptr;
     }
 
-    Resolver resolver(intp);
-    resolver.Resolve(statements);
+    if (DumpAst) {
+        out << "before:\n";
+        print(program->Statements, out);
+    }
+    start = Clock::now();
+    Optimizer(program->Locals).Optimize(program->Statements);
+    EndPhase(stats.Optimize, trace, "optimize", start);
+    if (DumpAst) {
+        out << "after:\n";
+        print(program->Statements, out);
+    }
+    return program;
+}
+
+void Run(const std::string& source) {
+    auto program = Prepare(source, intp.Out, intp.Stats, intp.Trace);
+    if (program != nullptr) {
+        intp.Interpret(program->Statements, program->Locals);
+    }
+    // Each script, or line of the prompt, shows its output once it's done.
+    intp.Out.flush();
+}
+
+void SetDumpAst(bool dump) { DumpAst = dump; }
+
+const Metrics& GetMetrics() { return intp.Stats; }
+
+void SetTracer(Tracer* tracer) { intp.Trace = tracer; }
+
+void SaveSnapshot(const std::string& path) {
+    std::ofstream file(path, std::ios::binary);
+    Snapshot::Write(intp, file);
+    file.close();
+    if (!file) {
+        throw std::runtime_error("Can't write snapshot " + path + ".");
+    }
+}
 
-    intp.Interpret(statements);
+void LoadSnapshot(const std::string& path) {
+    Snapshot::Open(path).Restore(intp);
 }
 
 }  // namespace lox
@@ -1,14 +1,43 @@
 #pragma once
 
+#include <memory>
+#include <ostream>
 #include <string>
 
+#include "program.h"
+
 namespace lox {
 
 struct RunTimeError;
+struct Metrics;
+class Tracer;
 
 void Report(int line, std::string where, std::string message);
-void ReportRunTimeError(RunTimeError re);
+void ReportRunTimeError(RunTimeError re, std::ostream& os);
 void Error(int line, std::string message);
+// Report compile errors on this thread to out, or to the output of Run if
+// it is null, and return where they went before.
+std::ostream* SetErrorOut(std::ostream* out);
+// Scan, parse, resolve and optimize source, with the phases counted in
+// stats and traced to trace if it isn't null. Compile errors, and the
+// statements if they are dumped, are written to out. Return null if there
+// were errors. Scripts can be prepared on several threads at once.
+std::unique_ptr<Program> Prepare(const std::string& source, std::ostream& out,
+                                 Metrics& stats, Tracer* trace = nullptr);
+// Run source, and flush what it printed.
 void Run(const std::string& source);
+// Print the statements before and after they are optimized.
+void SetDumpAst(bool dump);
+// What the scripts run so far cost.
+const Metrics& GetMetrics();
+// Trace the phases of running scripts, calls and errors to tracer, or
+// nothing if it is null.
+void SetTracer(Tracer* tracer);
+// Write a Snapshot of the globals of the scripts run so far to path.
+// Throws std::runtime_error if it can't be written.
+void SaveSnapshot(const std::string& path);
+// Start from the globals in the Snapshot at path, before running any
+// script. Throws std::runtime_error if it can't be read.
+void LoadSnapshot(const std::string& path);
 
 }
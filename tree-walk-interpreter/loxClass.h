@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+#include "loxFunction.h"
+#include "symbolTable.h"
+
+namespace lox {
+
+// The layout of the fields of an instance: which slot each field is in.
+// Instances start out with the empty shape of their class, and adding a
+// field moves an instance on to the shape with that field added. Instances
+// that get the same fields in the same order share their shape, so a slot
+// looked up for a shape is right for all instances of it, which is what the
+// inline caches of property accesses rely on.
+class Shape {
+    std::unordered_map<Symbol, std::uint32_t> slots_;
+    // The shapes with one more field, created the first time an instance of
+    // this shape gets it.
+    std::unordered_map<Symbol, std::shared_ptr<Shape>> transitions_;
+
+   public:
+    static constexpr std::uint32_t kNotFound = 0xFFFFFFFF;
+
+    std::uint32_t Find(Symbol name) const {
+        auto slot = slots_.find(name);
+        return slot != slots_.end() ? slot->second : kNotFound;
+    }
+    std::size_t Size() const { return std::size(slots_); }
+    // The names of the fields, in the order of their slots.
+    std::vector<Symbol> Fields() const {
+        std::vector<Symbol> fields(Size());
+        for (auto [name, slot] : slots_) {
+            fields[slot] = name;
+        }
+        return fields;
+    }
+
+    // The shape of an instance of this one that gets field name, which
+    // goes in the next slot.
+    const std::shared_ptr<Shape>& Add(Symbol name) {
+        auto& next = transitions_[name];
+        if (next == nullptr) {
+            next = std::make_shared<Shape>();
+            next->slots_ = slots_;
+            next->slots_.emplace(name, static_cast<std::uint32_t>(Size()));
+        }
+        return next;
+    }
+};
+
+class LoxClass {
+   public:
+    Symbol Name;
+    std::shared_ptr<LoxClass> Superclass;
+    // Inherited methods are copied in, so looking one up is a single find.
+    std::unordered_map<Symbol, LoxFunction> Methods;
+    // The shape new instances start with. All shapes of instances of the
+    // class grow from it, so shapes are never shared between classes.
+    std::shared_ptr<Shape> EmptyShape = std::make_shared<Shape>();
+
+    explicit LoxClass(Symbol name) : Name(name) {}
+
+    // Return nullptr if the class has no method name.
+    const LoxFunction* FindMethod(Symbol name) const {
+        auto method = Methods.find(name);
+        return method != Methods.end() ? &method->second : nullptr;
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const LoxClass& c) {
+        return os << Symbols().Name(c.Name);
+    }
+};
+
+class LoxInstance {
+   public:
+    using TOut = LoxFunction::TOut;
+
+    std::shared_ptr<LoxClass> Class;
+    std::shared_ptr<Shape> Layout;
+    std::vector<TOut> Fields;  // In the slots of Layout.
+
+    explicit LoxInstance(std::shared_ptr<LoxClass> c)
+        : Class(std::move(c)), Layout(Class->EmptyShape) {}
+
+    friend std::ostream& operator<<(std::ostream& os, const LoxInstance& i) {
+        return os << *i.Class << " instance";
+    }
+};
+
+// A method read from an instance, calling it calls the method on that
+// instance.
+struct LoxBoundMethod {
+    std::shared_ptr<LoxInstance> Receiver;
+    LoxFunction Method;
+};
+
+}  // namespace lox
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "callFrame.h"
+#include "loxFunction.h"
+
+namespace lox {
+
+// A function that runs in steps: each resume runs it until it yields or
+// returns. In between, the calls it is in the middle of are kept here,
+// moved off the stack of the interpreter, and moved back on top of the
+// stack of whoever resumes it next.
+struct LoxCoroutine {
+    using TOut = LoxFunction::TOut;
+    enum class State : std::uint8_t { SUSPENDED, RUNNING, DONE };
+
+    State Status = State::SUSPENDED;
+    // The function or bound method to call on the first resume.
+    TOut Body;
+    // The suspended frames, their Base relative to the first of Registers
+    // and their Cells to the first of Cells. Empty before the first resume.
+    std::vector<CallFrame> Frames;
+    std::vector<TOut> Registers;
+    std::vector<LoxFunction::Cell> Cells;
+
+    explicit LoxCoroutine(TOut body) : Body(std::move(body)) {}
+
+    bool Started() const { return !std::empty(Frames); }
+};
+
+}  // namespace lox
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <vector>
+
+namespace lox {
+
+// Array of doubles for numeric code. Natives work on whole arrays with the
+// vector kernels of simd.h, scripts index them like lists.
+class LoxF64Array {
+   public:
+    std::vector<double> Elements;
+
+    LoxF64Array() = default;
+    explicit LoxF64Array(std::vector<double> elements)
+        : Elements(std::move(elements)) {}
+};
+
+}  // namespace lox
@@ -2,27 +2,20 @@
 
 #include "environment.h"
 #include "interpreter.h"
-#include "return.h"
+#include "symbolTable.h"
 #include <iostream>
 
 namespace lox {
 
 LoxFunction::TOut LoxFunction::Call(lox::Interpreter& interpreter,
                                     std::vector<TOut>& arguments) {
-    for (int i = 0; i < std::size(declaration_.Params); ++i) {
-        closure_->Define(declaration_.Params[i].Lexeme, arguments[i]);
-    }
-
-    try {
-        interpreter.ExecuteBlock(declaration_.Body, closure_);
-    } catch (Return r) {
-        return r.Value;
-    }
-    return LoxFunction::TOut{"Nil"};
+    return interpreter.Call(*this, arguments);
 }
 
+std::size_t LoxFunction::Arity() const { return proto_->Arity; }
+
 std::string LoxFunction::ToString() {
-    return std::string("<fn ") + declaration_.Name.Lexeme + ">";
+    return std::string("<fn ") + Symbols().Name(proto_->Name.Value) + ">";
 }
 
 }  // namespace lox
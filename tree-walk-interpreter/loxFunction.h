@@ -4,23 +4,53 @@
 #include <string>
 #include <variant>
 #include <vector>
+#include "loxString.h"
 #include "syntaxTree.h"
-#include "environment.h"
 
 namespace lox {
 class Interpreter;
+struct FunctionProto;
+class LoxClass;
+class LoxInstance;
+struct LoxBoundMethod;
+class LoxList;
+class LoxMap;
+class LoxF64Array;
+struct LoxCoroutine;
+struct LoxNative;
 
+// A closure: the function it was created from, and the variables it
+// captured. Copies share both, so passing a function around is cheap.
 class LoxFunction {
-    using TOut =
-        std::variant<bool, double, std::string, LoxFunction>;
-    FunctionDeclaration declaration_;
-    std::shared_ptr<Environment<TOut>> closure_;
+   public:
+    using TOut = std::variant<bool, double, LoxString, LoxFunction,
+                              std::shared_ptr<LoxClass>,
+                              std::shared_ptr<LoxInstance>,
+                              std::shared_ptr<const LoxBoundMethod>,
+                              std::shared_ptr<LoxList>,
+                              std::shared_ptr<LoxMap>,
+                              std::shared_ptr<LoxF64Array>, const LoxNative*,
+                              std::shared_ptr<LoxCoroutine>>;
+    // A captured variable, shared by the call that declared it and the
+    // closures that use it.
+    using Cell = std::shared_ptr<TOut>;
+
+   private:
+    std::shared_ptr<const FunctionProto> proto_;
+    // The cells of the enclosing functions the body uses, see
+    // Chunk::Captures. Null if it uses none.
+    std::shared_ptr<const std::vector<Cell>> upvalues_;
 
    public:
-    std::size_t Arity() const { return std::size(declaration_.Params); }
+    LoxFunction(std::shared_ptr<const FunctionProto> proto,
+                std::shared_ptr<const std::vector<Cell>> upvalues)
+        : proto_(std::move(proto)), upvalues_(std::move(upvalues)) {}
 
-    LoxFunction(FunctionDeclaration decl, std::shared_ptr<Environment<TOut>>& closure) 
-        : declaration_(decl), closure_(closure){}
+    std::size_t Arity() const;
+    const FunctionProto& Proto() const { return *proto_; }
+    const Cell* Upvalues() const {
+        return upvalues_ != nullptr ? upvalues_->data() : nullptr;
+    }
 
     TOut Call(lox::Interpreter& interpreter, std::vector<TOut>& arguments);
 
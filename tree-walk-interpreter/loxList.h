@@ -0,0 +1,22 @@
+#pragma once
+
+#include <vector>
+
+#include "loxFunction.h"
+
+namespace lox {
+
+// List of the language. The elements are stored inline in one growable
+// array, so indexing is a bounds check and a load.
+class LoxList {
+   public:
+    using TOut = LoxFunction::TOut;
+
+    std::vector<TOut> Elements;
+
+    LoxList() = default;
+    explicit LoxList(std::vector<TOut> elements)
+        : Elements(std::move(elements)) {}
+};
+
+}  // namespace lox
@@ -0,0 +1,132 @@
+#include "loxMap.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace lox {
+
+static constexpr std::size_t kMinCapacity = 8;
+// Set in every hash, so occupied slots never hold 0.
+static constexpr std::uint32_t kOccupied = 0x80000000u;
+
+bool LoxMap::Hashable(const TOut& key) {
+    return std::holds_alternative<double>(key) ||
+           std::holds_alternative<LoxString>(key) ||
+           std::holds_alternative<bool>(key);
+}
+
+std::uint32_t LoxMap::Hash(const TOut& key) {
+    if (auto* s = std::get_if<LoxString>(&key)) {
+        return s->Hash();
+    }
+    if (auto* d = std::get_if<double>(&key)) {
+        // Equal numbers hash the same, 0 and -0 too.
+        double number = *d == 0 ? 0.0 : *d;
+        std::uint64_t bits;
+        std::memcpy(&bits, &number, sizeof(bits));
+        // The finalizer of MurmurHash3, integers differ in their high bits
+        // only.
+        bits ^= bits >> 33;
+        bits *= 0xff51afd7ed558ccdULL;
+        bits ^= bits >> 33;
+        bits *= 0xc4ceb9fe1a85ec53ULL;
+        bits ^= bits >> 33;
+        return static_cast<std::uint32_t>(bits) | kOccupied;
+    }
+    return kOccupied | (std::get<bool>(key) ? 1 : 2);
+}
+
+static bool SameKey(const LoxMap::TOut& l, const LoxMap::TOut& r) {
+    if (l.index() != r.index()) {
+        return false;
+    }
+    if (auto* d = std::get_if<double>(&l)) {
+        return *d == std::get<double>(r);
+    }
+    if (auto* s = std::get_if<LoxString>(&l)) {
+        return *s == std::get<LoxString>(r);
+    }
+    return std::get<bool>(l) == std::get<bool>(r);
+}
+
+std::size_t LoxMap::Probe(const TOut& key, std::uint32_t hash) const {
+    auto mask = std::size(hashes_) - 1;
+    for (auto i = hash & mask;; i = (i + 1) & mask) {
+        if (hashes_[i] == 0 ||
+            (hashes_[i] == hash && SameKey(entries_[i].Key, key))) {
+            return i;
+        }
+    }
+}
+
+const LoxMap::TOut* LoxMap::Find(const TOut& key) const {
+    if (size_ == 0 || !Hashable(key)) {
+        return nullptr;
+    }
+    auto i = Probe(key, Hash(key));
+    return hashes_[i] != 0 ? &entries_[i].Value : nullptr;
+}
+
+void LoxMap::Insert(const TOut& key, TOut value) {
+    // At most three quarters full, so probe sequences stay short.
+    if ((size_ + 1) * 4 > std::size(hashes_) * 3) {
+        Grow();
+    }
+    auto hash = Hash(key);
+    auto i = Probe(key, hash);
+    if (hashes_[i] == 0) {
+        hashes_[i] = hash;
+        entries_[i].Key = key;
+        ++size_;
+    }
+    entries_[i].Value = std::move(value);
+}
+
+bool LoxMap::Erase(const TOut& key) {
+    if (size_ == 0 || !Hashable(key)) {
+        return false;
+    }
+    auto mask = std::size(hashes_) - 1;
+    auto hole = Probe(key, Hash(key));
+    if (hashes_[hole] == 0) {
+        return false;
+    }
+
+    // Move back the entries after the hole that can't be found anymore
+    // past it: those whose home slot isn't between the hole and them.
+    for (auto i = (hole + 1) & mask; hashes_[i] != 0; i = (i + 1) & mask) {
+        auto home = hashes_[i] & mask;
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            hashes_[hole] = hashes_[i];
+            entries_[hole] = std::move(entries_[i]);
+            hole = i;
+        }
+    }
+    hashes_[hole] = 0;
+    entries_[hole] = Entry{};
+    --size_;
+    return true;
+}
+
+void LoxMap::Grow() {
+    auto capacity = std::max(kMinCapacity, 2 * std::size(hashes_));
+    auto hashes = std::exchange(hashes_,
+                                std::vector<std::uint32_t>(capacity, 0));
+    auto entries = std::exchange(entries_, std::vector<Entry>(capacity));
+
+    auto mask = capacity - 1;
+    for (std::size_t j = 0; j < std::size(hashes); ++j) {
+        if (hashes[j] == 0) {
+            continue;
+        }
+        auto i = hashes[j] & mask;
+        while (hashes_[i] != 0) {
+            i = (i + 1) & mask;
+        }
+        hashes_[i] = hashes[j];
+        entries_[i] = std::move(entries[j]);
+    }
+}
+
+}  // namespace lox
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "loxFunction.h"
+
+namespace lox {
+
+// Map of the language, a hash table with open addressing and linear
+// probing. Probing only reads the hashes, which are kept apart from the
+// entries: a cache line holds sixteen of them, and a key is compared only
+// when its full hash matches. Removing shifts the entries after it back
+// instead of leaving tombstones, so lookups never get slower over time.
+//
+// Keys are numbers, strings and booleans. Strings cache their hash, so
+// looking up with a string constant hashes it once.
+class LoxMap {
+   public:
+    using TOut = LoxFunction::TOut;
+
+    struct Entry {
+        TOut Key;
+        TOut Value;
+    };
+
+   private:
+    // 0 marks an empty slot. Hash sets the top bit so it never returns it,
+    // the low bits pick the home slot.
+    std::vector<std::uint32_t> hashes_;
+    std::vector<Entry> entries_;
+    std::size_t size_ = 0;
+
+    static std::uint32_t Hash(const TOut& key);
+    // The slot of key, or the empty slot it would go in.
+    std::size_t Probe(const TOut& key, std::uint32_t hash) const;
+    void Grow();
+
+   public:
+    // Whether key can be a key of a map.
+    static bool Hashable(const TOut& key);
+
+    // Return nullptr if there is no key.
+    const TOut* Find(const TOut& key) const;
+    // key must be Hashable.
+    void Insert(const TOut& key, TOut value);
+    // Return whether there was a key.
+    bool Erase(const TOut& key);
+
+    std::size_t size() const { return size_; }
+
+    // Call fn with each key and value, in no particular order.
+    template <typename Fn>
+    void ForEach(Fn&& fn) const {
+        for (std::size_t i = 0; i < std::size(hashes_); ++i) {
+            if (hashes_[i] != 0) {
+                fn(entries_[i].Key, entries_[i].Value);
+            }
+        }
+    }
+};
+
+}  // namespace lox
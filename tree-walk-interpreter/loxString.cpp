@@ -0,0 +1,79 @@
+#include "loxString.h"
+
+#include <vector>
+
+namespace lox {
+
+LoxString::Node::~Node() {
+    if (!Flat()) {
+        Release(std::move(Left));
+        Release(std::move(Right));
+    }
+}
+
+void LoxString::Release(std::shared_ptr<const Node> node) {
+    std::vector<std::shared_ptr<const Node>> pending;
+    pending.push_back(std::move(node));
+    while (!pending.empty()) {
+        auto next = std::move(pending.back());
+        pending.pop_back();
+        // Take the operands of a rope that is about to be freed, so freeing
+        // it doesn't free them recursively.
+        if (next != nullptr && next.use_count() == 1 && !next->Flat()) {
+            pending.push_back(std::move(next->Left));
+            pending.push_back(std::move(next->Right));
+        }
+    }
+}
+
+void LoxString::Flatten(const Node& rope) {
+    std::string chars;
+    chars.reserve(rope.Length);
+    std::vector<const Node*> pending = {&rope};
+    while (!pending.empty()) {
+        auto* next = pending.back();
+        pending.pop_back();
+        if (next->Flat()) {
+            chars += next->Str;
+        } else {
+            pending.push_back(next->Right.get());
+            pending.push_back(next->Left.get());
+        }
+    }
+    rope.Str = std::move(chars);
+    Release(std::move(rope.Left));
+    Release(std::move(rope.Right));
+}
+
+LoxString LoxString::Concat(const LoxString& l, const LoxString& r) {
+    if (l.Length() == 0) {
+        return r;
+    }
+    if (r.Length() == 0) {
+        return l;
+    }
+    if (l.Length() + r.Length() < kMinRope) {
+        return LoxString(l.Str() + r.Str());
+    }
+    // A short string added to a rope that ends in a short string joins
+    // that one, and likewise at the start. A loop that adds to a string
+    // then frees the rope it built so far on each step, rather than keeping
+    // a node for every step.
+    auto& left = *l.node_;
+    auto& right = *r.node_;
+    if (!left.Flat() && left.Right->Flat() &&
+        left.Right->Length + r.Length() < kMinRope) {
+        return LoxString(std::make_shared<const Node>(
+            left.Left,
+            std::make_shared<const Node>(left.Right->Str + r.Str())));
+    }
+    if (!right.Flat() && right.Left->Flat() &&
+        l.Length() + right.Left->Length < kMinRope) {
+        return LoxString(std::make_shared<const Node>(
+            std::make_shared<const Node>(l.Str() + right.Left->Str),
+            right.Right));
+    }
+    return LoxString(std::make_shared<const Node>(l.node_, r.node_));
+}
+
+}  // namespace lox
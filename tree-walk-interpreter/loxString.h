@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace lox {
+
+// String value of the language. Strings are immutable, so copies share
+// their characters and copying one, like loading a string constant, doesn't
+// allocate.
+//
+// Concatenating strings makes a rope: a node that refers to both operands
+// instead of copying their characters. The characters of a rope are only
+// put together the first time they are needed, to print, compare or hash
+// it, so building a long string piece by piece in a loop takes linear time
+// rather than copying everything built so far on each step.
+class LoxString {
+    struct Node {
+        // The characters, of a rope only once it was flattened.
+        mutable std::string Str;
+        // The operands of a rope that wasn't flattened yet, null otherwise.
+        mutable std::shared_ptr<const Node> Left;
+        mutable std::shared_ptr<const Node> Right;
+        std::size_t Length;
+        // Computed the first time the string is used as a map key. String
+        // constants are shared, so a constant key hashes once.
+        mutable std::uint32_t Hash = 0;
+
+        explicit Node(std::string chars)
+            : Str(std::move(chars)), Length(std::size(Str)) {}
+        Node(std::shared_ptr<const Node> left,
+             std::shared_ptr<const Node> right)
+            : Left(std::move(left)),
+              Right(std::move(right)),
+              Length(Left->Length + Right->Length) {}
+        // Ropes can be as deep as the loop that built them was long, so
+        // they are freed without recursion.
+        ~Node();
+        Node(const Node&) = delete;
+        Node& operator=(const Node&) = delete;
+
+        bool Flat() const { return Left == nullptr; }
+    };
+    std::shared_ptr<const Node> node_;
+
+    explicit LoxString(std::shared_ptr<const Node> node)
+        : node_(std::move(node)) {}
+    // Put the characters of rope into its Str and drop its operands.
+    static void Flatten(const Node& rope);
+    // Free node, and of the ropes under it those nothing else refers to,
+    // without recursion.
+    static void Release(std::shared_ptr<const Node> node);
+
+   public:
+    // Concatenations shorter than this are copied right away, a rope of
+    // them would cost more than the copy.
+    static constexpr std::size_t kMinRope = 128;
+
+    LoxString(std::string chars)
+        : node_(std::make_shared<const Node>(std::move(chars))) {}
+    LoxString(const char* chars) : LoxString(std::string(chars)) {}
+
+    // l followed by r.
+    static LoxString Concat(const LoxString& l, const LoxString& r);
+
+    std::size_t Length() const { return node_->Length; }
+
+    // Flattens a rope.
+    const std::string& Str() const {
+        if (!node_->Flat()) {
+            Flatten(*node_);
+        }
+        return node_->Str;
+    }
+
+    // Never 0, the top bit is set. LoxMap indexes with the low bits.
+    std::uint32_t Hash() const {
+        if (node_->Hash == 0) {
+            std::uint64_t hash = std::hash<std::string>{}(Str());
+            node_->Hash =
+                static_cast<std::uint32_t>(hash ^ (hash >> 32)) | 0x80000000u;
+        }
+        return node_->Hash;
+    }
+
+    friend bool operator==(const LoxString& l, const LoxString& r) {
+        return l.node_ == r.node_ ||
+               (l.Length() == r.Length() && l.Str() == r.Str());
+    }
+    friend bool operator!=(const LoxString& l, const LoxString& r) {
+        return !(l == r);
+    }
+    friend std::ostream& operator<<(std::ostream& os, const LoxString& s) {
+        return os << s.Str();
+    }
+};
+
+}  // namespace lox
@@ -1,12 +1,22 @@
+#include <algorithm>
+#include <charconv>
 #include <fstream>
 #include <iostream>
 #include <streambuf>
 #include <string>
 #include <filesystem>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
+#include "batch.h"
 #include"scanner.h"
 #include"tokens.h"
 #include "lox.h"
+#include "metrics.h"
+#include "snapshot.h"
 
 namespace lox {
 
@@ -22,6 +32,71 @@ static void runFile(const std::string& path)
         std::istreambuf_iterator<char>()));
 }
 
+// Run the .lox files in dir in parallel, or interleaved on one thread if
+// concurrent, each started from the snapshot at snapshot_path if it isn't
+// empty, and print what each printed in the order of their names.
+static int runBatch(const std::string& dir, std::size_t threads,
+                    bool concurrent, const std::string& snapshot_path)
+{
+    if(!std::filesystem::is_directory(dir))
+    {
+        std::cerr << dir << " is not a directory." << std::endl;
+        return 66;
+    }
+    std::vector<std::filesystem::path> files;
+    for(auto& entry : std::filesystem::directory_iterator(dir))
+    {
+        if(entry.path().extension() == ".lox")
+        {
+            files.push_back(entry.path());
+        }
+    }
+    std::sort(files.begin(), files.end());
+
+    std::vector<std::string> sources;
+    for(auto& file : files)
+    {
+        std::ifstream t(file);
+        sources.emplace_back(
+            std::istreambuf_iterator<char>(t),
+            std::istreambuf_iterator<char>());
+    }
+    std::optional<Snapshot> snapshot;
+    if(!snapshot_path.empty())
+    {
+        try
+        {
+            snapshot = Snapshot::Open(snapshot_path);
+        }
+        catch(const std::runtime_error& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return 66;
+        }
+    }
+    const Snapshot* start = snapshot ? &*snapshot : nullptr;
+    auto results = concurrent ? RunConcurrent(sources, start)
+                              : RunBatch(sources, threads, start);
+
+    // Like a single script: 65 if one didn't compile, else 70 if one failed.
+    int status = 0;
+    for(std::size_t i = 0; i < std::size(files); ++i)
+    {
+        std::cout << "== " << files[i].string() << '\n' << results[i].Output;
+        if(results[i].Result == BatchResult::Status::COMPILE_ERROR)
+        {
+            status = 65;
+        }
+        else if(results[i].Result == BatchResult::Status::RUNTIME_ERROR &&
+                status == 0)
+        {
+            status = 70;
+        }
+    }
+    std::cout << std::flush;
+    return status;
+}
+
 static void runPrompt()
 {
     for (;;) {
@@ -36,10 +111,112 @@ static void runPrompt()
 
 int main(int argc, char* args[])
 {
+    bool metrics = false;
+    std::ofstream trace_file;
+    std::unique_ptr<lox::Tracer> tracer;
+    std::string batch_dir;
+    std::string snapshot_path;
+    std::string save_snapshot_path;
+    std::size_t threads = std::thread::hardware_concurrency();
+    bool concurrent = false;
+    for(; argc>1 && args[1][0] == '-'; --argc, ++args)
+    {
+        std::string flag = args[1];
+        if(flag == "--dump-ast")
+        {
+            lox::SetDumpAst(true);
+        }
+        else if(flag == "--metrics")
+        {
+            metrics = true;
+        }
+        else if(flag == "--trace" && argc>2)
+        {
+            // Chrome trace JSON, for chrome://tracing or Perfetto.
+            trace_file.open(args[2]);
+            tracer = std::make_unique<lox::Tracer>(trace_file);
+            lox::SetTracer(tracer.get());
+            --argc;
+            ++args;
+        }
+        else if(flag == "--batch" && argc>2)
+        {
+            batch_dir = args[2];
+            --argc;
+            ++args;
+        }
+        else if(flag == "--concurrent")
+        {
+            concurrent = true;
+        }
+        else if(flag == "--snapshot" && argc>2)
+        {
+            snapshot_path = args[2];
+            --argc;
+            ++args;
+        }
+        else if(flag == "--save-snapshot" && argc>2)
+        {
+            save_snapshot_path = args[2];
+            --argc;
+            ++args;
+        }
+        else if(flag == "-j" && argc>2)
+        {
+            std::string count = args[2];
+            auto result = std::from_chars(
+                count.data(), count.data() + std::size(count), threads);
+            if(result.ec != std::errc() ||
+               result.ptr != count.data() + std::size(count) || threads == 0)
+            {
+                std::cerr << "Invalid thread count " << count << std::endl;
+                return 64;
+            }
+            --argc;
+            ++args;
+        }
+        else
+        {
+            std::cerr << "Unknown option " << flag << std::endl;
+            return 64;
+        }
+    }
+    if(!batch_dir.empty())
+    {
+        return lox::runBatch(batch_dir, threads, concurrent, snapshot_path);
+    }
+    if(!snapshot_path.empty())
+    {
+        try
+        {
+            lox::LoadSnapshot(snapshot_path);
+        }
+        catch(const std::runtime_error& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return 66;
+        }
+    }
     if(argc>1)
     {
         std::string file_location_string = args[1];
         lox::runFile(file_location_string);
+        if(metrics)
+        {
+            lox::GetMetrics().Print(std::cerr);
+        }
+        if(!save_snapshot_path.empty())
+        {
+            try
+            {
+                lox::SaveSnapshot(save_snapshot_path);
+            }
+            catch(const std::runtime_error& e)
+            {
+                std::cerr << e.what() << std::endl;
+                return 74;
+            }
+        }
     }
     else{
         lox::runPrompt();
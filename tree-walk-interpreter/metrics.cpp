@@ -0,0 +1,100 @@
+#include "metrics.h"
+
+#include <cstdio>
+
+namespace lox {
+
+void Metrics::Print(std::ostream& os) const {
+    auto ms = [](Duration d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    };
+    os << "instructions       " << Instructions << '\n'
+       << "calls              " << Calls << '\n'
+       << "cells allocated    " << CellsAllocated << '\n'
+       << "closures allocated " << ClosuresAllocated << '\n'
+       << "values copied      " << ValuesCopied << '\n'
+       << "strings allocated  " << StringsAllocated << '\n'
+       << "bytes allocated    " << BytesAllocated << '\n'
+       << "scan               " << ms(Scan) << " ms\n"
+       << "parse              " << ms(Parse) << " ms\n"
+       << "resolve            " << ms(Resolve) << " ms\n"
+       << "optimize           " << ms(Optimize) << " ms\n"
+       << "compile            " << ms(Compile) << " ms\n"
+       << "execute            " << ms(Execute) << " ms\n";
+}
+
+// A JSON string literal.
+static std::string Quote(const std::string& s) {
+    std::string quoted = "\"";
+    for (char c : s) {
+        switch (c) {
+            case '"':
+                quoted += "\\\"";
+                break;
+            case '\\':
+                quoted += "\\\\";
+                break;
+            case '\n':
+                quoted += "\\n";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escape[7];
+                    std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+                    quoted += escape;
+                } else {
+                    quoted += c;
+                }
+        }
+    }
+    return quoted + "\"";
+}
+
+// Microseconds with nanosecond precision, the default formatting of doubles
+// would switch to exponents.
+static std::string Micros(double us) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.3f", us);
+    return text;
+}
+
+Tracer::Tracer(std::ostream& os) : os_(os) { os_ << "{\"traceEvents\":[\n"; }
+
+Tracer::~Tracer() { os_ << "\n]}\n" << std::flush; }
+
+double Tracer::Now() const {
+    return std::chrono::duration<double, std::micro>(
+               std::chrono::steady_clock::now() - start_)
+        .count();
+}
+
+void Tracer::Event(const std::string& name, char phase, double ts,
+                   const std::string& args) {
+    if (!first_) {
+        os_ << ",\n";
+    }
+    first_ = false;
+    os_ << "{\"name\":" << Quote(name) << ",\"ph\":\"" << phase
+        << "\",\"ts\":" << Micros(ts) << ",\"pid\":1,\"tid\":1" << args
+        << '}';
+}
+
+void Tracer::Enter(const std::string& function) {
+    Event(function, 'B', Now());
+}
+
+void Tracer::Exit(const std::string& function) { Event(function, 'E', Now()); }
+
+void Tracer::Error(const std::string& message, std::uint32_t line) {
+    Event("runtime error", 'i', Now(),
+          ",\"s\":\"t\",\"args\":{\"message\":" + Quote(message) +
+              ",\"line\":" + std::to_string(line) + "}");
+}
+
+void Tracer::Phase(const std::string& name,
+                   std::chrono::steady_clock::time_point start) {
+    auto ts = std::chrono::duration<double, std::micro>(start - start_).count();
+    Event(name, 'X', ts, ",\"dur\":" + Micros(Now() - ts));
+}
+
+}  // namespace lox
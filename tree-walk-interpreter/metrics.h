@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace lox {
+
+// What running scripts cost so far, counted by the interpreter.
+struct Metrics {
+    using Duration = std::chrono::nanoseconds;
+
+    // Bytecode instructions the interpreter loop ran, machine code doesn't
+    // count them.
+    std::uint64_t Instructions = 0;
+    std::uint64_t Calls = 0;
+    // Cells of captured locals and upvalue lists of closures.
+    std::uint64_t CellsAllocated = 0;
+    std::uint64_t ClosuresAllocated = 0;
+    // Register moves and loads of variables, each copies a value.
+    std::uint64_t ValuesCopied = 0;
+    std::uint64_t StringsAllocated = 0;
+    // Heap memory of the cells, closures and strings above.
+    std::uint64_t BytesAllocated = 0;
+
+    Duration Scan{};
+    Duration Parse{};
+    Duration Resolve{};
+    Duration Optimize{};
+    Duration Compile{};
+    Duration Execute{};
+
+    void Print(std::ostream& os) const;
+};
+
+// Writes events in the Chrome trace format, which chrome://tracing and
+// Perfetto open. Events are written as they happen, so a trace of a script
+// that crashes still shows what it did up to there.
+class Tracer {
+    std::ostream& os_;
+    std::chrono::steady_clock::time_point start_ =
+        std::chrono::steady_clock::now();
+    bool first_ = true;
+
+    // Microseconds since the tracer was created.
+    double Now() const;
+    void Event(const std::string& name, char phase, double ts,
+               const std::string& args = "");
+
+   public:
+    explicit Tracer(std::ostream& os);
+    ~Tracer();
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    void Enter(const std::string& function);
+    void Exit(const std::string& function);
+    void Error(const std::string& message, std::uint32_t line);
+    // A phase of running a script that started at start and ends now.
+    void Phase(const std::string& name,
+               std::chrono::steady_clock::time_point start);
+};
+
+}  // namespace lox
@@ -0,0 +1,269 @@
+#include "natives.h"
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "eventLoop.h"
+#include "loxClass.h"
+#include "loxCoroutine.h"
+#include "loxF64Array.h"
+#include "loxList.h"
+#include "loxMap.h"
+#include "runtimeerror.h"
+#include "simd.h"
+#include "symbolTable.h"
+
+namespace lox {
+
+namespace {
+
+using TOut = LoxNative::TOut;
+
+[[noreturn]] void Throw(std::uint32_t line, std::string message) {
+    throw RunTimeError{Token{0, 0, TokenType::LEFT_PAREN, line, 0},
+                       std::move(message)};
+}
+
+LoxList& ListArgument(TOut& arg, std::uint32_t line) {
+    auto* list = std::get_if<std::shared_ptr<LoxList>>(&arg);
+    if (list == nullptr) {
+        Throw(line, "Argument must be a list.");
+    }
+    return **list;
+}
+
+LoxMap& MapArgument(TOut& arg, std::uint32_t line) {
+    auto* map = std::get_if<std::shared_ptr<LoxMap>>(&arg);
+    if (map == nullptr) {
+        Throw(line, "Argument must be a map.");
+    }
+    return **map;
+}
+
+LoxF64Array& ArrayArgument(TOut& arg, std::uint32_t line) {
+    auto* array = std::get_if<std::shared_ptr<LoxF64Array>>(&arg);
+    if (array == nullptr) {
+        Throw(line, "Argument must be an F64Array.");
+    }
+    return **array;
+}
+
+// len(value): the number of elements of a list or array, entries of a map
+// or characters of a string.
+TOut Len(TOut* args, std::uint32_t line) {
+    if (auto* list = std::get_if<std::shared_ptr<LoxList>>(&args[0])) {
+        return static_cast<double>(std::size((*list)->Elements));
+    }
+    if (auto* array = std::get_if<std::shared_ptr<LoxF64Array>>(&args[0])) {
+        return static_cast<double>(std::size((*array)->Elements));
+    }
+    if (auto* map = std::get_if<std::shared_ptr<LoxMap>>(&args[0])) {
+        return static_cast<double>((*map)->size());
+    }
+    if (auto* s = std::get_if<LoxString>(&args[0])) {
+        return static_cast<double>(s->Length());
+    }
+    Throw(line, "Argument must be a list, F64Array, map or string.");
+}
+
+// push(list, value): append value, and return the new length.
+TOut Push(TOut* args, std::uint32_t line) {
+    auto& elements = ListArgument(args[0], line).Elements;
+    elements.push_back(std::move(args[1]));
+    return static_cast<double>(std::size(elements));
+}
+
+// pop(list): remove the last element and return it.
+TOut Pop(TOut* args, std::uint32_t line) {
+    auto& elements = ListArgument(args[0], line).Elements;
+    if (std::empty(elements)) {
+        Throw(line, "Can't pop from an empty list.");
+    }
+    TOut last = std::move(elements.back());
+    elements.pop_back();
+    return last;
+}
+
+// has(map, key)
+TOut Has(TOut* args, std::uint32_t line) {
+    return MapArgument(args[0], line).Find(args[1]) != nullptr;
+}
+
+// remove(map, key): return whether the map had key.
+TOut Remove(TOut* args, std::uint32_t line) {
+    return MapArgument(args[0], line).Erase(args[1]);
+}
+
+// keys(map): a list of the keys.
+TOut Keys(TOut* args, std::uint32_t line) {
+    const auto& map = MapArgument(args[0], line);
+    auto keys = std::make_shared<LoxList>();
+    keys->Elements.reserve(map.size());
+    map.ForEach([&](const TOut& key, const TOut&) {
+        keys->Elements.push_back(key);
+    });
+    return keys;
+}
+
+// F64Array(size or list): an array of size zeros, or of the numbers of
+// list.
+TOut NewF64Array(TOut* args, std::uint32_t line) {
+    if (auto* size = std::get_if<double>(&args[0])) {
+        if (!(*size >= 0 && *size <= 1e15) ||
+            static_cast<std::size_t>(*size) != *size) {
+            Throw(line, "Size must be a non-negative integer.");
+        }
+        return std::make_shared<LoxF64Array>(
+            std::vector<double>(static_cast<std::size_t>(*size)));
+    }
+    if (auto* list = std::get_if<std::shared_ptr<LoxList>>(&args[0])) {
+        std::vector<double> elements;
+        elements.reserve(std::size((*list)->Elements));
+        for (const auto& element : (*list)->Elements) {
+            auto* number = std::get_if<double>(&element);
+            if (number == nullptr) {
+                Throw(line, "F64Array elements must be numbers.");
+            }
+            elements.push_back(*number);
+        }
+        return std::make_shared<LoxF64Array>(std::move(elements));
+    }
+    Throw(line, "Argument must be a size or a list of numbers.");
+}
+
+// A new array of a op b element-wise. Either may be a number used for
+// every element, but not both.
+template <simd::Op op>
+TOut ElementWise(TOut* args, std::uint32_t line) {
+    auto* a = std::get_if<std::shared_ptr<LoxF64Array>>(&args[0]);
+    auto* b = std::get_if<std::shared_ptr<LoxF64Array>>(&args[1]);
+    auto* a_number = std::get_if<double>(&args[0]);
+    auto* b_number = std::get_if<double>(&args[1]);
+    if ((a == nullptr && a_number == nullptr) ||
+        (b == nullptr && b_number == nullptr) ||
+        (a == nullptr && b == nullptr)) {
+        Throw(line, "Operands must be F64Arrays or numbers.");
+    }
+    if (a != nullptr && b != nullptr &&
+        std::size((*a)->Elements) != std::size((*b)->Elements)) {
+        Throw(line, "F64Arrays must have the same length.");
+    }
+
+    auto n = std::size((a != nullptr ? *a : *b)->Elements);
+    auto result = std::make_shared<LoxF64Array>(std::vector<double>(n));
+    simd::Apply(op, a != nullptr ? (*a)->Elements.data() : a_number,
+                a == nullptr, b != nullptr ? (*b)->Elements.data() : b_number,
+                b == nullptr, result->Elements.data(), n);
+    return result;
+}
+
+TOut Dot(TOut* args, std::uint32_t line) {
+    const auto& a = ArrayArgument(args[0], line).Elements;
+    const auto& b = ArrayArgument(args[1], line).Elements;
+    if (std::size(a) != std::size(b)) {
+        Throw(line, "F64Arrays must have the same length.");
+    }
+    return simd::Dot(a.data(), b.data(), std::size(a));
+}
+
+TOut Sum(TOut* args, std::uint32_t line) {
+    const auto& a = ArrayArgument(args[0], line).Elements;
+    return simd::Sum(a.data(), std::size(a));
+}
+
+template <bool max>
+TOut Extreme(TOut* args, std::uint32_t line) {
+    const auto& a = ArrayArgument(args[0], line).Elements;
+    if (std::empty(a)) {
+        Throw(line, "F64Array is empty.");
+    }
+    return max ? simd::Max(a.data(), std::size(a))
+               : simd::Min(a.data(), std::size(a));
+}
+
+LoxCoroutine& CoroutineArgument(TOut& arg, std::uint32_t line) {
+    auto* coroutine = std::get_if<std::shared_ptr<LoxCoroutine>>(&arg);
+    if (coroutine == nullptr) {
+        Throw(line, "Argument must be a coroutine.");
+    }
+    return **coroutine;
+}
+
+// coroutine(function): a coroutine that calls function, which takes no
+// arguments, when it is first resumed.
+TOut NewCoroutine(TOut* args, std::uint32_t line) {
+    const LoxFunction* function = std::get_if<LoxFunction>(&args[0]);
+    if (auto* bound =
+            std::get_if<std::shared_ptr<const LoxBoundMethod>>(&args[0])) {
+        function = &(*bound)->Method;
+    }
+    if (function == nullptr) {
+        Throw(line, "Argument must be a function.");
+    }
+    if (function->Proto().Arity != 0) {
+        Throw(line, "A coroutine's function can't take arguments.");
+    }
+    return std::make_shared<LoxCoroutine>(std::move(args[0]));
+}
+
+// done(coroutine): whether its function returned, or failed.
+TOut Done(TOut* args, std::uint32_t line) {
+    return CoroutineArgument(args[0], line).Status ==
+           LoxCoroutine::State::DONE;
+}
+
+// sleep(seconds): wait, while the other scripts of the event loop run.
+std::shared_ptr<Pending> Sleep(EventLoop& loop, TOut* args,
+                               std::uint32_t line) {
+    auto* seconds = std::get_if<double>(&args[0]);
+    if (seconds == nullptr || !(*seconds >= 0) ||
+        *seconds > EventLoop::kMaxSeconds) {
+        Throw(line, "Argument must be a number of seconds, at most a year.");
+    }
+    auto pending = std::make_shared<Pending>();
+    loop.After(*seconds, [pending] { pending->Complete(TOut("Nil")); });
+    return pending;
+}
+
+const LoxNative kNatives[] = {
+    {"len", 1, Len},
+    {"push", 2, Push},
+    {"pop", 1, Pop},
+    {"has", 2, Has},
+    {"remove", 2, Remove},
+    {"keys", 1, Keys},
+    {"F64Array", 1, NewF64Array},
+    {"f64Add", 2, ElementWise<simd::Op::ADD>},
+    {"f64Sub", 2, ElementWise<simd::Op::SUBTRACT>},
+    {"f64Mul", 2, ElementWise<simd::Op::MULTIPLY>},
+    {"f64Div", 2, ElementWise<simd::Op::DIVIDE>},
+    {"f64Dot", 2, Dot},
+    {"f64Sum", 1, Sum},
+    {"f64Min", 1, Extreme<false>},
+    {"f64Max", 1, Extreme<true>},
+    {"coroutine", 1, NewCoroutine},
+    {"resume", 1, nullptr},
+    {"done", 1, Done},
+    {"sleep", 1, nullptr, Sleep},
+};
+
+}  // namespace
+
+void DefineNatives(Environment<LoxFunction::TOut>& globals) {
+    for (const auto& native : kNatives) {
+        globals.Define(Symbols().Intern(native.Name), &native);
+    }
+}
+
+const LoxNative* FindNative(std::string_view name) {
+    for (const auto& native : kNatives) {
+        if (name == native.Name) {
+            return &native;
+        }
+    }
+    return nullptr;
+}
+
+}  // namespace lox
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+#include "environment.h"
+#include "loxFunction.h"
+
+namespace lox {
+
+class EventLoop;
+class Pending;
+
+// A function of the interpreter that scripts call like one of their own.
+// Natives are static, values refer to them by pointer.
+struct LoxNative {
+    using TOut = LoxFunction::TOut;
+    // Gets the Arity arguments, and throws a RunTimeError at line for bad
+    // ones.
+    using Fn = TOut (*)(TOut* args, std::uint32_t line);
+    // Starts an operation on loop that completes later, such as I/O, and
+    // returns it. The call returns what it completes with, in the meantime
+    // the script is parked, see EventLoop.
+    using AsyncFn = std::shared_ptr<Pending> (*)(EventLoop& loop, TOut* args,
+                                                 std::uint32_t line);
+
+    const char* Name;
+    std::size_t Arity;
+    // Null for resume, which the interpreter runs itself, and for async
+    // natives.
+    Fn Function;
+    AsyncFn Start = nullptr;
+};
+
+// Define the natives as globals.
+void DefineNatives(Environment<LoxFunction::TOut>& globals);
+// Return nullptr if there is no native name.
+const LoxNative* FindNative(std::string_view name);
+
+}  // namespace lox
@@ -0,0 +1,582 @@
+#include "optimizer.h"
+
+#include <string>
+#include <type_traits>
+#include <unordered_set>
+
+#include "symbolTable.h"
+#include "typeInference.h"
+
+namespace lox {
+
+namespace {
+
+bool IsTrue(const Literal::ValueType& value) {
+    auto* b = std::get_if<bool>(&value);
+    return b != nullptr && *b;
+}
+
+// Whether the block has a scope of its own, because it declares something.
+bool Declares(const Block& blk) {
+    for (auto& s : blk.Statements) {
+        if (dynamic_cast<VariableDeclaration*>(s.get()) != nullptr ||
+            dynamic_cast<FunctionDeclaration*>(s.get()) != nullptr ||
+            dynamic_cast<ClassDeclaration*>(s.get()) != nullptr) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Fixes the resolved distances in a block whose scope is removed: variables
+// that were found outside of it are now one scope closer.
+class ScopeRemover final : ExpressionVisitor, StatementVisitor {
+    std::map<Expression*, int>& locals_;
+    int depth_ = 0;  // Scopes inside the removed one.
+
+    void Resolve(Expression* expr) {
+        auto distance = locals_.find(expr);
+        if (distance != locals_.end() && distance->second > depth_) {
+            --distance->second;
+        }
+    }
+    void Remove(Expression& e) { e.Accept(*this); }
+    void Remove(Statement& s) { s.Accept(*this); }
+
+   public:
+    ScopeRemover(std::map<Expression*, int>& locals) : locals_(locals) {}
+
+    void Remove(Block& blk) {
+        for (auto& s : blk.Statements) {
+            Remove(*s);
+        }
+    }
+
+   private:
+    virtual void Visit(Literal&) override {}
+    virtual void Visit(BinaryExpr& b) override {
+        Remove(*b.Left);
+        Remove(*b.Right);
+    }
+    virtual void Visit(UnaryExpr& u) override { Remove(*u.Expr); }
+    virtual void Visit(Grouping& g) override { Remove(*g.Expr); }
+    virtual void Visit(Variable& v) override { Resolve(&v); }
+    virtual void Visit(Assignment& a) override {
+        Remove(*a.Expr);
+        Resolve(&a);
+    }
+    virtual void Visit(Logical& lg) override {
+        Remove(*lg.Left);
+        Remove(*lg.Right);
+    }
+    virtual void Visit(Call& c) override {
+        Remove(*c.Callee);
+        for (auto& a : c.Arguments) {
+            Remove(*a);
+        }
+    }
+    virtual void Visit(Get& g) override { Remove(*g.Object); }
+    virtual void Visit(Set& s) override {
+        Remove(*s.Object);
+        Remove(*s.Value);
+    }
+    virtual void Visit(Super& s) override {
+        Resolve(s.Superclass.get());
+        Resolve(s.This.get());
+    }
+    virtual void Visit(ListLiteral& l) override {
+        for (auto& e : l.Elements) {
+            Remove(*e);
+        }
+    }
+    virtual void Visit(MapLiteral& m) override {
+        for (std::size_t i = 0; i < std::size(m.Keys); ++i) {
+            Remove(*m.Keys[i]);
+            Remove(*m.Values[i]);
+        }
+    }
+    virtual void Visit(Subscript& s) override {
+        Remove(*s.Object);
+        Remove(*s.Key);
+    }
+    virtual void Visit(SetSubscript& s) override {
+        Remove(*s.Object);
+        Remove(*s.Key);
+        Remove(*s.Value);
+    }
+    virtual void Visit(PrintStatement& p) override { Remove(*p.Expr); }
+    virtual void Visit(ExpressionStatement& e) override { Remove(*e.Expr); }
+    virtual void Visit(VariableDeclaration& vdecl) override {
+        if (vdecl.Initializer != nullptr) {
+            Remove(*vdecl.Initializer);
+        }
+    }
+    virtual void Visit(Block& blk) override {
+        ++depth_;
+        Remove(blk);
+        --depth_;
+    }
+    virtual void Visit(IfStatement& i) override {
+        Remove(*i.Condition);
+        Remove(*i.ThenBranch);
+        if (i.ElseBranch != nullptr) {
+            Remove(*i.ElseBranch);
+        }
+    }
+    virtual void Visit(While& w) override {
+        Remove(*w.Condition);
+        Remove(*w.Body);
+    }
+    virtual void Visit(FunctionDeclaration& f) override {
+        ++depth_;
+        for (auto& s : f.Body) {
+            Remove(*s);
+        }
+        --depth_;
+    }
+    virtual void Visit(ReturnStatement& r) override {
+        if (r.Value != nullptr) {
+            Remove(*r.Value);
+        }
+    }
+    virtual void Visit(YieldStatement& y) override {
+        if (y.Value != nullptr) {
+            Remove(*y.Value);
+        }
+    }
+    virtual void Visit(ClassDeclaration& c) override {
+        if (c.Superclass != nullptr) {
+            Resolve(c.Superclass.get());
+            // The methods are in the scope of super.
+            ++depth_;
+        }
+        for (auto& m : c.Methods) {
+            Visit(*m);
+        }
+        if (c.Superclass != nullptr) {
+            --depth_;
+        }
+    }
+};
+
+// Collects the names of the variables assigned in a loop.
+class AssignedNames final : ExpressionVisitor, StatementVisitor {
+   public:
+    std::unordered_set<Symbol> Names;
+
+    void Collect(Expression& e) { e.Accept(*this); }
+    void Collect(Statement& s) { s.Accept(*this); }
+
+   private:
+    virtual void Visit(Literal&) override {}
+    virtual void Visit(BinaryExpr& b) override {
+        Collect(*b.Left);
+        Collect(*b.Right);
+    }
+    virtual void Visit(UnaryExpr& u) override { Collect(*u.Expr); }
+    virtual void Visit(Grouping& g) override { Collect(*g.Expr); }
+    virtual void Visit(Variable&) override {}
+    virtual void Visit(Assignment& a) override {
+        Collect(*a.Expr);
+        Names.insert(a.Name.Value);
+    }
+    virtual void Visit(Logical& lg) override {
+        Collect(*lg.Left);
+        Collect(*lg.Right);
+    }
+    virtual void Visit(Call& c) override {
+        Collect(*c.Callee);
+        for (auto& a : c.Arguments) {
+            Collect(*a);
+        }
+    }
+    virtual void Visit(Get& g) override { Collect(*g.Object); }
+    virtual void Visit(Set& s) override {
+        Collect(*s.Object);
+        Collect(*s.Value);
+    }
+    virtual void Visit(Super&) override {}
+    virtual void Visit(ListLiteral& l) override {
+        for (auto& e : l.Elements) {
+            Collect(*e);
+        }
+    }
+    virtual void Visit(MapLiteral& m) override {
+        for (std::size_t i = 0; i < std::size(m.Keys); ++i) {
+            Collect(*m.Keys[i]);
+            Collect(*m.Values[i]);
+        }
+    }
+    virtual void Visit(Subscript& s) override {
+        Collect(*s.Object);
+        Collect(*s.Key);
+    }
+    virtual void Visit(SetSubscript& s) override {
+        Collect(*s.Object);
+        Collect(*s.Key);
+        Collect(*s.Value);
+    }
+    virtual void Visit(PrintStatement& p) override { Collect(*p.Expr); }
+    virtual void Visit(ExpressionStatement& e) override { Collect(*e.Expr); }
+    virtual void Visit(VariableDeclaration& vdecl) override {
+        if (vdecl.Initializer != nullptr) {
+            Collect(*vdecl.Initializer);
+        }
+    }
+    virtual void Visit(Block& blk) override {
+        for (auto& s : blk.Statements) {
+            Collect(*s);
+        }
+    }
+    virtual void Visit(IfStatement& i) override {
+        Collect(*i.Condition);
+        Collect(*i.ThenBranch);
+        if (i.ElseBranch != nullptr) {
+            Collect(*i.ElseBranch);
+        }
+    }
+    virtual void Visit(While& w) override {
+        Collect(*w.Condition);
+        Collect(*w.Body);
+    }
+    virtual void Visit(FunctionDeclaration&) override {}
+    virtual void Visit(ReturnStatement& r) override {
+        if (r.Value != nullptr) {
+            Collect(*r.Value);
+        }
+    }
+    virtual void Visit(YieldStatement& y) override {
+        if (y.Value != nullptr) {
+            Collect(*y.Value);
+        }
+    }
+    virtual void Visit(ClassDeclaration&) override {}
+};
+
+// Replaces the loop invariant expressions of a loop by new locals, declared
+// in the scope around the loop.
+class LoopHoister final : StatementVisitor {
+    std::map<Expression*, int>& locals_;
+    // Scopes of the function around the loop.
+    const int function_depth_;
+    std::size_t& hoisted_;
+    std::vector<std::shared_ptr<Statement>>& declarations_;
+    std::unordered_set<Symbol> assigned_;
+    int depth_ = 0;  // Scopes inside the loop.
+
+    static bool IsNumber(const Expression& e) {
+        return e.Type == StaticType::NUMBER;
+    }
+
+    // Whether e is arithmetic on doubles that don't change in the loop.
+    bool Invariant(Expression& e) const {
+        if (auto* l = dynamic_cast<Literal*>(&e)) {
+            return std::holds_alternative<double>(l->Value);
+        }
+        if (auto* v = dynamic_cast<Variable*>(&e)) {
+            // A local of this function declared outside the loop.
+            auto distance = locals_.find(v);
+            return IsNumber(*v) && distance != locals_.end() &&
+                   distance->second >= depth_ &&
+                   distance->second - depth_ < function_depth_ &&
+                   assigned_.count(v->Name.Value) == 0;
+        }
+        if (auto* g = dynamic_cast<Grouping*>(&e)) {
+            return Invariant(*g->Expr);
+        }
+        if (auto* u = dynamic_cast<UnaryExpr*>(&e)) {
+            return u->Op.Type == TokenType::MINUS && IsNumber(*u->Expr) &&
+                   Invariant(*u->Expr);
+        }
+        if (auto* b = dynamic_cast<BinaryExpr*>(&e)) {
+            return IsNumber(*b->Left) && IsNumber(*b->Right) &&
+                   Invariant(*b->Left) && Invariant(*b->Right);
+        }
+        return false;
+    }
+
+    static bool HasOperator(Expression& e) {
+        if (auto* g = dynamic_cast<Grouping*>(&e)) {
+            return HasOperator(*g->Expr);
+        }
+        return dynamic_cast<UnaryExpr*>(&e) != nullptr ||
+               dynamic_cast<BinaryExpr*>(&e) != nullptr;
+    }
+
+    // The variables of an invariant expression moved in front of the loop
+    // are found depth_ scopes closer.
+    void Rebase(Expression& e) {
+        if (auto* v = dynamic_cast<Variable*>(&e)) {
+            locals_.at(v) -= depth_;
+        } else if (auto* g = dynamic_cast<Grouping*>(&e)) {
+            Rebase(*g->Expr);
+        } else if (auto* u = dynamic_cast<UnaryExpr*>(&e)) {
+            Rebase(*u->Expr);
+        } else if (auto* b = dynamic_cast<BinaryExpr*>(&e)) {
+            Rebase(*b->Left);
+            Rebase(*b->Right);
+        }
+    }
+
+    void Hoist(std::unique_ptr<Expression>& slot) {
+        auto& e = *slot;
+        if (Invariant(e)) {
+            if (HasOperator(e)) {
+                Token name{0, 0, TokenType::IDENTIFIER, 0,
+                           Symbols().Intern("$hoisted" +
+                                            std::to_string(hoisted_++))};
+                auto variable = std::make_unique<Variable>(name);
+                variable->Type = e.Type;
+                locals_.insert_or_assign(variable.get(), depth_);
+                Rebase(e);
+                declarations_.push_back(std::make_shared<VariableDeclaration>(
+                    name, std::move(slot)));
+                slot = std::move(variable);
+            }
+            return;
+        }
+
+        if (auto* b = dynamic_cast<BinaryExpr*>(&e)) {
+            Hoist(b->Left);
+            Hoist(b->Right);
+        } else if (auto* u = dynamic_cast<UnaryExpr*>(&e)) {
+            Hoist(u->Expr);
+        } else if (auto* g = dynamic_cast<Grouping*>(&e)) {
+            Hoist(g->Expr);
+        } else if (auto* a = dynamic_cast<Assignment*>(&e)) {
+            Hoist(a->Expr);
+        } else if (auto* lg = dynamic_cast<Logical*>(&e)) {
+            Hoist(lg->Left);
+            Hoist(lg->Right);
+        } else if (auto* c = dynamic_cast<Call*>(&e)) {
+            Hoist(c->Callee);
+            for (auto& a : c->Arguments) {
+                Hoist(a);
+            }
+        } else if (auto* g = dynamic_cast<Get*>(&e)) {
+            Hoist(g->Object);
+        } else if (auto* st = dynamic_cast<Set*>(&e)) {
+            Hoist(st->Object);
+            Hoist(st->Value);
+        } else if (auto* l = dynamic_cast<ListLiteral*>(&e)) {
+            for (auto& element : l->Elements) {
+                Hoist(element);
+            }
+        } else if (auto* m = dynamic_cast<MapLiteral*>(&e)) {
+            for (std::size_t i = 0; i < std::size(m->Keys); ++i) {
+                Hoist(m->Keys[i]);
+                Hoist(m->Values[i]);
+            }
+        } else if (auto* s = dynamic_cast<Subscript*>(&e)) {
+            Hoist(s->Object);
+            Hoist(s->Key);
+        } else if (auto* ss = dynamic_cast<SetSubscript*>(&e)) {
+            Hoist(ss->Object);
+            Hoist(ss->Key);
+            Hoist(ss->Value);
+        }
+    }
+    void Hoist(Statement& s) { s.Accept(*this); }
+
+   public:
+    LoopHoister(std::map<Expression*, int>& locals, int function_depth,
+                std::size_t& hoisted,
+                std::vector<std::shared_ptr<Statement>>& declarations)
+        : locals_(locals),
+          function_depth_(function_depth),
+          hoisted_(hoisted),
+          declarations_(declarations) {}
+
+    void Hoist(While& loop) {
+        AssignedNames assigned;
+        assigned.Collect(loop);
+        assigned_ = std::move(assigned.Names);
+        Hoist(loop.Condition);
+        Hoist(*loop.Body);
+    }
+
+   private:
+    virtual void Visit(PrintStatement& p) override { Hoist(p.Expr); }
+    virtual void Visit(ExpressionStatement& e) override { Hoist(e.Expr); }
+    virtual void Visit(VariableDeclaration& vdecl) override {
+        if (vdecl.Initializer != nullptr) {
+            Hoist(vdecl.Initializer);
+        }
+    }
+    virtual void Visit(Block& blk) override {
+        ++depth_;
+        for (auto& s : blk.Statements) {
+            Hoist(*s);
+        }
+        --depth_;
+    }
+    virtual void Visit(IfStatement& i) override {
+        Hoist(i.Condition);
+        Hoist(*i.ThenBranch);
+        if (i.ElseBranch != nullptr) {
+            Hoist(*i.ElseBranch);
+        }
+    }
+    virtual void Visit(While& w) override {
+        Hoist(w.Condition);
+        Hoist(*w.Body);
+    }
+    // Only functions without closures are hoisted from.
+    virtual void Visit(FunctionDeclaration&) override {}
+    virtual void Visit(ClassDeclaration&) override {}
+    virtual void Visit(ReturnStatement& r) override {
+        if (r.Value != nullptr) {
+            Hoist(r.Value);
+        }
+    }
+    virtual void Visit(YieldStatement& y) override {
+        if (y.Value != nullptr) {
+            Hoist(y.Value);
+        }
+    }
+};
+
+}  // namespace
+
+void Optimizer::Optimize(std::vector<std::unique_ptr<Statement>>& statements) {
+    // Functions declared at the top level don't make the locals of the
+    // script's blocks capturable.
+    hoist_ = true;
+    for (auto& s : statements) {
+        if (s != nullptr &&
+            dynamic_cast<FunctionDeclaration*>(s.get()) == nullptr &&
+            dynamic_cast<ClassDeclaration*>(s.get()) == nullptr) {
+            hoist_ = hoist_ && !DeclaresFunction(*s);
+        }
+    }
+    if (hoist_) {
+        TypeInference(locals_).Infer(statements);
+    }
+
+    depth_ = 0;
+    OptimizeList(statements);
+    // Again on what the statements are now, for the compiler.
+    if (hoist_) {
+        TypeInference(locals_).Infer(statements);
+    }
+}
+
+template <typename Pointer>
+void Optimizer::OptimizeList(std::vector<Pointer>& statements) {
+    for (auto& s : statements) {
+        if (s != nullptr) {
+            Optimize(*s);
+        }
+    }
+
+    std::vector<Pointer> optimized;
+    for (auto& s : statements) {
+        if (!Append(optimized, std::move(s))) {
+            break;
+        }
+    }
+    statements = std::move(optimized);
+}
+
+template <typename Pointer>
+bool Optimizer::Append(std::vector<Pointer>& statements, Pointer s) {
+    if (s == nullptr) {
+        return true;
+    }
+
+    if (auto* blk = dynamic_cast<Block*>(s.get())) {
+        if (std::empty(blk->Statements)) {
+            return true;
+        }
+        // The statements of the script are global, so only blocks in other
+        // blocks and in functions can be merged into their parent.
+        if constexpr (std::is_same_v<Pointer, std::shared_ptr<Statement>>) {
+            if (!Declares(*blk)) {
+                ScopeRemover(locals_).Remove(*blk);
+                for (auto& inner : blk->Statements) {
+                    if (!Append(statements, std::move(inner))) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+        }
+    } else if (auto* i = dynamic_cast<IfStatement*>(s.get())) {
+        if (auto* condition = dynamic_cast<Literal*>(i->Condition.get())) {
+            auto& taken =
+                IsTrue(condition->Value) ? i->ThenBranch : i->ElseBranch;
+            return Append(statements, Pointer(std::move(taken)));
+        }
+    } else if (auto* w = dynamic_cast<While*>(s.get())) {
+        auto* condition = dynamic_cast<Literal*>(w->Condition.get());
+        if (condition != nullptr && !IsTrue(condition->Value)) {
+            return true;
+        }
+    }
+
+    bool returns = dynamic_cast<ReturnStatement*>(s.get()) != nullptr;
+    statements.push_back(std::move(s));
+    return !returns;
+}
+
+void Optimizer::Hoist(std::vector<std::shared_ptr<Statement>>& statements) {
+    for (std::size_t i = 0; i < std::size(statements); ++i) {
+        auto* loop = dynamic_cast<While*>(statements[i].get());
+        if (loop == nullptr) {
+            continue;
+        }
+
+        std::vector<std::shared_ptr<Statement>> declarations;
+        LoopHoister(locals_, depth_, hoisted_, declarations).Hoist(*loop);
+        statements.insert(statements.begin() + i, declarations.begin(),
+                          declarations.end());
+        i += std::size(declarations);
+    }
+}
+
+void Optimizer::Visit(Block& blk) {
+    ++depth_;
+    OptimizeList(blk.Statements);
+    if (hoist_) {
+        Hoist(blk.Statements);
+    }
+    --depth_;
+}
+
+void Optimizer::Visit(IfStatement& i) {
+    Optimize(*i.ThenBranch);
+    if (i.ElseBranch != nullptr) {
+        Optimize(*i.ElseBranch);
+    }
+}
+
+void Optimizer::Visit(While& w) { Optimize(*w.Body); }
+
+void Optimizer::Visit(ClassDeclaration& c) {
+    for (auto& m : c.Methods) {
+        Visit(*m);
+    }
+}
+
+void Optimizer::Visit(FunctionDeclaration& f) {
+    auto enclosing_hoist = hoist_;
+    auto enclosing_depth = depth_;
+
+    // Closures could assign the locals while a loop runs.
+    hoist_ = !DeclaresFunction(f.Body);
+    if (hoist_) {
+        TypeInference(locals_).Infer(f);
+    }
+    // The parameters and the body share a scope.
+    depth_ = 1;
+    OptimizeList(f.Body);
+    if (hoist_) {
+        Hoist(f.Body);
+        TypeInference(locals_).Infer(f);
+    }
+
+    hoist_ = enclosing_hoist;
+    depth_ = enclosing_depth;
+}
+
+}  // namespace lox
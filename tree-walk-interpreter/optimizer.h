@@ -0,0 +1,61 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "syntaxTree.h"
+
+namespace lox {
+
+// Rewrites resolved statements before they are compiled.
+//
+// Statements after a return are dropped, as are ifs and loops on a literal
+// condition that decides them. Blocks that declare nothing are merged into
+// the enclosing statement list, so they don't cost a scope. In functions
+// without closures, arithmetic on locals that a loop doesn't assign is
+// hoisted into a new local in front of the loop. Only arithmetic and
+// comparisons on proven doubles are moved, those can't fail or have side
+// effects, so it doesn't matter that they run once even if the loop doesn't
+// run at all.
+//
+// The resolved distances in locals are kept up to date.
+class Optimizer : StatementVisitor {
+    std::map<Expression*, int>& locals_;
+    // Whether expressions can be hoisted out of loops of the function being
+    // optimized.
+    bool hoist_ = false;
+    // Scopes of the function being optimized around the current statement.
+    int depth_ = 0;
+    std::size_t hoisted_ = 0;  // To name the locals holding hoisted values.
+
+   public:
+    Optimizer(std::map<Expression*, int>& locals) : locals_(locals) {}
+
+    void Optimize(std::vector<std::unique_ptr<Statement>>& statements);
+
+   private:
+    void Optimize(Statement& s) { s.Accept(*this); }
+    // Optimize the statements of a scope, and then the list itself.
+    template <typename Pointer>
+    void OptimizeList(std::vector<Pointer>& statements);
+    // Append s to statements, or what it simplifies to. Return false if it
+    // ends with a return, so whatever follows is unreachable.
+    template <typename Pointer>
+    bool Append(std::vector<Pointer>& statements, Pointer s);
+    // Move loop invariant expressions in front of the loops in statements.
+    void Hoist(std::vector<std::shared_ptr<Statement>>& statements);
+
+    virtual void Visit(PrintStatement&) override {}
+    virtual void Visit(ExpressionStatement&) override {}
+    virtual void Visit(VariableDeclaration&) override {}
+    virtual void Visit(Block& blk) override;
+    virtual void Visit(IfStatement&) override;
+    virtual void Visit(While&) override;
+    virtual void Visit(FunctionDeclaration&) override;
+    virtual void Visit(ReturnStatement&) override {}
+    virtual void Visit(YieldStatement&) override {}
+    virtual void Visit(ClassDeclaration&) override;
+};
+
+}  // namespace lox
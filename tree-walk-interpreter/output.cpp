@@ -0,0 +1,70 @@
+#include "output.h"
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <charconv>
+#include <iterator>
+
+namespace lox {
+
+void FdSink::Write(const char* data, std::size_t size) {
+    while (size > 0) {
+        auto written = ::write(fd_, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // Like a closed standard output, what can't be written is
+            // dropped.
+            return;
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+}
+
+void WriteNumber(std::ostream& os, double number) {
+    // The longest is -2.2250738585072014e-308.
+    char chars[32];
+    auto result = std::to_chars(std::begin(chars), std::end(chars), number);
+    os.write(chars, result.ptr - chars);
+}
+
+OutputSink& StdoutSink() {
+    static FdSink sink(STDOUT_FILENO);
+    return sink;
+}
+
+Output::Buffer::Buffer(OutputSink& sink)
+    : chars_(kBufferSize), sink_(&sink) {
+    setp(chars_.data(), chars_.data() + std::size(chars_));
+}
+
+Output::Buffer::int_type Output::Buffer::overflow(int_type c) {
+    sync();
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+int Output::Buffer::sync() {
+    if (pptr() != pbase()) {
+        sink_->Write(pbase(), static_cast<std::size_t>(pptr() - pbase()));
+        setp(chars_.data(), chars_.data() + std::size(chars_));
+    }
+    return 0;
+}
+
+Output::Output(OutputSink& sink) : std::ostream(&buffer_), buffer_(sink) {}
+
+Output::~Output() { flush(); }
+
+void Output::SetSink(OutputSink& sink) {
+    flush();
+    buffer_.SetSink(sink);
+}
+
+}  // namespace lox
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace lox {
+
+// Receives what scripts print, a block of it at a time.
+class OutputSink {
+   public:
+    virtual ~OutputSink() = default;
+    virtual void Write(const char* data, std::size_t size) = 0;
+};
+
+// Writes to a file descriptor.
+class FdSink : public OutputSink {
+    int fd_;
+
+   public:
+    explicit FdSink(int fd) : fd_(fd) {}
+    void Write(const char* data, std::size_t size) override;
+};
+
+// Keeps what is written, for hosts that capture the output of scripts.
+class StringSink : public OutputSink {
+   public:
+    std::string Text;
+    void Write(const char* data, std::size_t size) override {
+        Text.append(data, size);
+    }
+};
+
+// Write number in the shortest form that reads back as the same double,
+// without exponent unless that is shorter.
+void WriteNumber(std::ostream& os, double number);
+
+// The sink of standard output.
+OutputSink& StdoutSink();
+
+// A stream that collects what is written to it in a buffer, and passes it
+// on to its sink once the buffer is full, when it is flushed and when it is
+// destroyed. Writing a line is then a copy into the buffer rather than a
+// system call.
+class Output : public std::ostream {
+    class Buffer : public std::streambuf {
+        std::vector<char> chars_;
+        OutputSink* sink_;
+
+       protected:
+        int_type overflow(int_type c) override;
+        int sync() override;
+
+       public:
+        explicit Buffer(OutputSink& sink);
+        void SetSink(OutputSink& sink) { sink_ = &sink; }
+    };
+    Buffer buffer_;
+
+   public:
+    static constexpr std::size_t kBufferSize = 1 << 16;
+
+    explicit Output(OutputSink& sink = StdoutSink());
+    ~Output() override;
+    Output(const Output&) = delete;
+    Output& operator=(const Output&) = delete;
+
+    // Flush what was written so far, and pass on what is written from now
+    // on to sink.
+    void SetSink(OutputSink& sink);
+};
+
+}  // namespace lox
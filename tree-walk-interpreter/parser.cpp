@@ -1,18 +1,54 @@
 #include "parser.h"
 
-#include <functional>
 #include <memory>
-#include <numeric>
 #include <optional>
 #include <utility>
 
+#include "symbolTable.h"
 #include "syntaxTree.h"
 #include "tokens.h"
-#include "variantOverload.h"
 
 namespace lox {
 
-std::unique_ptr<Expression> Parser::Expr() { return Assign(); }
+// clang-format off
+const std::array<Parser::ParseRule, kTokenTypeCount> Parser::rules_ = [] {
+    std::array<ParseRule, kTokenTypeCount> r{};
+    auto set = [&r](TokenType t, PrefixFn prefix, InfixFn infix,
+                    Precedence prec) {
+        r[static_cast<std::size_t>(t)] = {prefix, infix, prec};
+    };
+    set(TokenType::LEFT_PAREN,    &Parser::Grp,  &Parser::Cll,  Precedence::CALL);
+    set(TokenType::DOT,           nullptr,       &Parser::Dt,   Precedence::CALL);
+    set(TokenType::LEFT_BRACKET,  &Parser::Lst,  &Parser::Sbs,  Precedence::CALL);
+    set(TokenType::LEFT_BRACE,    &Parser::Mp,   nullptr,       Precedence::NONE);
+    set(TokenType::MINUS,         &Parser::Unry, &Parser::Bnry, Precedence::TERM);
+    set(TokenType::PLUS,          nullptr,       &Parser::Bnry, Precedence::TERM);
+    set(TokenType::SLASH,         nullptr,       &Parser::Bnry, Precedence::FACTOR);
+    set(TokenType::STAR,          nullptr,       &Parser::Bnry, Precedence::FACTOR);
+    set(TokenType::BANG,          &Parser::Unry, nullptr,       Precedence::NONE);
+    set(TokenType::BANG_EQUAL,    nullptr,       &Parser::Bnry, Precedence::EQUALITY);
+    set(TokenType::EQUAL_EQUAL,   nullptr,       &Parser::Bnry, Precedence::EQUALITY);
+    set(TokenType::GREATER,       nullptr,       &Parser::Bnry, Precedence::COMPARISON);
+    set(TokenType::GREATER_EQUAL, nullptr,       &Parser::Bnry, Precedence::COMPARISON);
+    set(TokenType::LESS,          nullptr,       &Parser::Bnry, Precedence::COMPARISON);
+    set(TokenType::LESS_EQUAL,    nullptr,       &Parser::Bnry, Precedence::COMPARISON);
+    set(TokenType::IDENTIFIER,    &Parser::Var,  nullptr,       Precedence::NONE);
+    set(TokenType::STRING,        &Parser::Lit,  nullptr,       Precedence::NONE);
+    set(TokenType::NUMBER,        &Parser::Lit,  nullptr,       Precedence::NONE);
+    set(TokenType::AND,           nullptr,       &Parser::And,  Precedence::AND);
+    set(TokenType::OR,            nullptr,       &Parser::Or,   Precedence::OR);
+    set(TokenType::FALSE,         &Parser::Lit,  nullptr,       Precedence::NONE);
+    set(TokenType::TRUE,          &Parser::Lit,  nullptr,       Precedence::NONE);
+    set(TokenType::NIL,           &Parser::Lit,  nullptr,       Precedence::NONE);
+    set(TokenType::THIS,          &Parser::Ths,  nullptr,       Precedence::NONE);
+    set(TokenType::SUPER,         &Parser::Spr,  nullptr,       Precedence::NONE);
+    return r;
+}();
+// clang-format on
+
+std::unique_ptr<Expression> Parser::Expr() {
+    return ParsePrecedence(Precedence::ASSIGNMENT);
+}
 
 bool Parser::Check(TokenType type) const {
     if (IsAtEnd()) {
@@ -21,12 +57,8 @@ bool Parser::Check(TokenType type) const {
     return Peek().Type == type;
 }
 
-bool Parser::Match(std::initializer_list<TokenType> tokens) {
-    bool c = std::transform_reduce(tokens.begin(), tokens.end(), false,
-                                   std::logical_or(),
-                                   [&](auto x) { return Parser::Check(x); });
-
-    if (c) {
+bool Parser::Match(TokenType type) {
+    if (Check(type)) {
         Advance();
         return true;
     }
@@ -34,122 +66,127 @@ bool Parser::Match(std::initializer_list<TokenType> tokens) {
     return false;
 }
 
-Token Parser::Previous() const { return tokens_[current_ - 1]; }
+const Token& Parser::Previous() const { return tokens_.Tokens[current_ - 1]; }
 
-Token Parser::Peek() const { return tokens_[current_]; }
+const Token& Parser::Peek() const { return tokens_.Tokens[current_]; }
 
 std::optional<Token> Parser::PeekNext() const {
     auto next_current = current_ + 1;
-    return (next_current < std::size(tokens_))
-               ? std::optional<Token>(tokens_[next_current])
+    return (next_current < std::size(tokens_.Tokens))
+               ? std::optional<Token>(tokens_.Tokens[next_current])
                : std::optional<Token>();
 }
 
-bool Parser::IsAtEnd() const { return current_ >= std::size(tokens_) - 1; }
+bool Parser::IsAtEnd() const {
+    return current_ >= std::size(tokens_.Tokens) - 1;
+}
 
-Token Parser::Advance() {
+const Token& Parser::Advance() {
     if (!IsAtEnd()) {
         current_++;
     }
     return Previous();
 }
 
-std::unique_ptr<Expression> Parser::Equality() {
-    auto expr = Comparison();
-
-    while (Match({TokenType::BANG_EQUAL, TokenType::EQUAL_EQUAL})) {
-        auto op = Previous();
-        auto right = Comparison();
-
-        expr =
-            std::make_unique<BinaryExpr>(std::move(expr), std::move(right), op);
+std::unique_ptr<Expression> Parser::ParsePrecedence(Precedence precedence) {
+    PrefixFn prefix = GetRule(Peek().Type).Prefix;
+    if (prefix == nullptr) {
+        throw Error(Peek(), "Expected Expression");
     }
+    Advance();
 
-    return expr;
-}
-
-std::unique_ptr<Expression> Parser::Comparison() {
-    auto expr = Term();
+    // Only the loosest level may be the target of an assignment, so "a + b =
+    // c" doesn't parse as "a + (b = c)".
+    bool can_assign = precedence <= Precedence::ASSIGNMENT;
+    std::unique_ptr<Expression> expr = (this->*prefix)(can_assign);
 
-    while (Match({TokenType::GREATER, TokenType::GREATER_EQUAL, TokenType::LESS,
-                  TokenType::LESS_EQUAL})) {
-        Token op = Previous();
-        auto right = Term();
-        expr =
-            std::make_unique<BinaryExpr>(std::move(expr), std::move(right), op);
+    while (precedence <= GetRule(Peek().Type).Prec) {
+        InfixFn infix = GetRule(Advance().Type).Infix;
+        expr = (this->*infix)(std::move(expr), can_assign);
     }
 
-    return expr;
-}
-
-std::unique_ptr<Expression> Parser::Term() {
-    auto expr = Factor();
-
-    while (Match({TokenType::MINUS, TokenType::PLUS})) {
-        Token op = Previous();
-        expr = std::make_unique<BinaryExpr>(std::move(expr), Factor(), op);
+    if (can_assign && Match(TokenType::EQUAL)) {
+        Error(Previous(), "Invalid assignment target.");
     }
 
     return expr;
 }
 
-std::unique_ptr<Expression> Parser::Factor() {
-    auto expr = Unary();
-
-    while (Match({TokenType::SLASH, TokenType::STAR})) {
-        Token op = Previous();
-        expr = std::make_unique<BinaryExpr>(std::move(expr), Factor(), op);
-    }
+std::unique_ptr<Expression> Parser::Grp(bool) {
+    auto expr = Expr();
+    Consume(TokenType::RIGHT_PAREN, "Expected ')' after expression");
+    return std::make_unique<Grouping>(std::move(expr));
+}
 
-    return expr;
+std::unique_ptr<Expression> Parser::Unry(bool) {
+    Token op = Previous();
+    auto operand = ParsePrecedence(Precedence::UNARY);
+    return std::make_unique<UnaryExpr>(std::move(operand), op);
 }
 
-std::unique_ptr<Expression> Parser::Unary() {
-    if (Match({TokenType::BANG, TokenType::MINUS})) {
-        return std::make_unique<UnaryExpr>(Unary(), Previous());
+std::unique_ptr<Expression> Parser::Lit(bool) {
+    const Token& tok = Previous();
+    switch (tok.Type) {
+        case TokenType::FALSE:
+            return std::make_unique<Literal>(false);
+        case TokenType::TRUE:
+            return std::make_unique<Literal>(true);
+        case TokenType::NIL:
+            return std::make_unique<Literal>(std::monostate());
+        case TokenType::NUMBER:
+            return std::make_unique<Literal>(tokens_.Numbers[tok.Value]);
+        case TokenType::STRING:
+            return std::make_unique<Literal>(tokens_.Strings[tok.Value]);
+        default:
+            break;
     }
 
-    return Cll();
+    throw Error(tok, "Expected Expression");
 }
 
-std::unique_ptr<Expression> Parser::Primary() {
-    if (Match({TokenType::FALSE})) {
-        return std::make_unique<Literal>(false);
-    }
-    if (Match({TokenType::TRUE})) {
-        return std::make_unique<Literal>(true);
-    }
-    if (Match({TokenType::NIL})) {
-        return std::make_unique<Literal>(std::monostate());
+std::unique_ptr<Expression> Parser::Var(bool can_assign) {
+    Token name = Previous();
+    if (can_assign && Match(TokenType::EQUAL)) {
+        auto value = ParsePrecedence(Precedence::ASSIGNMENT);
+        return std::make_unique<Assignment>(std::move(name), std::move(value));
     }
+    return std::make_unique<Variable>(std::move(name));
+}
 
-    if (Match({TokenType::NUMBER, TokenType::STRING})) {
-        auto token_data = Previous().Data;
-        auto lit_data = std::visit(
-            overload{
-                [](std::string lit) {
-                    return std::optional<Literal::ValueType>{lit};
-                },
-                [](double d) { return std::optional<Literal::ValueType>{d}; },
-                [](auto _) { return std::optional<Literal::ValueType>{}; }},
-            token_data);
+std::unique_ptr<Expression> Parser::Ths(bool) {
+    return std::make_unique<Variable>(ThisToken(Previous().Line));
+}
 
-        if (lit_data.has_value()) {
-            return std::make_unique<Literal>(*lit_data);
-        }
-    }
+std::unique_ptr<Expression> Parser::Spr(bool) {
+    Token keyword = Previous();
+    Consume(TokenType::DOT, "Expect '.' after 'super'.");
+    Token method =
+        Consume(TokenType::IDENTIFIER, "Expect superclass method name.");
+    return std::make_unique<Super>(keyword, method);
+}
 
-    if (Match({TokenType::IDENTIFIER})) {
-        return std::make_unique<Variable>(Previous());
-    }
+std::unique_ptr<Expression> Parser::Bnry(std::unique_ptr<Expression>&& left,
+                                         bool) {
+    Token op = Previous();
+    // Parse the right operand one level tighter, so the operators are left
+    // associative.
+    auto prec = static_cast<int>(GetRule(op.Type).Prec) + 1;
+    auto right = ParsePrecedence(static_cast<Precedence>(prec));
+    return std::make_unique<BinaryExpr>(std::move(left), std::move(right), op);
+}
 
-    if (Match({TokenType::LEFT_PAREN})) {
-        auto expr = Expr();
-        Consume(TokenType::RIGHT_PAREN, "Expected ')' after expression");
-        return std::make_unique<Grouping>(std::move(expr));
-    }
+std::unique_ptr<Expression> Parser::And(std::unique_ptr<Expression>&& left,
+                                        bool) {
+    Token op = Previous();
+    auto right = ParsePrecedence(Precedence::EQUALITY);
+    return std::make_unique<Logical>(op, std::move(left), std::move(right));
+}
 
-    throw Error(Peek(), "Expected Expression");
+std::unique_ptr<Expression> Parser::Or(std::unique_ptr<Expression>&& left,
+                                       bool) {
+    Token op = Previous();
+    auto right = ParsePrecedence(Precedence::AND);
+    return std::make_unique<Logical>(op, std::move(left), std::move(right));
 }
 
 void Parser::Synchronize() {
@@ -168,6 +205,7 @@ void Parser::Synchronize() {
             case TokenType::WHILE:
             case TokenType::PRINT:
             case TokenType::RETURN:
+            case TokenType::YIELD:
                 return;
             default:
                 break;
@@ -190,24 +228,27 @@ std::unique_ptr<Statement> Parser::PrintSmt() {
 }
 
 std::unique_ptr<Statement> Parser::Smt() {
-    if (Match({TokenType::PRINT})) {
+    if (Match(TokenType::PRINT)) {
         return PrintSmt();
     }
-    if (Match({TokenType::FOR})) {
+    if (Match(TokenType::FOR)) {
         return Fr();
     }
-    if (Match({TokenType::WHILE})) {
+    if (Match(TokenType::WHILE)) {
         return Whl();
     }
-    if (Match({TokenType::LEFT_BRACE})) {
+    if (Match(TokenType::LEFT_BRACE)) {
         return Blck();
     }
-    if (Match({TokenType::IF})) {
+    if (Match(TokenType::IF)) {
         return IfSmt();
     }
-    if (Match({TokenType::RETURN})) {
+    if (Match(TokenType::RETURN)) {
         return Rtrn();
     }
+    if (Match(TokenType::YIELD)) {
+        return Yld();
+    }
 
     return ExprSmt();
 }
@@ -216,7 +257,7 @@ std::unique_ptr<Statement> Parser::VarDeclaration() {
     auto name = Consume(TokenType::IDENTIFIER, "Expected variable name.");
 
     std::unique_ptr<Expression> initializer = nullptr;
-    if (Match({TokenType::EQUAL})) {
+    if (Match(TokenType::EQUAL)) {
         initializer = Expr();
     }
 
@@ -227,10 +268,13 @@ std::unique_ptr<Statement> Parser::VarDeclaration() {
 
 std::unique_ptr<Statement> Parser::Decl() {
     try {
-        if (Match({TokenType::FUN})) {
+        if (Match(TokenType::CLASS)) {
+            return ClassDecl();
+        }
+        if (Match(TokenType::FUN)) {
             return FunDecl("function");
         }
-        if (Match({TokenType::VAR})) {
+        if (Match(TokenType::VAR)) {
             return VarDeclaration();
         }
 
@@ -241,23 +285,6 @@ std::unique_ptr<Statement> Parser::Decl() {
     }
 }
 
-std::unique_ptr<Expression> Parser::Assign() {
-    std::unique_ptr<Expression> expr = Or();
-    if (Match({TokenType::EQUAL})) {
-        Token equals = Previous();
-        std::unique_ptr<Expression> value = Assign();
-
-        Variable* var = dynamic_cast<Variable*>(expr.get());
-        if (var != nullptr) {
-            return std::make_unique<Assignment>(var->Name, std::move(value));
-        }
-
-        Error(equals, "Invalid assignment target.");
-    }
-
-    return expr;
-}
-
 std::unique_ptr<Block> Parser::Blck() {
     std::vector<std::shared_ptr<Statement>> statements;
 
@@ -276,7 +303,7 @@ std::unique_ptr<Statement> Parser::IfSmt() {
 
     std::unique_ptr<Statement> thenBranch = Smt();
     std::unique_ptr<Statement> elseBranch = nullptr;
-    if (Match({TokenType::ELSE})) {
+    if (Match(TokenType::ELSE)) {
         elseBranch = Smt();
     }
 
@@ -284,30 +311,6 @@ std::unique_ptr<Statement> Parser::IfSmt() {
         std::move(condition), std::move(thenBranch), std::move(elseBranch));
 }
 
-std::unique_ptr<Expression> Parser::And() {
-    std::unique_ptr<Expression> expr = Equality();
-
-    while (Match({TokenType::AND})) {
-        Token op = Previous();
-        std::unique_ptr<Expression> right = Equality();
-        expr = std::make_unique<Logical>(op, std::move(expr), std::move(right));
-    }
-
-    return expr;
-}
-
-std::unique_ptr<Expression> Parser::Or() {
-    std::unique_ptr<Expression> expr = And();
-
-    while (Match({TokenType::OR})) {
-        Token op = Previous();
-        std::unique_ptr<Expression> right = Equality();
-        expr = std::make_unique<Logical>(op, std::move(expr), std::move(right));
-    }
-
-    return expr;
-}
-
 std::unique_ptr<Statement> Parser::Whl() {
     Consume(TokenType::LEFT_PAREN, "Expect '(' after 'while'.");
     std::unique_ptr<Expression> condition = Expr();
@@ -321,9 +324,9 @@ std::unique_ptr<Statement> Parser::Fr() {
     Consume(TokenType::LEFT_PAREN, "Expect '(' after 'for'.");
 
     std::unique_ptr<Statement> initializer;
-    if (Match({TokenType::SEMICOLON})) {
+    if (Match(TokenType::SEMICOLON)) {
         initializer = nullptr;
-    } else if (Match({TokenType::VAR})) {
+    } else if (Match(TokenType::VAR)) {
         initializer = VarDeclaration();
     } else {
         initializer = ExprSmt();
@@ -336,19 +339,19 @@ std::unique_ptr<Statement> Parser::Fr() {
     Consume(TokenType::SEMICOLON, "Expect ';' after loop condition");
 
     std::unique_ptr<Expression> increment;
-    if (!Check(TokenType::SEMICOLON)) {
+    if (!Check(TokenType::RIGHT_PAREN)) {
         increment = Expr();
     }
-    Match({TokenType::SEMICOLON});  // remove the optional ;
+    Match(TokenType::SEMICOLON);  // remove the optional ;
     Consume(TokenType::RIGHT_PAREN, "Expect ')' after 'for'.");
 
-    std::unique_ptr<Block> body = std::make_unique<Block>();
-    if (increment != nullptr)
-
-    {
-        body->Statements.push_back(Smt());
-        body->Statements.push_back(
+    std::unique_ptr<Statement> body = Smt();
+    if (increment != nullptr) {
+        std::unique_ptr<Block> body_with_increment = std::make_unique<Block>();
+        body_with_increment->Statements.push_back(std::move(body));
+        body_with_increment->Statements.push_back(
             std::make_unique<ExpressionStatement>(std::move(increment)));
+        body = std::move(body_with_increment);
     }
 
     if (condition == nullptr) {
@@ -368,22 +371,8 @@ std::unique_ptr<Statement> Parser::Fr() {
     return loop;
 }
 
-std::unique_ptr<Expression> Parser::Cll() {
-    std::unique_ptr<Expression> expression = Primary();
-
-    while (true) {
-        if (Match({TokenType::LEFT_PAREN})) {
-            expression = FinishCall(std::move(expression));
-        } else {
-            break;
-        }
-    }
-
-    return std::move(expression);
-}
-
-std::unique_ptr<Expression> Parser::FinishCall(
-    std::unique_ptr<Expression>&& callee) {
+std::unique_ptr<Expression> Parser::Cll(std::unique_ptr<Expression>&& callee,
+                                        bool) {
     // Take all available the arguments (might be no arguments, one or many
     // arguments).
     Token op = Previous();
@@ -394,14 +383,99 @@ std::unique_ptr<Expression> Parser::FinishCall(
                 Error(Peek(), "Can't have more then 255 arguments");
             }
             arguments.push_back(Expr());
-        } while (Match({TokenType::COMMA}));
+        } while (Match(TokenType::COMMA));
     }
     Consume(TokenType::RIGHT_PAREN, "Expect ')' after parameters.");
 
     return std::make_unique<Call>(std::move(callee), op, std::move(arguments));
 }
 
-std::unique_ptr<Statement> Parser::FunDecl(std::string&& kind) {
+std::unique_ptr<Expression> Parser::Dt(std::unique_ptr<Expression>&& object,
+                                       bool can_assign) {
+    Token name =
+        Consume(TokenType::IDENTIFIER, "Expect property name after '.'.");
+    if (can_assign && Match(TokenType::EQUAL)) {
+        auto value = ParsePrecedence(Precedence::ASSIGNMENT);
+        return std::make_unique<Set>(std::move(object), name,
+                                     std::move(value));
+    }
+    return std::make_unique<Get>(std::move(object), name);
+}
+
+std::unique_ptr<Expression> Parser::Sbs(std::unique_ptr<Expression>&& object,
+                                        bool can_assign) {
+    Token bracket = Previous();
+    auto key = Expr();
+    Consume(TokenType::RIGHT_BRACKET, "Expect ']' after subscript.");
+    if (can_assign && Match(TokenType::EQUAL)) {
+        auto value = ParsePrecedence(Precedence::ASSIGNMENT);
+        return std::make_unique<SetSubscript>(std::move(object), bracket,
+                                              std::move(key), std::move(value));
+    }
+    return std::make_unique<Subscript>(std::move(object), bracket,
+                                       std::move(key));
+}
+
+std::unique_ptr<Expression> Parser::Lst(bool) {
+    Token bracket = Previous();
+    std::vector<std::unique_ptr<Expression>> elements;
+    if (!Check(TokenType::RIGHT_BRACKET)) {
+        do {
+            if (std::size(elements) >= 255) {
+                Error(Peek(), "Can't have more than 255 elements.");
+            }
+            elements.push_back(Expr());
+        } while (Match(TokenType::COMMA));
+    }
+    Consume(TokenType::RIGHT_BRACKET, "Expect ']' after list elements.");
+    return std::make_unique<ListLiteral>(bracket, std::move(elements));
+}
+
+// Only reached in expressions, a '{' starting a statement is a block.
+std::unique_ptr<Expression> Parser::Mp(bool) {
+    Token brace = Previous();
+    std::vector<std::unique_ptr<Expression>> keys;
+    std::vector<std::unique_ptr<Expression>> values;
+    if (!Check(TokenType::RIGHT_BRACE)) {
+        do {
+            if (std::size(keys) >= 255) {
+                Error(Peek(), "Can't have more than 255 entries.");
+            }
+            keys.push_back(Expr());
+            Consume(TokenType::COLON, "Expect ':' after map key.");
+            values.push_back(Expr());
+        } while (Match(TokenType::COMMA));
+    }
+    Consume(TokenType::RIGHT_BRACE, "Expect '}' after map entries.");
+    return std::make_unique<MapLiteral>(brace, std::move(keys),
+                                        std::move(values));
+}
+
+std::unique_ptr<Statement> Parser::ClassDecl() {
+    Token name = Consume(TokenType::IDENTIFIER, "Expect class name.");
+
+    std::unique_ptr<Variable> superclass;
+    if (Match(TokenType::LESS)) {
+        superclass = std::make_unique<Variable>(
+            Consume(TokenType::IDENTIFIER, "Expect superclass name."));
+    }
+
+    Consume(TokenType::LEFT_BRACE, "Expect '{' before class body.");
+    std::vector<std::unique_ptr<FunctionDeclaration>> methods;
+    while (!Check(TokenType::RIGHT_BRACE) && !IsAtEnd()) {
+        auto method = FunDecl("method");
+        method->Kind = Symbols().Name(method->Name.Value) == "init"
+                           ? FunctionKind::INITIALIZER
+                           : FunctionKind::METHOD;
+        methods.push_back(std::move(method));
+    }
+    Consume(TokenType::RIGHT_BRACE, "Expect '}' after class body.");
+
+    return std::make_unique<ClassDeclaration>(name, std::move(superclass),
+                                              std::move(methods));
+}
+
+std::unique_ptr<FunctionDeclaration> Parser::FunDecl(std::string&& kind) {
     Token name = Consume(TokenType::IDENTIFIER,
                          std::string("Expect ") + kind + std::string(" name."));
     Consume(TokenType::LEFT_PAREN,
@@ -415,7 +489,7 @@ std::unique_ptr<Statement> Parser::FunDecl(std::string&& kind) {
 
             parameters.push_back(
                 Consume(TokenType::IDENTIFIER, "Expect parameter name."));
-        } while (Match({TokenType::COMMA}));
+        } while (Match(TokenType::COMMA));
     }
     Consume(TokenType::RIGHT_PAREN, "Expect ')' after parameters.");
 
@@ -436,7 +510,20 @@ std::unique_ptr<Statement> Parser::Rtrn()
     }
 
     Consume(TokenType::SEMICOLON, "Expect ';' after return value.");
-    return std::make_unique<ReturnStatement>(std::move(value));
+    return std::make_unique<ReturnStatement>(keyword, std::move(value));
+}
+
+std::unique_ptr<Statement> Parser::Yld()
+{
+    Token keyword = Previous();
+    std::unique_ptr<Expression> value = nullptr;
+
+    if(!Check(TokenType::SEMICOLON)){
+        value = Expr();
+    }
+
+    Consume(TokenType::SEMICOLON, "Expect ';' after yield value.");
+    return std::make_unique<YieldStatement>(keyword, std::move(value));
 }
 
 }  // namespace lox
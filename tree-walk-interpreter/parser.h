@@ -1,3 +1,6 @@
+#pragma once
+
+#include <array>
 #include <memory>
 #include <optional>
 #include <string>
@@ -9,13 +12,28 @@
 
 namespace lox {
 
+// Binding power of the expression operators, from loose to tight.
+enum class Precedence {
+    NONE,
+    ASSIGNMENT,  // =
+    OR,          // or
+    AND,         // and
+    EQUALITY,    // == !=
+    COMPARISON,  // < > <= >=
+    TERM,        // + -
+    FACTOR,      // * /
+    UNARY,       // ! -
+    CALL,        // . ()
+    PRIMARY
+};
+
 class Parser {
    private:
-    const std::vector<Token>& tokens_;
+    const TokenList& tokens_;
     int current_ = 0;
 
    public:
-    Parser(std::vector<Token>& tokens) : tokens_(tokens) {}
+    Parser(const TokenList& tokens) : tokens_(tokens) {}
 
     std::vector<std::unique_ptr<Statement>> Parse() {
         std::vector<std::unique_ptr<Statement>> statements;
@@ -35,16 +53,16 @@ class Parser {
     struct ParseError {};
 
     // Consume the current token, and return it.
-    Token Advance();
+    const Token& Advance();
 
     // Return the current token.
-    Token Peek() const;
+    const Token& Peek() const;
 
     // Return the next token, which might not exist so optional.
     std::optional<Token> PeekNext() const;
 
     // Return the previous token, aka the last consumed token.
-    Token Previous() const;
+    const Token& Previous() const;
 
     // Check if the next token type equals some type.
     bool Check(TokenType type) const;
@@ -52,45 +70,79 @@ class Parser {
     // Check if their are more token to be consumed.
     bool IsAtEnd() const;
 
-    static void ReportError(Token token, std::string&& message) {
+    void ReportError(const Token& token, std::string&& message) const {
         if (token.Type == TokenType::EOFL) {
             Report(token.Line, " at end", std::move(message));
         } else {
             std::string err_msg = " at ";
-            err_msg.append(token.Lexeme);
+            err_msg.append(tokens_.Lexeme(token));
 
             Report(token.Line, std::move(err_msg), std::move(message));
         }
     }
 
-    ParseError Error(Token token, std::string&& message) {
+    ParseError Error(const Token& token, std::string&& message) {
         ReportError(token, std::move(message));
         return ParseError();
     }
 
+    // Prefix handlers are called with the token that starts the expression
+    // already consumed, infix handlers with the operator consumed and the
+    // left operand parsed.
+    using PrefixFn = std::unique_ptr<Expression> (Parser::*)(bool can_assign);
+    using InfixFn = std::unique_ptr<Expression> (Parser::*)(
+        std::unique_ptr<Expression>&& left, bool can_assign);
+
+    struct ParseRule {
+        PrefixFn Prefix;
+        InfixFn Infix;
+        Precedence Prec;
+    };
+
+    static const std::array<ParseRule, kTokenTypeCount> rules_;
+
+    static const ParseRule& GetRule(TokenType type) {
+        return rules_[static_cast<std::size_t>(type)];
+    }
+
     std::unique_ptr<Expression> Expr();
 
-    std::unique_ptr<Expression> Equality();
+    // Parse any expression binding at least as tight as precedence.
+    std::unique_ptr<Expression> ParsePrecedence(Precedence precedence);
+
+    std::unique_ptr<Expression> Grp(bool can_assign);
+
+    std::unique_ptr<Expression> Unry(bool can_assign);
+
+    std::unique_ptr<Expression> Lit(bool can_assign);
 
-    std::unique_ptr<Expression> Comparison();
+    std::unique_ptr<Expression> Var(bool can_assign);
 
-    std::unique_ptr<Expression> Term();
+    std::unique_ptr<Expression> Bnry(std::unique_ptr<Expression>&& left,
+                                     bool can_assign);
 
-    std::unique_ptr<Expression> Factor();
+    std::unique_ptr<Expression> And(std::unique_ptr<Expression>&& left,
+                                    bool can_assign);
 
-    std::unique_ptr<Expression> Unary();
+    std::unique_ptr<Expression> Or(std::unique_ptr<Expression>&& left,
+                                   bool can_assign);
 
-    std::unique_ptr<Expression> Primary();
+    std::unique_ptr<Expression> Cll(std::unique_ptr<Expression>&& callee,
+                                    bool can_assign);
 
-    std::unique_ptr<Expression> Assign();
+    std::unique_ptr<Expression> Dt(std::unique_ptr<Expression>&& object,
+                                   bool can_assign);
 
-    std::unique_ptr<Expression> And();
+    std::unique_ptr<Expression> Sbs(std::unique_ptr<Expression>&& object,
+                                    bool can_assign);
 
-    std::unique_ptr<Expression> Or();
+    std::unique_ptr<Expression> Ths(bool can_assign);
 
-    std::unique_ptr<Expression> Cll();
+    std::unique_ptr<Expression> Lst(bool can_assign);
 
-    std::unique_ptr<Expression> FinishCall(std::unique_ptr<Expression>&&);
+    std::unique_ptr<Expression> Mp(bool can_assign);
+
+    std::unique_ptr<Expression> Spr(bool can_assign);
 
     std::unique_ptr<Statement> ExprSmt();
 
@@ -110,11 +162,15 @@ class Parser {
 
     std::unique_ptr<Statement> Fr();
 
-    std::unique_ptr<Statement> FunDecl(std::string&&);
+    std::unique_ptr<FunctionDeclaration> FunDecl(std::string&&);
+
+    std::unique_ptr<Statement> ClassDecl();
 
     std::unique_ptr<Statement> Rtrn();
 
-    Token Consume(TokenType type, std::string&& message) {
+    std::unique_ptr<Statement> Yld();
+
+    const Token& Consume(TokenType type, std::string&& message) {
         if (Check(type)) {
             return Advance();
         }
@@ -122,10 +178,10 @@ class Parser {
         throw Error(Peek(), std::move(message));
     }
 
-    // Check if the next token equals one of the provided token types.
+    // Check if the next token equals the provided token type.
     // If it matches it returns true, and consume the token. Otherwise
     // return false.
-    bool Match(std::initializer_list<TokenType> tokens);
+    bool Match(TokenType type);
 
     void Synchronize();
 };
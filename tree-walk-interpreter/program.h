@@ -0,0 +1,20 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "syntaxTree.h"
+
+namespace lox {
+
+// A script that is scanned, parsed, resolved and optimized, what the
+// Compiler needs. Compiling only reads it, so interpreters on different
+// threads can run the same program at once.
+struct Program {
+    std::vector<std::unique_ptr<Statement>> Statements;
+    // The distance to the scope of each local variable.
+    std::map<Expression*, int> Locals;
+};
+
+}  // namespace lox
@@ -4,18 +4,20 @@
 
 namespace lox {
 
-void Resolver::Declare(Token name) {
+void Resolver::Declare(Token name, bool* captured) {
     if (std::empty(scopes)) {
         return;
     }
-    scopes.back().insert({name.Lexeme, false});
+    // A redeclaration in the same scope keeps whether it's defined, uses
+    // from now on are of the new declaration.
+    scopes.back()[name.Value].Declaration = captured;
 }
 
 void Resolver::Define(Token name) {
     if (std::empty(scopes)) {
         return;
     }
-    scopes.back().insert_or_assign(name.Lexeme, true);
+    scopes.back()[name.Value].Defined = true;
 }
 
 void Resolver::Resolve(std::vector<std::shared_ptr<Statement>>& statements) {
@@ -30,7 +32,7 @@ void Resolver::Resolve(std::vector<std::unique_ptr<Statement>>& statements) {
     }
 }
 
-void Resolver::BeginScope() { scopes.push_back(std::map<std::string, bool>()); }
+void Resolver::BeginScope() { scopes.emplace_back(); }
 
 void Resolver::EndScope() { scopes.pop_back(); }
 
@@ -51,20 +53,33 @@ void Resolver::Visit(Grouping& g) { Resolve(*g.Expr); }
 
 void Resolver::ResolveLocal(Expression* expr, Token Name) {
     for (int i = std::size(scopes) - 1; i >= 0; --i) {
-        if (scopes[i].find(Name.Lexeme) != scopes[i].end()) {
+        auto local = scopes[i].find(Name.Value);
+        if (local != scopes[i].end()) {
             // We found the symbol, tell the resolver where the symbol is located.
-            interpreter_.Resolve(expr, std::size(scopes) - 1 - i);
+            if (static_cast<std::size_t>(i) < function_scope_) {
+                // Used by a nested function.
+                local->second.Captured = true;
+                if (local->second.Declaration != nullptr) {
+                    *local->second.Declaration = true;
+                }
+            }
+            locals_.insert(
+                {expr, static_cast<int>(std::size(scopes) - 1 - i)});
             return;
         }
     }
 }
 
 void Resolver::Visit(Variable& v) {
+    if (v.Name.Type == TokenType::THIS && class_ == ClassType::NONE) {
+        lox::Error(v.Name.Line, "Can't use 'this' outside of a class.");
+        return;
+    }
     if (!std::empty(scopes)) {
         // Check if the varaible is accessed inside its own initializer.
-        auto val = scopes.back().find(v.Name.Lexeme);
+        auto val = scopes.back().find(v.Name.Value);
         if (val != scopes.back().end() &&
-            !val->second) {  // if the var exists, and has not been init.
+            !val->second.Defined) {  // if the var exists, and has not been init.
             lox::Error(v.Name.Line,
                        "can't read the local variable in its own intializer");
             return;
@@ -91,12 +106,57 @@ void Resolver::Visit(Call& c) {
     }
 }
 
+void Resolver::Visit(Get& g) { Resolve(*g.Object); }
+
+void Resolver::Visit(Set& s) {
+    Resolve(*s.Value);
+    Resolve(*s.Object);
+}
+
+void Resolver::Visit(Super& s) {
+    if (class_ == ClassType::NONE) {
+        lox::Error(s.Method.Line, "Can't use 'super' outside of a class.");
+        return;
+    }
+    if (class_ != ClassType::SUBCLASS) {
+        lox::Error(s.Method.Line,
+                   "Can't use 'super' in a class with no superclass.");
+        return;
+    }
+    Resolve(*s.Superclass);
+    Resolve(*s.This);
+}
+
+void Resolver::Visit(ListLiteral& l) {
+    for (auto& e : l.Elements) {
+        Resolve(*e);
+    }
+}
+
+void Resolver::Visit(MapLiteral& m) {
+    for (std::size_t i = 0; i < std::size(m.Keys); ++i) {
+        Resolve(*m.Keys[i]);
+        Resolve(*m.Values[i]);
+    }
+}
+
+void Resolver::Visit(Subscript& s) {
+    Resolve(*s.Object);
+    Resolve(*s.Key);
+}
+
+void Resolver::Visit(SetSubscript& s) {
+    Resolve(*s.Object);
+    Resolve(*s.Key);
+    Resolve(*s.Value);
+}
+
 void Resolver::Visit(PrintStatement& p) { Resolve(*p.Expr); }
 
 void Resolver::Visit(ExpressionStatement& e) { Resolve(*e.Expr); }
 
 void Resolver::Visit(VariableDeclaration& vdecl) {
-    Declare(vdecl.Name);
+    Declare(vdecl.Name, &vdecl.Captured);
     if (vdecl.Initializer != nullptr) {
         Resolve(*vdecl.Initializer);
     }
@@ -124,18 +184,40 @@ void Resolver::Visit(While& w) {
 }
 
 void Resolver::ResolveFunction(FunctionDeclaration& f) {
+    auto enclosing_function_scope = function_scope_;
+    auto enclosing_in_initializer = in_initializer_;
+    auto enclosing_in_function = in_function_;
+    function_scope_ = std::size(scopes);
+    in_initializer_ = f.Kind == FunctionKind::INITIALIZER;
+    in_function_ = true;
     BeginScope();
+    bool method = f.Kind != FunctionKind::FUNCTION;
+    auto this_token = ThisToken(f.Name.Line);
+    if (method) {
+        Declare(this_token);
+        Define(this_token);
+    }
     for (auto& param : f.Params) {
         Declare(param);
         Define(param);
     }
 
     Resolve(f.Body);
+    f.CapturedParams.clear();
+    if (method) {
+        f.CapturedParams.push_back(scopes.back()[this_token.Value].Captured);
+    }
+    for (auto& param : f.Params) {
+        f.CapturedParams.push_back(scopes.back()[param.Value].Captured);
+    }
     EndScope();
+    function_scope_ = enclosing_function_scope;
+    in_initializer_ = enclosing_in_initializer;
+    in_function_ = enclosing_in_function;
 }
 
 void Resolver::Visit(FunctionDeclaration& s) {
-    Declare(s.Name);
+    Declare(s.Name, &s.Captured);
     Define(s.Name);
 
     ResolveFunction(s);
@@ -143,8 +225,53 @@ void Resolver::Visit(FunctionDeclaration& s) {
 
 void Resolver::Visit(ReturnStatement& r) {
     if (r.Value != nullptr) {
+        if (in_initializer_) {
+            lox::Error(r.Keyword.Line,
+                       "Can't return a value from an initializer.");
+        }
         Resolve(*r.Value);
     }
 }
 
+void Resolver::Visit(YieldStatement& y) {
+    if (!in_function_) {
+        lox::Error(y.Keyword.Line, "Can't yield from top-level code.");
+    } else if (in_initializer_) {
+        lox::Error(y.Keyword.Line, "Can't yield from an initializer.");
+    }
+    if (y.Value != nullptr) {
+        Resolve(*y.Value);
+    }
+}
+
+void Resolver::Visit(ClassDeclaration& c) {
+    auto enclosing_class = class_;
+    class_ = ClassType::CLASS;
+    Declare(c.Name, &c.Captured);
+    Define(c.Name);
+
+    // Methods find the superclass as super, in a scope around them.
+    auto super_token = SuperToken(c.Name.Line);
+    if (c.Superclass != nullptr) {
+        if (c.Superclass->Name.Value == c.Name.Value) {
+            lox::Error(c.Superclass->Name.Line,
+                       "A class can't inherit from itself.");
+        }
+        class_ = ClassType::SUBCLASS;
+        Resolve(*c.Superclass);
+        BeginScope();
+        Declare(super_token, &c.SuperCaptured);
+        Define(super_token);
+    }
+
+    for (auto& method : c.Methods) {
+        ResolveFunction(*method);
+    }
+
+    if (c.Superclass != nullptr) {
+        EndScope();
+    }
+    class_ = enclosing_class;
+}
+
 }  // namespace lox
@@ -3,21 +3,43 @@
 #include "interpreter.h"
 #include "syntaxTree.h"
 #include <map>
+#include <unordered_map>
 #include <vector>
 
+#include "symbolTable.h"
+
 namespace lox {
 
 class Resolver : ExpressionVisitor, StatementVisitor {
-    Interpreter& interpreter_;
+    // Where the distance to the scope of each local variable goes.
+    std::map<Expression*, int>& locals_;
+
+    struct Local {
+        bool Defined = false;  // Whether its initializer has been resolved.
+        bool Captured = false;  // Whether a nested function uses it.
+        // The flag of the declaration to set when it is captured.
+        bool* Declaration = nullptr;
+    };
 
-    std::vector<std::map<std::string, bool>> scopes;
+    // Per scope, the symbols declared in it.
+    std::vector<std::unordered_map<Symbol, Local>> scopes;
+    // First scope of the function being resolved, variables found in
+    // earlier scopes are captured.
+    std::size_t function_scope_ = 0;
+    // What is being resolved, for the errors about this, super, return and
+    // yield.
+    enum class ClassType { NONE, CLASS, SUBCLASS };
+    ClassType class_ = ClassType::NONE;
+    bool in_initializer_ = false;
+    bool in_function_ = false;
 
     public:
-    Resolver(Interpreter& interpreter) : interpreter_(interpreter) {}
+    Resolver(Interpreter& interpreter) : locals_(interpreter.locals) {}
+    explicit Resolver(std::map<Expression*, int>& locals) : locals_(locals) {}
 
     void BeginScope();
     void EndScope();
-    void Declare(Token name);
+    void Declare(Token name, bool* captured = nullptr);
     void Define(Token name);
     void Resolve(Expression&);
     void Resolve(Statement&);
@@ -35,6 +57,13 @@ class Resolver : ExpressionVisitor, StatementVisitor {
     virtual void Visit(Assignment&) override;
     virtual void Visit(Logical&) override;
     virtual void Visit(Call&) override;
+    virtual void Visit(Get&) override;
+    virtual void Visit(Set&) override;
+    virtual void Visit(Super&) override;
+    virtual void Visit(ListLiteral&) override;
+    virtual void Visit(MapLiteral&) override;
+    virtual void Visit(Subscript&) override;
+    virtual void Visit(SetSubscript&) override;
     virtual void Visit(PrintStatement&) override;
     virtual void Visit(ExpressionStatement&) override;
     virtual void Visit(VariableDeclaration& vdecl) override;
@@ -43,6 +72,8 @@ class Resolver : ExpressionVisitor, StatementVisitor {
     virtual void Visit(While&) override;
     virtual void Visit(FunctionDeclaration&) override;
     virtual void Visit(ReturnStatement&) override;
+    virtual void Visit(YieldStatement&) override;
+    virtual void Visit(ClassDeclaration&) override;
 };
 
 }  // namespace lox
@@ -1,6 +1,7 @@
 #pragma once
 
 #include<string>
+#include<vector>
 #include"syntaxTree.h"
 
 namespace lox{
@@ -8,6 +9,9 @@ namespace lox{
 struct RunTimeError {
     Token Operator;
     std::string ErrorMsg;
+    // The Lox calls that were running, innermost first, filled in when the
+    // error leaves the interpreter.
+    std::vector<std::string> Backtrace;
 };
 
 }
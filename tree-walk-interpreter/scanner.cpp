@@ -1,13 +1,18 @@
 #include "scanner.h"
 
 #include <cctype>
+#include <charconv>
+#include <limits>
+#include <string_view>
+#include <system_error>
 #include <unordered_map>
 
 #include "lox.h"
+#include "symbolTable.h"
 
 namespace lox {
 
-static std::unordered_map<std::string, TokenType> keywords{
+static std::unordered_map<std::string_view, TokenType> keywords{
     {"and", TokenType::AND},       {"class", TokenType::CLASS},
     {"else", TokenType::ELSE},     {"false", TokenType::FALSE},
     {"for", TokenType::FOR},       {"fun", TokenType::FUN},
@@ -15,19 +20,22 @@ static std::unordered_map<std::string, TokenType> keywords{
     {"or", TokenType::OR},         {"print", TokenType::PRINT},
     {"return", TokenType::RETURN}, {"super", TokenType::SUPER},
     {"this", TokenType::THIS},     {"true", TokenType::TRUE},
-    {"var", TokenType::VAR},       {"while", TokenType::WHILE}};
+    {"var", TokenType::VAR},       {"while", TokenType::WHILE},
+    {"yield", TokenType::YIELD}};
 
-Scanner::Scanner(const std::string& source) : source_(source) {}
+Scanner::Scanner(const std::string& source) : source_(source) {
+    tokens_.Source = source_;
+}
 
 bool Scanner::IsAtEnd() const {
     return this->current_ >= std::size(this->source_);
 }
 
-void Scanner::AddToken(TokenType type) { AddToken(type, Token::TokenData()); }
-
-void Scanner::AddToken(TokenType type, Token::TokenData data) {
-    auto text = source_.substr(start_, current_ - start_);
-    tokens_.push_back(Token(type, text, data, line_));
+void Scanner::AddToken(TokenType type, std::uint32_t value) {
+    tokens_.Tokens.push_back(Token{static_cast<std::uint32_t>(start_),
+                                   static_cast<std::uint32_t>(current_ - start_),
+                                   type, static_cast<std::uint32_t>(line_),
+                                   value});
 }
 
 char Scanner::Advance() {
@@ -66,6 +74,12 @@ void Scanner::ScanToken() {
         case '}':
             AddToken(TokenType::RIGHT_BRACE);
             break;
+        case '[':
+            AddToken(TokenType::LEFT_BRACKET);
+            break;
+        case ']':
+            AddToken(TokenType::RIGHT_BRACKET);
+            break;
         case ',':
             AddToken(TokenType::COMMA);
             break;
@@ -81,6 +95,9 @@ void Scanner::ScanToken() {
         case ';':
             AddToken(TokenType::SEMICOLON);
             break;
+        case ':':
+            AddToken(TokenType::COLON);
+            break;
         case '*':
             AddToken(TokenType::STAR);
             break;
@@ -119,7 +136,7 @@ void Scanner::ScanToken() {
         default:
             if (std::isdigit(c) != 0) {
                 number();
-            } else if (std::isalpha(c) != 0) {
+            } else if (IsAlpha(c)) {
                 Identifier();
             } else {
                 Error(line_, "unexpected char.");
@@ -148,17 +165,19 @@ void Scanner::string() {
     // substr in C++ requires start position and length (not stop position);
     int start_pos = start_ + 1;
     int stop_pos = current_ - 1; // ingnore "
-    const std::string value = source_.substr(start_pos, stop_pos - start_pos);
-    AddToken(TokenType::STRING, Token::TokenData(value));
+    tokens_.Strings.push_back(source_.substr(start_pos, stop_pos - start_pos));
+    AddToken(TokenType::STRING,
+             static_cast<std::uint32_t>(std::size(tokens_.Strings) - 1));
 }
 
-std::vector<Token>& Scanner::ScanTokens() {
+TokenList& Scanner::ScanTokens() {
     while (!IsAtEnd()) {
         this->start_ = this->current_;
         ScanToken();
     }
 
-    tokens_.push_back(Token(TokenType::EOFL, "", Token::TokenData(), line_));
+    start_ = current_;
+    AddToken(TokenType::EOFL);
 
     return this->tokens_;
 }
@@ -190,25 +209,36 @@ void Scanner::number() {
         }
     }
 
-    AddToken(
-        TokenType::NUMBER,
-        Token::TokenData(std::atof(source_.substr(start_, current_).c_str())));
+    double value = 0;
+    auto result = std::from_chars(source_.data() + start_,
+                                  source_.data() + current_, value);
+    // Literals out of range have too many digits to be exact anyway: those
+    // with an integer part are infinity, the others 0.
+    if (result.ec == std::errc::result_out_of_range) {
+        value = source_[source_.find_first_not_of('0', start_)] == '.'
+                    ? 0.0
+                    : std::numeric_limits<double>::infinity();
+    }
+    tokens_.Numbers.push_back(value);
+    AddToken(TokenType::NUMBER,
+             static_cast<std::uint32_t>(std::size(tokens_.Numbers) - 1));
 }
 
 bool Scanner::IsAlpha(char c) { return (std::isalpha(c) != 0) || c == '_'; }
 
+bool Scanner::IsAlphaNumeric(char c) {
+    return IsAlpha(c) || (std::isdigit(c) != 0);
+}
+
 void Scanner::Identifier() {
-    while (std::isalpha(Peek()) != 0) {
+    while (IsAlphaNumeric(Peek())) {
         Advance();
     }
 
-    // std::string std::string::substring(start, length);
-    auto token_type = keywords.find(
-            source_.substr(start_, current_ - start_));
+    std::string_view text(source_.data() + start_, current_ - start_);
+    auto token_type = keywords.find(text);
     if (token_type == keywords.end()) {
-        AddToken(
-                TokenType::IDENTIFIER,
-                Token::TokenData(source_.substr(start_, current_-start_)));
+        AddToken(TokenType::IDENTIFIER, Symbols().Intern(text));
     } else {
         AddToken(token_type->second);
     }
@@ -1,7 +1,6 @@
 #pragma once
 
 #include <string>
-#include <variant>
 #include <vector>
 
 #include "tokens.h"
@@ -10,7 +9,7 @@ namespace lox {
 
 class Scanner {
     const std::string& source_;
-    std::vector<Token> tokens_;
+    TokenList tokens_;
 
     int start_ = 0;
     int current_ = 0;
@@ -18,10 +17,10 @@ class Scanner {
 
     bool IsAtEnd() const;
     static bool IsAlpha(char);
+    static bool IsAlphaNumeric(char);
     void ScanToken();
     char Advance();
-    void AddToken(TokenType type);
-    void AddToken(TokenType type, Token::TokenData data);
+    void AddToken(TokenType type, std::uint32_t value = 0);
     bool Match(char expected);
     char Peek() const;
     char PeekNext() const;
@@ -31,7 +30,7 @@ class Scanner {
 
    public:
     Scanner(const std::string& source);
-    std::vector<Token>& ScanTokens();
+    TokenList& ScanTokens();
 };
 
 }  // namespace lox
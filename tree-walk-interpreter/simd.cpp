@@ -0,0 +1,86 @@
+#include "simd.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#include "simdKernels.h"
+
+namespace lox::simd {
+
+namespace {
+
+#if defined(__x86_64__) || defined(_M_X64)
+// Every x86-64 CPU has SSE2.
+struct Sse2 {
+    using V = __m128d;
+    static constexpr std::size_t kWidth = 2;
+
+    static V Load(const double* p) { return _mm_loadu_pd(p); }
+    static void Store(double* p, V v) { _mm_storeu_pd(p, v); }
+    static V Splat(double d) { return _mm_set1_pd(d); }
+    static V Add(V a, V b) { return _mm_add_pd(a, b); }
+    static V Sub(V a, V b) { return _mm_sub_pd(a, b); }
+    static V Mul(V a, V b) { return _mm_mul_pd(a, b); }
+    static V Div(V a, V b) { return _mm_div_pd(a, b); }
+    static V Min(V a, V b) { return _mm_min_pd(a, b); }
+    static V Max(V a, V b) { return _mm_max_pd(a, b); }
+};
+
+const KernelTable kBaseKernels = Kernels<Sse2>::Table("sse2");
+#else
+struct Scalar {
+    using V = double;
+    static constexpr std::size_t kWidth = 1;
+
+    static V Load(const double* p) { return *p; }
+    static void Store(double* p, V v) { *p = v; }
+    static V Splat(double d) { return d; }
+    static V Add(V a, V b) { return a + b; }
+    static V Sub(V a, V b) { return a - b; }
+    static V Mul(V a, V b) { return a * b; }
+    static V Div(V a, V b) { return a / b; }
+    static V Min(V a, V b) { return a < b ? a : b; }
+    static V Max(V a, V b) { return a > b ? a : b; }
+};
+
+const KernelTable kBaseKernels = Kernels<Scalar>::Table("scalar");
+#endif
+
+const KernelTable& Select() {
+#if defined(LOX_AVX)
+    if (__builtin_cpu_supports("avx")) {
+        return kAvxKernels;
+    }
+#endif
+    return kBaseKernels;
+}
+
+// Chosen once, on first use.
+const KernelTable& Table() {
+    static const KernelTable& table = Select();
+    return table;
+}
+
+}  // namespace
+
+void Apply(Op op, const double* a, bool a_scalar, const double* b,
+           bool b_scalar, double* out, std::size_t n) {
+    if (n != 0) {
+        Table().Apply(op, a, a_scalar, b, b_scalar, out, n);
+    }
+}
+
+double Dot(const double* a, const double* b, std::size_t n) {
+    return Table().Dot(a, b, n);
+}
+
+double Sum(const double* a, std::size_t n) { return Table().Sum(a, n); }
+
+double Min(const double* a, std::size_t n) { return Table().Min(a, n); }
+
+double Max(const double* a, std::size_t n) { return Table().Max(a, n); }
+
+const char* InstructionSet() { return Table().Name; }
+
+}  // namespace lox::simd
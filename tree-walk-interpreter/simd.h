@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Kernels over arrays of doubles, which F64Array values use. They run on
+// the widest vector instructions the CPU has: AVX if the build has the AVX
+// kernels and the CPU supports them, SSE2 on other x86-64 CPUs, plain loops
+// elsewhere.
+namespace lox::simd {
+
+enum class Op : std::uint8_t { ADD, SUBTRACT, MULTIPLY, DIVIDE };
+
+// out[i] = a[i] op b[i] for i < n. A scalar operand is a single double used
+// for every element. out may be a or b.
+void Apply(Op op, const double* a, bool a_scalar, const double* b,
+           bool b_scalar, double* out, std::size_t n);
+double Dot(const double* a, const double* b, std::size_t n);
+double Sum(const double* a, std::size_t n);
+// n must be at least 1.
+double Min(const double* a, std::size_t n);
+double Max(const double* a, std::size_t n);
+
+// "avx", "sse2" or "scalar".
+const char* InstructionSet();
+
+}  // namespace lox::simd
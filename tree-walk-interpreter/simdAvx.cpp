@@ -0,0 +1,30 @@
+// The kernels of simd.h for AVX. Only this file is compiled with AVX
+// enabled, simd.cpp uses the kernels if the CPU supports them.
+#include <immintrin.h>
+
+#include "simdKernels.h"
+
+namespace lox::simd {
+
+namespace {
+
+struct Avx {
+    using V = __m256d;
+    static constexpr std::size_t kWidth = 4;
+
+    static V Load(const double* p) { return _mm256_loadu_pd(p); }
+    static void Store(double* p, V v) { _mm256_storeu_pd(p, v); }
+    static V Splat(double d) { return _mm256_set1_pd(d); }
+    static V Add(V a, V b) { return _mm256_add_pd(a, b); }
+    static V Sub(V a, V b) { return _mm256_sub_pd(a, b); }
+    static V Mul(V a, V b) { return _mm256_mul_pd(a, b); }
+    static V Div(V a, V b) { return _mm256_div_pd(a, b); }
+    static V Min(V a, V b) { return _mm256_min_pd(a, b); }
+    static V Max(V a, V b) { return _mm256_max_pd(a, b); }
+};
+
+}  // namespace
+
+const KernelTable kAvxKernels = Kernels<Avx>::Table("avx");
+
+}  // namespace lox::simd
@@ -0,0 +1,198 @@
+#pragma once
+
+// The kernels of simd.h for one instruction set, described by a traits
+// type: V, a vector of kWidth doubles, and the operations on it.
+//
+// simd.cpp and simdAvx.cpp include this and compile it with different
+// instruction sets. Everything but the tables has internal linkage, so the
+// linker can't pick a copy compiled for AVX for the other kernels. That is
+// also why they don't call std::min and the like.
+
+#include <cstddef>
+
+#include "simd.h"
+
+namespace lox::simd {
+
+struct KernelTable {
+    const char* Name;
+    void (*Apply)(Op op, const double* a, bool a_scalar, const double* b,
+                  bool b_scalar, double* out, std::size_t n);
+    double (*Dot)(const double* a, const double* b, std::size_t n);
+    double (*Sum)(const double* a, std::size_t n);
+    double (*Min)(const double* a, std::size_t n);
+    double (*Max)(const double* a, std::size_t n);
+};
+
+#if defined(LOX_AVX)
+extern const KernelTable kAvxKernels;
+#endif
+
+namespace {
+
+template <typename T>
+struct Kernels {
+    using V = typename T::V;
+    static constexpr std::size_t W = T::kWidth;
+
+    template <Op op>
+    static V Combine(V a, V b) {
+        if constexpr (op == Op::ADD) {
+            return T::Add(a, b);
+        } else if constexpr (op == Op::SUBTRACT) {
+            return T::Sub(a, b);
+        } else if constexpr (op == Op::MULTIPLY) {
+            return T::Mul(a, b);
+        } else {
+            return T::Div(a, b);
+        }
+    }
+
+    template <Op op>
+    static double Combine(double a, double b) {
+        if constexpr (op == Op::ADD) {
+            return a + b;
+        } else if constexpr (op == Op::SUBTRACT) {
+            return a - b;
+        } else if constexpr (op == Op::MULTIPLY) {
+            return a * b;
+        } else {
+            return a / b;
+        }
+    }
+
+    template <Op op, bool a_scalar, bool b_scalar>
+    static void Apply(const double* a, const double* b, double* out,
+                      std::size_t n) {
+        const V va = T::Splat(a_scalar ? *a : 0);
+        const V vb = T::Splat(b_scalar ? *b : 0);
+        std::size_t i = 0;
+        for (; i + W <= n; i += W) {
+            V x = a_scalar ? va : T::Load(a + i);
+            V y = b_scalar ? vb : T::Load(b + i);
+            T::Store(out + i, Combine<op>(x, y));
+        }
+        for (; i < n; ++i) {
+            out[i] = Combine<op>(a_scalar ? *a : a[i], b_scalar ? *b : b[i]);
+        }
+    }
+
+    template <Op op>
+    static void Apply(const double* a, bool a_scalar, const double* b,
+                      bool b_scalar, double* out, std::size_t n) {
+        if (a_scalar) {
+            Apply<op, true, false>(a, b, out, n);
+        } else if (b_scalar) {
+            Apply<op, false, true>(a, b, out, n);
+        } else {
+            Apply<op, false, false>(a, b, out, n);
+        }
+    }
+
+    static void Apply(Op op, const double* a, bool a_scalar, const double* b,
+                      bool b_scalar, double* out, std::size_t n) {
+        switch (op) {
+            case Op::ADD:
+                Apply<Op::ADD>(a, a_scalar, b, b_scalar, out, n);
+                break;
+            case Op::SUBTRACT:
+                Apply<Op::SUBTRACT>(a, a_scalar, b, b_scalar, out, n);
+                break;
+            case Op::MULTIPLY:
+                Apply<Op::MULTIPLY>(a, a_scalar, b, b_scalar, out, n);
+                break;
+            case Op::DIVIDE:
+                Apply<Op::DIVIDE>(a, a_scalar, b, b_scalar, out, n);
+                break;
+        }
+    }
+
+    // The lanes of v combined with f, in order.
+    template <typename F>
+    static double Reduce(V v, F f) {
+        double lanes[W];
+        T::Store(lanes, v);
+        double result = lanes[0];
+        for (std::size_t i = 1; i < W; ++i) {
+            result = f(result, lanes[i]);
+        }
+        return result;
+    }
+
+    // Two accumulators hide the latency of the additions.
+    static double Dot(const double* a, const double* b, std::size_t n) {
+        V acc0 = T::Splat(0);
+        V acc1 = T::Splat(0);
+        std::size_t i = 0;
+        for (; i + 2 * W <= n; i += 2 * W) {
+            acc0 = T::Add(acc0, T::Mul(T::Load(a + i), T::Load(b + i)));
+            acc1 = T::Add(acc1,
+                          T::Mul(T::Load(a + i + W), T::Load(b + i + W)));
+        }
+        for (; i + W <= n; i += W) {
+            acc0 = T::Add(acc0, T::Mul(T::Load(a + i), T::Load(b + i)));
+        }
+        double sum = Reduce(T::Add(acc0, acc1),
+                            [](double x, double y) { return x + y; });
+        for (; i < n; ++i) {
+            sum += a[i] * b[i];
+        }
+        return sum;
+    }
+
+    static double Sum(const double* a, std::size_t n) {
+        V acc0 = T::Splat(0);
+        V acc1 = T::Splat(0);
+        std::size_t i = 0;
+        for (; i + 2 * W <= n; i += 2 * W) {
+            acc0 = T::Add(acc0, T::Load(a + i));
+            acc1 = T::Add(acc1, T::Load(a + i + W));
+        }
+        for (; i + W <= n; i += W) {
+            acc0 = T::Add(acc0, T::Load(a + i));
+        }
+        double sum = Reduce(T::Add(acc0, acc1),
+                            [](double x, double y) { return x + y; });
+        for (; i < n; ++i) {
+            sum += a[i];
+        }
+        return sum;
+    }
+
+    template <bool max>
+    static double Extreme(const double* a, std::size_t n) {
+        // Like the vector instructions, y if either is NaN.
+        auto pick = [](double x, double y) {
+            return (max ? x > y : x < y) ? x : y;
+        };
+        double result = a[0];
+        std::size_t i = 0;
+        if (n >= W) {
+            V acc = T::Load(a);
+            for (i = W; i + W <= n; i += W) {
+                acc = max ? T::Max(acc, T::Load(a + i))
+                          : T::Min(acc, T::Load(a + i));
+            }
+            result = Reduce(acc, pick);
+        }
+        for (; i < n; ++i) {
+            result = pick(result, a[i]);
+        }
+        return result;
+    }
+
+    static double Min(const double* a, std::size_t n) {
+        return Extreme<false>(a, n);
+    }
+    static double Max(const double* a, std::size_t n) {
+        return Extreme<true>(a, n);
+    }
+
+    static constexpr KernelTable Table(const char* name) {
+        return {name, &Apply, &Dot, &Sum, &Min, &Max};
+    }
+};
+
+}  // namespace
+
+}  // namespace lox::simd
@@ -0,0 +1,714 @@
+#include "snapshot.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "interpreter.h"
+#include "loxClass.h"
+#include "loxCoroutine.h"
+#include "loxF64Array.h"
+#include "loxList.h"
+#include "loxMap.h"
+
+namespace lox {
+
+namespace {
+
+using TOut = Interpreter::TOut;
+
+// The format: the magic, a checksum of the rest, the names of the symbols
+// the image uses, the constant pool, and the globals. Values are a Tag and what it needs.
+// Objects are written as an id, followed by their contents the first time
+// the id appears, so objects shared in the heap are shared when restored,
+// and cycles end at the id of an object that is being written.
+constexpr char kMagic[8] = {'L', 'O', 'X', 'S', 'N', 'A', 'P', '1'};
+
+// FNV-1a, so that damaged images are refused before their bytecode runs.
+std::uint64_t Checksum(const char* data, std::size_t size,
+                       std::uint64_t hash = 14695981039346656037ull) {
+    for (std::size_t i = 0; i < size; ++i) {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * 1099511628211ull;
+    }
+    return hash;
+}
+
+enum class Tag : std::uint8_t {
+    FALSE,
+    TRUE,
+    NUMBER,
+    STRING,
+    FUNCTION,
+    CLASS,
+    INSTANCE,
+    BOUND_METHOD,
+    LIST,
+    MAP,
+    F64_ARRAY,
+    NATIVE,
+};
+
+#define LOX_OPCODE_COUNT(name) +1
+constexpr int kOpCodes = 0 LOX_OPCODES(LOX_OPCODE_COUNT);
+#undef LOX_OPCODE_COUNT
+
+// Whether operand B or C of an instruction is a symbol, which is numbered
+// differently in another process.
+bool SymbolB(OpCode op) {
+    return op == OpCode::GET_GLOBAL || op == OpCode::SET_GLOBAL ||
+           op == OpCode::DEFINE_GLOBAL || op == OpCode::CLASS;
+}
+bool SymbolC(OpCode op) {
+    return op == OpCode::METHOD || op == OpCode::GET_SUPER;
+}
+
+class Writer {
+    std::string out_;
+    std::unordered_map<const void*, std::uint32_t> objects_;
+    std::unordered_map<Symbol, std::uint32_t> symbols_;
+    // The symbols the image uses, by their number in it.
+    std::vector<Symbol> names_;
+
+   public:
+    const std::string& Out() const { return out_; }
+    const std::vector<Symbol>& Names() const { return names_; }
+
+    template <typename T>
+    void Raw(const T& value) {
+        out_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+    void U8(std::uint8_t value) { Raw(value); }
+    void U32(std::uint32_t value) { Raw(value); }
+    void Size(std::size_t size) { U32(static_cast<std::uint32_t>(size)); }
+    void Put(Tag tag) { U8(static_cast<std::uint8_t>(tag)); }
+    void Str(const std::string& s) {
+        Size(std::size(s));
+        out_ += s;
+    }
+    void Sym(Symbol symbol) {
+        auto [index, added] = symbols_.try_emplace(symbol, std::size(names_));
+        if (added) {
+            names_.push_back(symbol);
+        }
+        U32(index->second);
+    }
+    // Write the id of object, return true the first time, when its contents
+    // must follow.
+    bool Object(const void* object) {
+        auto [id, added] = objects_.try_emplace(object, std::size(objects_));
+        U32(id->second);
+        return added;
+    }
+
+    void Value(const TOut& value);
+    void Function(const LoxFunction& function);
+    void Proto(const FunctionProto& proto);
+    void Class(const LoxClass& klass);
+    void Instance(const LoxInstance& instance);
+};
+
+void Writer::Value(const TOut& value) {
+    std::visit(
+        overload{
+            [this](bool b) { Put(b ? Tag::TRUE : Tag::FALSE); },
+            [this](double d) {
+                Put(Tag::NUMBER);
+                Raw(d);
+            },
+            [this](const LoxString& s) {
+                Put(Tag::STRING);
+                Str(s.Str());
+            },
+            [this](const LoxFunction& f) {
+                Put(Tag::FUNCTION);
+                Function(f);
+            },
+            [this](const std::shared_ptr<LoxClass>& c) {
+                Put(Tag::CLASS);
+                Class(*c);
+            },
+            [this](const std::shared_ptr<LoxInstance>& i) {
+                Put(Tag::INSTANCE);
+                Instance(*i);
+            },
+            [this](const std::shared_ptr<const LoxBoundMethod>& m) {
+                // A bound method can't be created before its parts, they
+                // come first.
+                Put(Tag::BOUND_METHOD);
+                Instance(*m->Receiver);
+                Function(m->Method);
+                Object(m.get());
+            },
+            [this](const std::shared_ptr<LoxList>& l) {
+                Put(Tag::LIST);
+                if (Object(l.get())) {
+                    Size(std::size(l->Elements));
+                    for (const auto& element : l->Elements) {
+                        Value(element);
+                    }
+                }
+            },
+            [this](const std::shared_ptr<LoxMap>& m) {
+                Put(Tag::MAP);
+                if (Object(m.get())) {
+                    Size(m->size());
+                    m->ForEach([this](const TOut& key, const TOut& v) {
+                        Value(key);
+                        Value(v);
+                    });
+                }
+            },
+            [this](const std::shared_ptr<LoxF64Array>& a) {
+                Put(Tag::F64_ARRAY);
+                if (Object(a.get())) {
+                    Size(std::size(a->Elements));
+                    out_.append(
+                        reinterpret_cast<const char*>(a->Elements.data()),
+                        std::size(a->Elements) * sizeof(double));
+                }
+            },
+            [this](const LoxNative* n) {
+                Put(Tag::NATIVE);
+                Str(n->Name);
+            },
+            [](const std::shared_ptr<LoxCoroutine>&) {
+                // Its frames would need the stack of a running interpreter.
+                throw std::runtime_error(
+                    "Coroutines can't be saved in a snapshot.");
+            }},
+        value);
+}
+
+void Writer::Function(const LoxFunction& function) {
+    if (Object(&function.Proto())) {
+        Proto(function.Proto());
+    }
+    auto count = std::size(function.Proto().Code->Captures);
+    bool upvalues = function.Upvalues() != nullptr && count > 0;
+    U8(upvalues);
+    if (upvalues && Object(function.Upvalues())) {
+        for (std::size_t i = 0; i < count; ++i) {
+            const auto& cell = function.Upvalues()[i];
+            if (Object(cell.get())) {
+                Value(*cell);
+            }
+        }
+    }
+}
+
+void Writer::Proto(const FunctionProto& proto) {
+    Sym(proto.Name.Value);
+    U32(proto.Name.Line);
+    U32(proto.Arity);
+    U8(proto.Method);
+
+    const Chunk& chunk = *proto.Code;
+    Size(std::size(chunk.Code));
+    for (const auto& instr : chunk.Code) {
+        U8(static_cast<std::uint8_t>(instr.Op));
+        Raw(instr.A);
+        SymbolB(instr.Op) ? Sym(instr.B) : U32(instr.B);
+        SymbolC(instr.Op) ? Sym(instr.C) : U32(instr.C);
+    }
+    for (auto line : chunk.Lines) {
+        U32(line);
+    }
+    Size(std::size(chunk.Functions));
+    for (const auto& function : chunk.Functions) {
+        if (Object(function.get())) {
+            Proto(*function);
+        }
+    }
+    U32(chunk.MaxRegisters);
+    U32(chunk.NumCells);
+    Size(std::size(chunk.Captures));
+    for (const auto& capture : chunk.Captures) {
+        U8(capture.FromCell);
+        U32(capture.Index);
+    }
+    Size(std::size(chunk.Caches));
+    for (const auto& cache : chunk.Caches) {
+        Sym(cache.Name);
+    }
+}
+
+void Writer::Class(const LoxClass& klass) {
+    if (!Object(&klass)) {
+        return;
+    }
+    Sym(klass.Name);
+    U8(klass.Superclass != nullptr);
+    if (klass.Superclass != nullptr) {
+        Class(*klass.Superclass);
+    }
+    Size(std::size(klass.Methods));
+    for (const auto& [name, method] : klass.Methods) {
+        Sym(name);
+        Function(method);
+    }
+}
+
+void Writer::Instance(const LoxInstance& instance) {
+    // The class first, an instance is created with it.
+    Class(*instance.Class);
+    if (!Object(&instance)) {
+        return;
+    }
+    auto fields = instance.Layout->Fields();
+    Size(std::size(fields));
+    for (auto name : fields) {
+        Sym(name);
+    }
+    for (const auto& field : instance.Fields) {
+        Value(field);
+    }
+}
+
+[[noreturn]] void Corrupt() {
+    throw std::runtime_error("Corrupt snapshot.");
+}
+
+class Reader {
+    enum class Kind : std::uint8_t {
+        PROTO,
+        UPVALUES,
+        CELL,
+        CLASS,
+        INSTANCE,
+        BOUND_METHOD,
+        LIST,
+        MAP,
+        F64_ARRAY
+    };
+
+    const char* next_;
+    const char* end_;
+    // The symbols of the image in this process.
+    std::vector<Symbol> symbols_;
+    std::vector<std::shared_ptr<const void>> objects_;
+    std::vector<Kind> kinds_;
+    std::shared_ptr<ConstantPool> constants_;
+
+    // Read the id of an object. Return true if it's new, and its contents
+    // follow, which it must be added with before they are read.
+    bool New(std::uint32_t& id) {
+        id = U32();
+        if (id > std::size(objects_)) {
+            Corrupt();
+        }
+        return id == std::size(objects_);
+    }
+    void Add(std::shared_ptr<const void> object, Kind kind) {
+        objects_.push_back(std::move(object));
+        kinds_.push_back(kind);
+    }
+    template <typename T>
+    std::shared_ptr<T> Get(std::uint32_t id, Kind kind) {
+        if (kinds_[id] != kind) {
+            Corrupt();
+        }
+        return std::const_pointer_cast<T>(
+            std::static_pointer_cast<const T>(objects_[id]));
+    }
+
+   public:
+    Reader(const char* data, std::size_t size,
+           std::shared_ptr<ConstantPool> constants)
+        : next_(data), end_(data + size), constants_(std::move(constants)) {}
+
+    bool AtEnd() const { return next_ == end_; }
+
+    template <typename T>
+    T Raw() {
+        if (static_cast<std::size_t>(end_ - next_) < sizeof(T)) {
+            Corrupt();
+        }
+        T value;
+        std::memcpy(&value, next_, sizeof(T));
+        next_ += sizeof(T);
+        return value;
+    }
+    std::uint8_t U8() { return Raw<std::uint8_t>(); }
+    std::uint32_t U32() { return Raw<std::uint32_t>(); }
+    // A count of things that take at least a byte each.
+    std::size_t Size() {
+        std::size_t size = U32();
+        if (size > static_cast<std::size_t>(end_ - next_)) {
+            Corrupt();
+        }
+        return size;
+    }
+    Tag Get() {
+        auto tag = U8();
+        if (tag > static_cast<std::uint8_t>(Tag::NATIVE)) {
+            Corrupt();
+        }
+        return static_cast<Tag>(tag);
+    }
+    std::string Str() {
+        auto size = Size();
+        std::string s(next_, size);
+        next_ += size;
+        return s;
+    }
+    Symbol Sym() {
+        auto index = U32();
+        if (index >= std::size(symbols_)) {
+            Corrupt();
+        }
+        return symbols_[index];
+    }
+
+    void Header();
+    void Symbols();
+    void Constants();
+    TOut Value();
+    LoxFunction Function();
+    std::shared_ptr<FunctionProto> Proto();
+    std::shared_ptr<LoxClass> Class();
+    std::shared_ptr<LoxInstance> Instance();
+};
+
+void Reader::Header() {
+    for (char c : kMagic) {
+        if (Raw<char>() != c) {
+            Corrupt();
+        }
+    }
+    auto checksum = Raw<std::uint64_t>();
+    if (Checksum(next_, end_ - next_) != checksum) {
+        Corrupt();
+    }
+}
+
+void Reader::Symbols() {
+    auto count = Size();
+    for (std::size_t i = 0; i < count; ++i) {
+        symbols_.push_back(lox::Symbols().Intern(Str()));
+    }
+}
+
+void Reader::Constants() {
+    auto count = Size();
+    for (std::size_t i = 0; i < count; ++i) {
+        Literal::ValueType literal;
+        switch (Get()) {
+            case Tag::FALSE:
+                literal = false;
+                break;
+            case Tag::TRUE:
+                literal = true;
+                break;
+            case Tag::NUMBER:
+                literal = Raw<double>();
+                break;
+            case Tag::STRING:
+                literal = Str();
+                break;
+            default:
+                Corrupt();
+        }
+        // The pool was written in the order it was built, so adding it
+        // again gives every constant its old index.
+        if (constants_->Add(literal) != i) {
+            Corrupt();
+        }
+    }
+}
+
+TOut Reader::Value() {
+    std::uint32_t id;
+    switch (Get()) {
+        case Tag::FALSE:
+            return false;
+        case Tag::TRUE:
+            return true;
+        case Tag::NUMBER:
+            return Raw<double>();
+        case Tag::STRING:
+            return LoxString(Str());
+        case Tag::FUNCTION:
+            return Function();
+        case Tag::CLASS:
+            return Class();
+        case Tag::INSTANCE:
+            return Instance();
+        case Tag::BOUND_METHOD: {
+            auto receiver = Instance();
+            auto method = Function();
+            if (!New(id)) {
+                return Get<const LoxBoundMethod>(id, Kind::BOUND_METHOD);
+            }
+            auto bound = std::make_shared<const LoxBoundMethod>(
+                LoxBoundMethod{std::move(receiver), std::move(method)});
+            Add(bound, Kind::BOUND_METHOD);
+            return bound;
+        }
+        case Tag::LIST: {
+            if (!New(id)) {
+                return Get<LoxList>(id, Kind::LIST);
+            }
+            auto list = std::make_shared<LoxList>();
+            Add(list, Kind::LIST);
+            auto size = Size();
+            list->Elements.reserve(size);
+            for (std::size_t i = 0; i < size; ++i) {
+                list->Elements.push_back(Value());
+            }
+            return list;
+        }
+        case Tag::MAP: {
+            if (!New(id)) {
+                return Get<LoxMap>(id, Kind::MAP);
+            }
+            auto map = std::make_shared<LoxMap>();
+            Add(map, Kind::MAP);
+            auto size = Size();
+            for (std::size_t i = 0; i < size; ++i) {
+                auto key = Value();
+                if (!LoxMap::Hashable(key)) {
+                    Corrupt();
+                }
+                map->Insert(key, Value());
+            }
+            return map;
+        }
+        case Tag::F64_ARRAY: {
+            if (!New(id)) {
+                return Get<LoxF64Array>(id, Kind::F64_ARRAY);
+            }
+            auto array = std::make_shared<LoxF64Array>();
+            Add(array, Kind::F64_ARRAY);
+            auto size = U32();
+            if (size > static_cast<std::size_t>(end_ - next_) / sizeof(double)) {
+                Corrupt();
+            }
+            array->Elements.resize(size);
+            std::memcpy(array->Elements.data(), next_, size * sizeof(double));
+            next_ += size * sizeof(double);
+            return array;
+        }
+        case Tag::NATIVE: {
+            auto* native = FindNative(Str());
+            if (native == nullptr) {
+                Corrupt();
+            }
+            return native;
+        }
+    }
+    Corrupt();
+}
+
+LoxFunction Reader::Function() {
+    std::uint32_t id;
+    auto proto = New(id) ? Proto() : Get<FunctionProto>(id, Kind::PROTO);
+    if (U8() == 0) {
+        return LoxFunction(std::move(proto), nullptr);
+    }
+    if (!New(id)) {
+        return LoxFunction(std::move(proto),
+                           Get<std::vector<LoxFunction::Cell>>(
+                               id, Kind::UPVALUES));
+    }
+    auto count = std::size(proto->Code->Captures);
+    auto upvalues = std::make_shared<std::vector<LoxFunction::Cell>>(count);
+    Add(upvalues, Kind::UPVALUES);
+    for (auto& cell : *upvalues) {
+        if (!New(id)) {
+            cell = Get<TOut>(id, Kind::CELL);
+            continue;
+        }
+        cell = std::make_shared<TOut>(false);
+        Add(cell, Kind::CELL);
+        *cell = Value();
+    }
+    return LoxFunction(std::move(proto), std::move(upvalues));
+}
+
+std::shared_ptr<FunctionProto> Reader::Proto() {
+    auto proto = std::make_shared<FunctionProto>();
+    Add(proto, Kind::PROTO);
+    proto->Name = Token{0, 0, TokenType::IDENTIFIER, 0, Sym()};
+    proto->Name.Line = U32();
+    proto->Arity = U32();
+    proto->Method = U8() != 0;
+
+    auto chunk = std::make_shared<Chunk>();
+    chunk->Constants = constants_;
+    auto size = Size();
+    chunk->Code.resize(size);
+    for (auto& instr : chunk->Code) {
+        auto op = U8();
+        if (op >= kOpCodes) {
+            Corrupt();
+        }
+        instr.Op = static_cast<OpCode>(op);
+        instr.A = Raw<std::uint16_t>();
+        instr.B = SymbolB(instr.Op) ? Sym() : U32();
+        instr.C = SymbolC(instr.Op) ? Sym() : U32();
+    }
+    chunk->Lines.resize(size);
+    for (auto& line : chunk->Lines) {
+        line = U32();
+    }
+    auto functions = Size();
+    for (std::size_t i = 0; i < functions; ++i) {
+        std::uint32_t id;
+        chunk->Functions.push_back(New(id) ? Proto()
+                                           : Get<FunctionProto>(id, Kind::PROTO));
+    }
+    chunk->MaxRegisters = U32();
+    chunk->NumCells = U32();
+    chunk->Captures.resize(Size());
+    for (auto& capture : chunk->Captures) {
+        capture.FromCell = U8() != 0;
+        capture.Index = U32();
+    }
+    chunk->Caches.resize(Size());
+    for (auto& cache : chunk->Caches) {
+        cache.Name = Sym();
+    }
+    proto->Code = std::move(chunk);
+    return proto;
+}
+
+std::shared_ptr<LoxClass> Reader::Class() {
+    std::uint32_t id;
+    if (!New(id)) {
+        return Get<LoxClass>(id, Kind::CLASS);
+    }
+    auto klass = std::make_shared<LoxClass>(0);
+    Add(klass, Kind::CLASS);
+    klass->Name = Sym();
+    if (U8() != 0) {
+        klass->Superclass = Class();
+    }
+    auto methods = Size();
+    for (std::size_t i = 0; i < methods; ++i) {
+        auto name = Sym();
+        klass->Methods.insert_or_assign(name, Function());
+    }
+    return klass;
+}
+
+std::shared_ptr<LoxInstance> Reader::Instance() {
+    auto klass = Class();
+    std::uint32_t id;
+    if (!New(id)) {
+        return Get<LoxInstance>(id, Kind::INSTANCE);
+    }
+    auto instance = std::make_shared<LoxInstance>(std::move(klass));
+    Add(instance, Kind::INSTANCE);
+    // Adding the fields in the order of their slots gives the instance the
+    // same shape it had, shared with the instances that have the same ones.
+    auto count = Size();
+    for (std::size_t i = 0; i < count; ++i) {
+        instance->Layout = instance->Layout->Add(Sym());
+    }
+    if (instance->Layout->Size() != count) {
+        Corrupt();
+    }
+    instance->Fields.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        instance->Fields.push_back(Value());
+    }
+    return instance;
+}
+
+}  // namespace
+
+void Snapshot::Write(const Interpreter& interpreter, std::ostream& os) {
+    Writer globals;
+    globals.Size(std::size(interpreter.Globals->values));
+    for (const auto& [name, value] : interpreter.Globals->values) {
+        globals.Sym(name);
+        globals.Value(value);
+    }
+
+    Writer head;
+    head.Size(std::size(globals.Names()));
+    for (auto symbol : globals.Names()) {
+        head.Str(Symbols().Name(symbol));
+    }
+    const auto& constants = *interpreter.constants_;
+    head.Size(constants.size());
+    for (std::uint32_t i = 0; i < constants.size(); ++i) {
+        head.Value(constants[i]);
+    }
+
+    auto checksum = Checksum(head.Out().data(), std::size(head.Out()));
+    checksum = Checksum(globals.Out().data(), std::size(globals.Out()),
+                        checksum);
+    os.write(kMagic, sizeof(kMagic));
+    os.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+    os << head.Out() << globals.Out();
+}
+
+Snapshot Snapshot::Open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Can't open snapshot " + path + ".");
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Can't open snapshot " + path + ".");
+    }
+    auto size = static_cast<std::size_t>(info.st_size);
+    if (size == 0) {
+        ::close(fd);
+        return Snapshot(nullptr, 0);
+    }
+    void* memory = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        throw std::runtime_error("Can't map snapshot " + path + ".");
+    }
+    std::shared_ptr<const char> data(
+        static_cast<const char*>(memory), [size](const char* memory) {
+            ::munmap(const_cast<char*>(memory), size);
+        });
+    return Snapshot(std::move(data), size);
+}
+
+Snapshot::Snapshot(std::string image) {
+    auto owner = std::make_shared<const std::string>(std::move(image));
+    size_ = std::size(*owner);
+    data_ = std::shared_ptr<const char>(owner, owner->data());
+}
+
+void Snapshot::Restore(Interpreter& interpreter) const {
+    if (interpreter.constants_->size() != 0) {
+        throw std::runtime_error(
+            "Snapshots can only be restored into new interpreters.");
+    }
+    // Nothing changes in interpreter unless the whole image is read.
+    auto constants = std::make_shared<ConstantPool>();
+    Reader reader(data_.get(), size_, constants);
+    reader.Header();
+    reader.Symbols();
+    reader.Constants();
+    auto count = reader.Size();
+    std::vector<std::pair<Symbol, TOut>> globals;
+    for (std::size_t i = 0; i < count; ++i) {
+        auto name = reader.Sym();
+        globals.emplace_back(name, reader.Value());
+    }
+    if (!reader.AtEnd()) {
+        Corrupt();
+    }
+
+    interpreter.constants_ = std::move(constants);
+    for (auto& [name, value] : globals) {
+        interpreter.Globals->Define(name, std::move(value));
+    }
+}
+
+}  // namespace lox
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace lox {
+
+class Interpreter;
+
+// The globals of an interpreter and everything they refer to, saved so
+// that new interpreters start out with them instead of running the code
+// that made them, such as a prelude of function definitions and tables.
+//
+// The image holds the functions with their bytecode, the strings, lists,
+// maps, arrays, classes and instances, and keeps which of them are shared.
+// Symbols are saved by name, so an image can be restored in another
+// process of the same build. Machine code and inline caches aren't saved,
+// restored functions warm up again. Images carry a checksum against
+// damage, but their bytecode isn't verified, only restore ones written by
+// a trusted program.
+//
+// Restoring only reads the image, so one Snapshot can be restored into
+// interpreters on different threads at once.
+class Snapshot {
+    std::shared_ptr<const char> data_;
+    std::size_t size_ = 0;
+
+    Snapshot(std::shared_ptr<const char> data, std::size_t size)
+        : data_(std::move(data)), size_(size) {}
+
+   public:
+    // Write the image of the globals of interpreter to os. Throws
+    // std::runtime_error if they refer to a coroutine, which can't be saved.
+    static void Write(const Interpreter& interpreter, std::ostream& os);
+    // Map the image in the file at path into memory. Throws
+    // std::runtime_error if it can't be read.
+    static Snapshot Open(const std::string& path);
+    explicit Snapshot(std::string image);
+
+    // Define the saved globals in interpreter, which must not have run
+    // anything yet. Throws std::runtime_error if the image is corrupt.
+    void Restore(Interpreter& interpreter) const;
+};
+
+}  // namespace lox
@@ -0,0 +1,33 @@
+#include "symbolTable.h"
+
+#include <mutex>
+
+namespace lox {
+
+Symbol SymbolTable::Intern(std::string_view name) {
+    {
+        std::shared_lock lock(lock_);
+        auto id = ids_.find(name);
+        if (id != ids_.end()) {
+            return id->second;
+        }
+    }
+
+    std::unique_lock lock(lock_);
+    // Another thread may have added it in between.
+    auto id = ids_.find(name);
+    if (id != ids_.end()) {
+        return id->second;
+    }
+    auto symbol = static_cast<Symbol>(std::size(names_));
+    const std::string& stored = names_.emplace_back(name);
+    ids_.emplace(stored, symbol);
+    return symbol;
+}
+
+SymbolTable& Symbols() {
+    static SymbolTable symbols;
+    return symbols;
+}
+
+}  // namespace lox
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace lox {
+
+// Dense id of an interned identifier, two identifiers have the same symbol
+// iff they have the same name.
+using Symbol = std::uint32_t;
+
+// Scripts scanned on different threads intern into the same table, so it
+// takes a lock, one that lookups of names already in it share.
+class SymbolTable {
+    mutable std::shared_mutex lock_;
+    std::deque<std::string> names_;  // deque, so the keys below stay valid.
+    std::unordered_map<std::string_view, Symbol> ids_;
+
+   public:
+    Symbol Intern(std::string_view name);
+    // Stays valid when other names are interned.
+    const std::string& Name(Symbol symbol) const {
+        std::shared_lock lock(lock_);
+        return names_[symbol];
+    }
+    std::size_t Size() const {
+        std::shared_lock lock(lock_);
+        return std::size(names_);
+    }
+};
+
+// The process wide table the scanner interns identifiers in.
+SymbolTable& Symbols();
+
+}  // namespace lox
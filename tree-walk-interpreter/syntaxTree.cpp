@@ -1,4 +1,5 @@
 #include "syntaxTree.h"
+#include "symbolTable.h"
 #include <sstream>
 #include <string>
 #include <iostream>
@@ -33,17 +34,49 @@ ExpressionStatement::ExpressionStatement(std::unique_ptr<Expression>&& e)
     : Expr(std::move(e))
 {
 }
+
+Token ThisToken(std::uint32_t line)
+{
+    return Token{0, 0, TokenType::THIS, line, Symbols().Intern("this")};
+}
+
+Token SuperToken(std::uint32_t line)
+{
+    return Token{0, 0, TokenType::SUPER, line, Symbols().Intern("super")};
+}
+
+Super::Super(Token keyword, Token method)
+    : Superclass(std::make_unique<Variable>(SuperToken(keyword.Line)))
+    , This(std::make_unique<Variable>(ThisToken(keyword.Line)))
+    , Method(method)
+{
+}
     
 
-class AstSerializer final : public ExpressionVisitor{
+class AstSerializer final : public ExpressionVisitor, public StatementVisitor {
 private:
     std::stringstream ss_;
+    int indent_ = 0;
+
+    void NewLine()
+    {
+        ss_ << "\n" << std::string(2 * indent_, ' ');
+    }
+
+    void Nested(Statement& s)
+    {
+        ++indent_;
+        NewLine();
+        StatementVisitor::Visit(s);
+        --indent_;
+    }
 
 public:
     virtual void Visit(Literal& lit) override
     {
         auto text = std::visit(
             overload {
+                [](const bool b) { return std::string(b ? "true" : "false"); },
                 [](const double b) { return std::to_string(b); },
                 [](const std::string& s) { return s; },
                 [](const std::monostate _){return std::string("nill");}},
@@ -82,14 +115,14 @@ public:
     virtual void Visit(Variable& var) override
     {
         ss_ << "(";
-        ss_ << std::get<1>(var.Name.Data); // take the string...
+        ss_ << Symbols().Name(var.Name.Value);
         ss_ << ")";
     }
 
     virtual void Visit(Assignment& var) override
     {
         ss_ << "(= ";
-        ss_ << var.Name.Lexeme;
+        ss_ << Symbols().Name(var.Name.Value);
         ss_ << " ";
         ExpressionVisitor::Visit(*var.Expr);
         ss_ << ")";
@@ -98,7 +131,7 @@ public:
     virtual void Visit(Logical& lg) override
     {
         ss_ << "(";
-        ss_ << lg.Op.Lexeme;
+        ss_ << ToString(lg.Op.Type);
         ss_ << " ";
         ExpressionVisitor::Visit(*lg.Left);
         ss_ << " ";
@@ -117,11 +150,178 @@ public:
         ss_ << ")";
     }
 
+    virtual void Visit(Get& g) override
+    {
+        ss_ << "(. ";
+        ExpressionVisitor::Visit(*g.Object);
+        ss_ << " " << Symbols().Name(g.Name.Value) << ")";
+    }
+
+    virtual void Visit(Set& st) override
+    {
+        ss_ << "(.= ";
+        ExpressionVisitor::Visit(*st.Object);
+        ss_ << " " << Symbols().Name(st.Name.Value) << " ";
+        ExpressionVisitor::Visit(*st.Value);
+        ss_ << ")";
+    }
+
+    virtual void Visit(Super& sp) override
+    {
+        ss_ << "(super " << Symbols().Name(sp.Method.Value) << ")";
+    }
+
+    virtual void Visit(ListLiteral& l) override
+    {
+        ss_ << "(list";
+        for (auto& e : l.Elements) {
+            ss_ << " ";
+            ExpressionVisitor::Visit(*e);
+        }
+        ss_ << ")";
+    }
+
+    virtual void Visit(MapLiteral& m) override
+    {
+        ss_ << "(map";
+        for (std::size_t i = 0; i < std::size(m.Keys); ++i) {
+            ss_ << " ";
+            ExpressionVisitor::Visit(*m.Keys[i]);
+            ss_ << " ";
+            ExpressionVisitor::Visit(*m.Values[i]);
+        }
+        ss_ << ")";
+    }
+
+    virtual void Visit(Subscript& s) override
+    {
+        ss_ << "([] ";
+        ExpressionVisitor::Visit(*s.Object);
+        ss_ << " ";
+        ExpressionVisitor::Visit(*s.Key);
+        ss_ << ")";
+    }
+
+    virtual void Visit(SetSubscript& s) override
+    {
+        ss_ << "([]= ";
+        ExpressionVisitor::Visit(*s.Object);
+        ss_ << " ";
+        ExpressionVisitor::Visit(*s.Key);
+        ss_ << " ";
+        ExpressionVisitor::Visit(*s.Value);
+        ss_ << ")";
+    }
+
+    virtual void Visit(PrintStatement& p) override
+    {
+        ss_ << "(print ";
+        ExpressionVisitor::Visit(*p.Expr);
+        ss_ << ")";
+    }
+
+    virtual void Visit(ExpressionStatement& e) override
+    {
+        ExpressionVisitor::Visit(*e.Expr);
+    }
+
+    virtual void Visit(VariableDeclaration& vdecl) override
+    {
+        ss_ << "(var " << Symbols().Name(vdecl.Name.Value);
+        if (vdecl.Initializer != nullptr) {
+            ss_ << " ";
+            ExpressionVisitor::Visit(*vdecl.Initializer);
+        }
+        ss_ << ")";
+    }
+
+    virtual void Visit(Block& blk) override
+    {
+        ss_ << "(block";
+        for (auto& s : blk.Statements) {
+            Nested(*s);
+        }
+        ss_ << ")";
+    }
+
+    virtual void Visit(IfStatement& i) override
+    {
+        ss_ << "(if ";
+        ExpressionVisitor::Visit(*i.Condition);
+        Nested(*i.ThenBranch);
+        if (i.ElseBranch != nullptr) {
+            Nested(*i.ElseBranch);
+        }
+        ss_ << ")";
+    }
+
+    virtual void Visit(While& w) override
+    {
+        ss_ << "(while ";
+        ExpressionVisitor::Visit(*w.Condition);
+        Nested(*w.Body);
+        ss_ << ")";
+    }
+
+    virtual void Visit(FunctionDeclaration& f) override
+    {
+        ss_ << "(fun " << Symbols().Name(f.Name.Value) << " (";
+        for (std::size_t i = 0; i < std::size(f.Params); ++i) {
+            ss_ << (i == 0 ? "" : " ") << Symbols().Name(f.Params[i].Value);
+        }
+        ss_ << ")";
+        for (auto& s : f.Body) {
+            Nested(*s);
+        }
+        ss_ << ")";
+    }
+
+    virtual void Visit(ReturnStatement& r) override
+    {
+        ss_ << "(return";
+        if (r.Value != nullptr) {
+            ss_ << " ";
+            ExpressionVisitor::Visit(*r.Value);
+        }
+        ss_ << ")";
+    }
+
+    virtual void Visit(YieldStatement& y) override
+    {
+        ss_ << "(yield";
+        if (y.Value != nullptr) {
+            ss_ << " ";
+            ExpressionVisitor::Visit(*y.Value);
+        }
+        ss_ << ")";
+    }
+
+    virtual void Visit(ClassDeclaration& c) override
+    {
+        ss_ << "(class " << Symbols().Name(c.Name.Value);
+        if (c.Superclass != nullptr) {
+            ss_ << " < " << Symbols().Name(c.Superclass->Name.Value);
+        }
+        for (auto& m : c.Methods) {
+            Nested(*m);
+        }
+        ss_ << ")";
+    }
+
     std::string Serialize(Expression& expr)
     {
         ExpressionVisitor::Visit(expr);
         return ss_.str();
     }
+
+    std::string Serialize(std::vector<std::unique_ptr<Statement>>& statements)
+    {
+        for (auto& s : statements) {
+            StatementVisitor::Visit(*s);
+            ss_ << "\n";
+        }
+        return ss_.str();
+    }
 };
 
 void print(Expression& expr)
@@ -131,6 +331,61 @@ void print(Expression& expr)
     std::cout << text << std::endl;
 }
 
+void print(std::vector<std::unique_ptr<Statement>>& statements,
+           std::ostream& os)
+{
+    AstSerializer printer;
+    os << printer.Serialize(statements);
+}
+
+namespace {
+
+class FunctionFinder final : public StatementVisitor {
+public:
+    bool Found = false;
+
+    virtual void Visit(PrintStatement&) override {}
+    virtual void Visit(ExpressionStatement&) override {}
+    virtual void Visit(VariableDeclaration&) override {}
+    virtual void Visit(Block& blk) override
+    {
+        for (auto& s : blk.Statements) {
+            StatementVisitor::Visit(*s);
+        }
+    }
+    virtual void Visit(IfStatement& i) override
+    {
+        StatementVisitor::Visit(*i.ThenBranch);
+        if (i.ElseBranch != nullptr) {
+            StatementVisitor::Visit(*i.ElseBranch);
+        }
+    }
+    virtual void Visit(While& w) override { StatementVisitor::Visit(*w.Body); }
+    virtual void Visit(FunctionDeclaration&) override { Found = true; }
+    virtual void Visit(ReturnStatement&) override {}
+    virtual void Visit(YieldStatement&) override {}
+    virtual void Visit(ClassDeclaration&) override { Found = true; }
+};
+
+}  // namespace
+
+bool DeclaresFunction(Statement& statement)
+{
+    FunctionFinder finder;
+    statement.Accept(finder);
+    return finder.Found;
+}
+
+bool DeclaresFunction(std::vector<std::shared_ptr<Statement>>& statements)
+{
+    for (auto& s : statements) {
+        if (DeclaresFunction(*s)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 PrintStatement::PrintStatement(std::unique_ptr<Expression>&& expr)
     : Expr(std::move(expr))
 {}
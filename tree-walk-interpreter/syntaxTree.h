@@ -1,4 +1,6 @@
 #pragma once
+#include <cstdint>
+#include <iostream>
 #include <memory>
 #include <sstream>
 #include <string>
@@ -20,6 +22,13 @@ class Variable;
 class Assignment;
 class Logical;
 class Call;
+class Get;
+class Set;
+class Super;
+class ListLiteral;
+class MapLiteral;
+class Subscript;
+class SetSubscript;
 
 class Statement;
 class StatementVisitor;
@@ -33,9 +42,16 @@ class VariableDeclaration;
 class While;
 class FunctionDeclaration;
 class ReturnStatement;
+class YieldStatement;
+class ClassDeclaration;
+
+// What type inference proved about every value of an expression.
+enum class StaticType : std::uint8_t { UNKNOWN, NUMBER, BOOL };
 
 class Expression {
    public:
+    StaticType Type = StaticType::UNKNOWN;
+
     virtual void Accept(ExpressionVisitor& vis) = 0;
     virtual ~Expression() = default;
 };
@@ -58,6 +74,13 @@ class ExpressionVisitor {
     virtual void Visit(Assignment&) = 0;
     virtual void Visit(Logical&) = 0;
     virtual void Visit(Call&) = 0;
+    virtual void Visit(Get&) = 0;
+    virtual void Visit(Set&) = 0;
+    virtual void Visit(Super&) = 0;
+    virtual void Visit(ListLiteral&) = 0;
+    virtual void Visit(MapLiteral&) = 0;
+    virtual void Visit(Subscript&) = 0;
+    virtual void Visit(SetSubscript&) = 0;
 };
 
 class StatementVisitor {
@@ -72,6 +95,8 @@ class StatementVisitor {
     virtual void Visit(While&) = 0;
     virtual void Visit(FunctionDeclaration&) = 0;
     virtual void Visit(ReturnStatement&) = 0;
+    virtual void Visit(YieldStatement&) = 0;
+    virtual void Visit(ClassDeclaration&) = 0;
 };
 
 class BinaryExpr final : public Expression {
@@ -139,6 +164,8 @@ class VariableDeclaration final : public Statement {
    public:
     std::unique_ptr<Expression> Initializer;
     Token Name;
+    // Set by the resolver when a nested function uses the variable.
+    bool Captured = false;
     VariableDeclaration(Token name, std::unique_ptr<Expression>&& initializer);
 
     virtual void Accept(StatementVisitor& vis) override { vis.Visit(*this); }
@@ -217,11 +244,114 @@ class Call final : public Expression {
     virtual void Accept(ExpressionVisitor& vis) override { vis.Visit(*this); }
 };
 
+// Property access, object.name.
+class Get final : public Expression {
+   public:
+    std::unique_ptr<Expression> Object;
+    Token Name;
+    Get(std::unique_ptr<Expression> object, Token name)
+        : Object(std::move(object)), Name(name) {}
+
+    virtual void Accept(ExpressionVisitor& vis) override { vis.Visit(*this); }
+};
+
+// Property assignment, object.name = value.
+class Set final : public Expression {
+   public:
+    std::unique_ptr<Expression> Object;
+    Token Name;
+    std::unique_ptr<Expression> Value;
+    Set(std::unique_ptr<Expression> object, Token name,
+        std::unique_ptr<Expression> value)
+        : Object(std::move(object)), Name(name), Value(std::move(value)) {}
+
+    virtual void Accept(ExpressionVisitor& vis) override { vis.Visit(*this); }
+};
+
+// super.method, the method of the superclass bound to this. Both are
+// variables of the method, which the resolver resolves as usual.
+class Super final : public Expression {
+   public:
+    std::unique_ptr<Variable> Superclass;
+    std::unique_ptr<Variable> This;
+    Token Method;
+    Super(Token keyword, Token method);
+
+    virtual void Accept(ExpressionVisitor& vis) override { vis.Visit(*this); }
+};
+
+// [element, ...]
+class ListLiteral final : public Expression {
+   public:
+    Token Bracket;
+    std::vector<std::unique_ptr<Expression>> Elements;
+    ListLiteral(Token bracket,
+                std::vector<std::unique_ptr<Expression>> elements)
+        : Bracket(bracket), Elements(std::move(elements)) {}
+
+    virtual void Accept(ExpressionVisitor& vis) override { vis.Visit(*this); }
+};
+
+// {key: value, ...}, Keys and Values pair up by index.
+class MapLiteral final : public Expression {
+   public:
+    Token Brace;
+    std::vector<std::unique_ptr<Expression>> Keys;
+    std::vector<std::unique_ptr<Expression>> Values;
+    MapLiteral(Token brace, std::vector<std::unique_ptr<Expression>> keys,
+               std::vector<std::unique_ptr<Expression>> values)
+        : Brace(brace), Keys(std::move(keys)), Values(std::move(values)) {}
+
+    virtual void Accept(ExpressionVisitor& vis) override { vis.Visit(*this); }
+};
+
+// Element of a list or map, object[key].
+class Subscript final : public Expression {
+   public:
+    std::unique_ptr<Expression> Object;
+    Token Bracket;
+    std::unique_ptr<Expression> Key;
+    Subscript(std::unique_ptr<Expression> object, Token bracket,
+              std::unique_ptr<Expression> key)
+        : Object(std::move(object)), Bracket(bracket), Key(std::move(key)) {}
+
+    virtual void Accept(ExpressionVisitor& vis) override { vis.Visit(*this); }
+};
+
+// object[key] = value
+class SetSubscript final : public Expression {
+   public:
+    std::unique_ptr<Expression> Object;
+    Token Bracket;
+    std::unique_ptr<Expression> Key;
+    std::unique_ptr<Expression> Value;
+    SetSubscript(std::unique_ptr<Expression> object, Token bracket,
+                 std::unique_ptr<Expression> key,
+                 std::unique_ptr<Expression> value)
+        : Object(std::move(object)),
+          Bracket(bracket),
+          Key(std::move(key)),
+          Value(std::move(value)) {}
+
+    virtual void Accept(ExpressionVisitor& vis) override { vis.Visit(*this); }
+};
+
+enum class FunctionKind : std::uint8_t { FUNCTION, METHOD, INITIALIZER };
+
+// Methods get this as a hidden first parameter.
+Token ThisToken(std::uint32_t line);
+Token SuperToken(std::uint32_t line);
+
 class FunctionDeclaration final : public Statement {
    public:
     Token Name;
     std::vector<Token> Params;
     std::vector<std::shared_ptr<Statement>> Body;
+    FunctionKind Kind = FunctionKind::FUNCTION;
+    // Set by the resolver: whether nested functions use the function by
+    // name, and each of the parameters, this first for methods.
+    bool Captured = false;
+    std::vector<bool> CapturedParams;
     FunctionDeclaration(Token name, std::vector<Token>&& params,
                         std::vector<std::shared_ptr<Statement>>&& body)
         : Name(std::move(name)),
@@ -233,13 +363,50 @@ class FunctionDeclaration final : public Statement {
 
 class ReturnStatement final : public Statement {
    public:
+    Token Keyword;
+    std::unique_ptr<Expression> Value;
+    ReturnStatement(Token keyword, std::unique_ptr<Expression>&& value)
+        : Keyword(keyword), Value(std::move(value)) {}
+
+    virtual void Accept(StatementVisitor& vis) override { vis.Visit(*this); }
+};
+
+// Suspends the coroutine running the function, its resume returns Value.
+class YieldStatement final : public Statement {
+   public:
+    Token Keyword;
     std::unique_ptr<Expression> Value;
-    ReturnStatement(std::unique_ptr<Expression>&& value)
-        : Value(std::move(value)) {}
+    YieldStatement(Token keyword, std::unique_ptr<Expression>&& value)
+        : Keyword(keyword), Value(std::move(value)) {}
+
+    virtual void Accept(StatementVisitor& vis) override { vis.Visit(*this); }
+};
+
+class ClassDeclaration final : public Statement {
+   public:
+    Token Name;
+    std::unique_ptr<Variable> Superclass;  // Null if it has none.
+    std::vector<std::unique_ptr<FunctionDeclaration>> Methods;
+    // Set by the resolver: whether nested functions use the class by name,
+    // and the superclass through super.
+    bool Captured = false;
+    bool SuperCaptured = false;
+    ClassDeclaration(Token name, std::unique_ptr<Variable> superclass,
+                     std::vector<std::unique_ptr<FunctionDeclaration>> methods)
+        : Name(name),
+          Superclass(std::move(superclass)),
+          Methods(std::move(methods)) {}
 
     virtual void Accept(StatementVisitor& vis) override { vis.Visit(*this); }
 };
 
 void print(Expression& expr);
+void print(std::vector<std::unique_ptr<Statement>>& statements,
+           std::ostream& os = std::cout);
+
+// Whether the statements declare a function or a class, bodies of functions
+// aren't searched.
+bool DeclaresFunction(Statement& statement);
+bool DeclaresFunction(std::vector<std::shared_ptr<Statement>>& statements);
 
 }  // namespace lox
@@ -0,0 +1,97 @@
+#include "threadPool.h"
+
+#include <algorithm>
+
+namespace lox {
+
+ThreadPool::ThreadPool(std::size_t threads) {
+    threads = std::max<std::size_t>(threads, 1);
+    for (std::size_t i = 0; i < threads; ++i) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    for (std::size_t i = 0; i < threads; ++i) {
+        threads_.emplace_back([this, i] { Work(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    Wait();
+    {
+        std::lock_guard lock(lock_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+    std::size_t worker;
+    {
+        // Counted before it's queued, so queued_ never counts less than
+        // the queues hold.
+        std::lock_guard lock(lock_);
+        worker = next_++ % std::size(queues_);
+        ++unfinished_;
+        ++queued_;
+    }
+    {
+        std::lock_guard lock(queues_[worker]->Lock);
+        queues_[worker]->Tasks.push_back(std::move(task));
+    }
+    wake_.notify_one();
+}
+
+void ThreadPool::Wait() {
+    std::unique_lock lock(lock_);
+    idle_.wait(lock, [this] { return unfinished_ == 0; });
+}
+
+bool ThreadPool::RunOne(std::size_t worker) {
+    std::function<void()> task;
+    for (std::size_t i = 0; i < std::size(queues_) && !task; ++i) {
+        auto& queue = *queues_[(worker + i) % std::size(queues_)];
+        std::lock_guard lock(queue.Lock);
+        if (std::empty(queue.Tasks)) {
+            continue;
+        }
+        if (i == 0) {
+            task = std::move(queue.Tasks.back());
+            queue.Tasks.pop_back();
+        } else {
+            task = std::move(queue.Tasks.front());
+            queue.Tasks.pop_front();
+        }
+    }
+    if (!task) {
+        return false;
+    }
+    {
+        std::lock_guard lock(lock_);
+        --queued_;
+    }
+
+    task();
+
+    std::lock_guard lock(lock_);
+    if (--unfinished_ == 0) {
+        idle_.notify_all();
+    }
+    return true;
+}
+
+void ThreadPool::Work(std::size_t worker) {
+    for (;;) {
+        if (RunOne(worker)) {
+            continue;
+        }
+        std::unique_lock lock(lock_);
+        wake_.wait(lock, [this] { return stop_ || queued_ > 0; });
+        if (stop_ && queued_ == 0) {
+            return;
+        }
+    }
+}
+
+}  // namespace lox
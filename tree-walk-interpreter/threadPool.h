@@ -0,0 +1,55 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lox {
+
+// Runs tasks on a fixed set of threads. Each thread has a queue of its own,
+// tasks are dealt out to the queues in turn, and a thread whose queue is
+// empty steals from the others, so threads stay busy when tasks take very
+// different times.
+class ThreadPool {
+    struct Queue {
+        std::mutex Lock;
+        std::deque<std::function<void()>> Tasks;
+    };
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+
+    std::mutex lock_;
+    std::condition_variable wake_;  // There are queued tasks, or stop_.
+    std::condition_variable idle_;  // All tasks finished.
+    std::size_t queued_ = 0;        // Tasks in the queues.
+    std::size_t unfinished_ = 0;    // Tasks queued or running.
+    std::size_t next_ = 0;          // Queue the next task goes to.
+    bool stop_ = false;
+
+    // Take a task, from the back of queue worker or else from the front of
+    // another one, and run it. Return false if there was none.
+    bool RunOne(std::size_t worker);
+    void Work(std::size_t worker);
+
+   public:
+    // At least one thread.
+    explicit ThreadPool(std::size_t threads);
+    // Waits for the tasks that were submitted.
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    std::size_t size() const { return std::size(threads_); }
+
+    // Tasks must not throw.
+    void Submit(std::function<void()> task);
+    // Until all tasks submitted so far have finished.
+    void Wait();
+};
+
+}  // namespace lox
@@ -1,8 +1,6 @@
 #include "tokens.h"
 #include <map>
 #include <sstream>
-#include <iostream>
-#include "variantOverload.h"
 
 namespace lox {
 
@@ -11,12 +9,16 @@ static std::map<TokenType, std::string> token_to_string {
     { TokenType::RIGHT_PAREN, "RIGHT_PAREN " },
     { TokenType::LEFT_BRACE, "LEFT_BRACE " },
     { TokenType::RIGHT_BRACE, "RIGHT_BRACE" },
+    { TokenType::LEFT_BRACKET, "LEFT_BRACKET" },
+    { TokenType::RIGHT_BRACKET, "RIGHT_BRACKET" },
     { TokenType::COMMA, "COMMA" },
     { TokenType::DOT, "DOT" },
     { TokenType::MINUS, "MINUS" },
     { TokenType::PLUS, "PLUS" },
     { TokenType::SEMICOLON, "SEMICOLON" },
-    { TokenType::SLASH, "SLASHSTAR," },
+    { TokenType::COLON, "COLON" },
+    { TokenType::SLASH, "SLASH" },
+    { TokenType::STAR, "STAR" },
     { TokenType::BANG, "BANG" },
     { TokenType::BANG_EQUAL, "BANG_EQUAL" },
     { TokenType::EQUAL, "EQUAL" },
@@ -44,6 +46,7 @@ static std::map<TokenType, std::string> token_to_string {
     { TokenType::TRUE, "TRUE" },
     { TokenType::VAR, "VAR" },
     { TokenType::WHILE, "WHILE" },
+    { TokenType::YIELD, "YIELD" },
     { TokenType::EOFL, "EOFL" }
 };
 
@@ -57,19 +60,22 @@ std::string ToString(TokenType token_type)
     return token_text->second;
 }
 
-std::string Token::ToString()
-{
+std::string TokenList::ToString(const Token& token) const {
     std::stringstream ss;
-    auto data_string = std::visit(
-            overload{
-                [](double p){return std::to_string(p);},
-                [](std::string p){return p;},
-                [](std::monostate){return std::string("");}
-                },
-            this->Data);
-
-    ss << lox::ToString(this->Type) << " lexeme:";
-    ss << this->Lexeme << " data:" << data_string;
+    ss << lox::ToString(token.Type) << " lexeme:" << Lexeme(token);
+    switch (token.Type) {
+        case TokenType::NUMBER:
+            ss << " data:" << Numbers[token.Value];
+            break;
+        case TokenType::STRING:
+            ss << " data:" << Strings[token.Value];
+            break;
+        case TokenType::IDENTIFIER:
+            ss << " symbol:" << token.Value;
+            break;
+        default:
+            break;
+    }
 
     return ss.str();
 }
@@ -1,21 +1,27 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
-#include <variant>
+#include <string_view>
+#include <vector>
 
 namespace lox {
 
-enum class TokenType {
+enum class TokenType : std::uint8_t {
     // single-char tokens.
     LEFT_PAREN,
     RIGHT_PAREN,
     LEFT_BRACE,
     RIGHT_BRACE,
+    LEFT_BRACKET,
+    RIGHT_BRACKET,
     COMMA,
     DOT,
     MINUS,
     PLUS,
     SEMICOLON,
+    COLON,
     SLASH,
     STAR,
 
@@ -51,36 +57,42 @@ enum class TokenType {
     TRUE,
     VAR,
     WHILE,
+    YIELD,
 
     EOFL
 };
 
-class Token final {
-public:
-    using TokenData = std::variant<
-        std::monostate,
-        std::string,
-        double>;
+// Number of TokenType values, for tables indexed by token type.
+constexpr std::size_t kTokenTypeCount =
+    static_cast<std::size_t>(TokenType::EOFL) + 1;
 
-    TokenType Type;
-    std::string Lexeme;
-    TokenData Data;
-    int Line;
+// A token is a plain 16 byte value: the type, where its lexeme is in the
+// source and on which line. What a literal or identifier stands for lives
+// in the side tables of the TokenList the token came from.
+struct Token {
+    std::uint32_t Start;  // Offset of the lexeme in the source.
+    std::uint32_t Length : 24;
+    TokenType Type : 8;
+    std::uint32_t Line;
+    // IDENTIFIER: the interned Symbol, NUMBER: index in TokenList::Numbers,
+    // STRING: index in TokenList::Strings, unused otherwise.
+    std::uint32_t Value;
+};
+
+static_assert(sizeof(Token) == 16, "Token should stay a compact value.");
+
+// Output of the scanner.
+struct TokenList {
+    std::string_view Source;
+    std::vector<Token> Tokens;
+    std::vector<double> Numbers;
+    std::vector<std::string> Strings;  // String literals without the quotes.
 
-public:
-    Token(
-        TokenType type,
-        std::string lexeme,
-        TokenData data,
-        int line)
-        : Type(type)
-        , Lexeme(lexeme)
-        , Data(std::move(data))
-        , Line(line)
-    {
+    std::string_view Lexeme(const Token& token) const {
+        return Source.substr(token.Start, token.Length);
     }
 
-    std::string ToString();
+    std::string ToString(const Token& token) const;
 };
 
 std::string ToString(TokenType);
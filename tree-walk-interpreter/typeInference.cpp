@@ -0,0 +1,276 @@
+#include "typeInference.h"
+
+namespace lox {
+
+TypeInference::Type TypeInference::Join(Type a, Type b) {
+    if (a == Type::NONE || a == b) {
+        return b;
+    }
+    if (b == Type::NONE) {
+        return a;
+    }
+    return Type::UNKNOWN;
+}
+
+namespace {
+
+// Locals without a type yet are optimistically assumed to fit.
+template <typename T>
+bool Fits(T type, T expected) {
+    return type == T::NONE || type == expected;
+}
+
+}  // namespace
+
+void TypeInference::Infer(FunctionDeclaration& function) {
+    do {
+        changed_ = false;
+        // The parameters and the body share a scope.
+        scopes_.emplace_back();
+        if (function.Kind != FunctionKind::FUNCTION) {
+            scopes_.back().insert_or_assign(ThisToken(0).Value, nullptr);
+        }
+        for (auto& param : function.Params) {
+            scopes_.back().insert_or_assign(param.Value, nullptr);
+        }
+        for (auto& s : function.Body) {
+            Infer(*s);
+        }
+        scopes_.pop_back();
+    } while (changed_);
+}
+
+void TypeInference::Infer(
+    std::vector<std::unique_ptr<Statement>>& statements) {
+    do {
+        changed_ = false;
+        for (auto& s : statements) {
+            Infer(*s);
+        }
+    } while (changed_);
+}
+
+TypeInference::Type TypeInference::Infer(Expression& e) {
+    e.Accept(*this);
+    switch (type_) {
+        case Type::NUMBER:
+            e.Type = StaticType::NUMBER;
+            break;
+        case Type::BOOL:
+            e.Type = StaticType::BOOL;
+            break;
+        default:
+            e.Type = StaticType::UNKNOWN;
+            break;
+    }
+    return type_;
+}
+
+VariableDeclaration* TypeInference::Lookup(Expression* expr,
+                                           const Token& name) const {
+    auto distance = locals_.find(expr);
+    if (distance == locals_.end() ||
+        static_cast<std::size_t>(distance->second) >= std::size(scopes_)) {
+        return nullptr;
+    }
+
+    const auto& scope = scopes_[std::size(scopes_) - 1 - distance->second];
+    auto variable = scope.find(name.Value);
+    return variable != scope.end() ? variable->second : nullptr;
+}
+
+void TypeInference::Assign(VariableDeclaration* variable, Type type) {
+    if (variable == nullptr) {
+        return;
+    }
+    auto& current = types_[variable];
+    auto joined = Join(current, type);
+    if (joined != current) {
+        current = joined;
+        changed_ = true;
+    }
+}
+
+void TypeInference::Visit(Literal& l) {
+    if (std::holds_alternative<double>(l.Value)) {
+        type_ = Type::NUMBER;
+    } else if (std::holds_alternative<bool>(l.Value)) {
+        type_ = Type::BOOL;
+    } else {
+        type_ = Type::UNKNOWN;
+    }
+}
+
+void TypeInference::Visit(BinaryExpr& b) {
+    auto left = Infer(*b.Left);
+    auto right = Infer(*b.Right);
+    bool numbers = Fits(left, Type::NUMBER) && Fits(right, Type::NUMBER);
+
+    // Mixing a double with anything else gives nil rather than a double or
+    // a bool.
+    switch (b.Tok.Type) {
+        case TokenType::PLUS:
+        case TokenType::MINUS:
+        case TokenType::STAR:
+        case TokenType::SLASH:
+            type_ = numbers ? Type::NUMBER : Type::UNKNOWN;
+            break;
+        case TokenType::GREATER:
+        case TokenType::GREATER_EQUAL:
+        case TokenType::LESS:
+        case TokenType::LESS_EQUAL:
+            type_ = numbers ? Type::BOOL : Type::UNKNOWN;
+            break;
+        case TokenType::EQUAL_EQUAL:
+        case TokenType::BANG_EQUAL:
+            type_ = numbers || (Fits(left, Type::BOOL) && Fits(right, Type::BOOL))
+                        ? Type::BOOL
+                        : Type::UNKNOWN;
+            break;
+        default:
+            type_ = Type::UNKNOWN;
+            break;
+    }
+}
+
+void TypeInference::Visit(UnaryExpr& u) {
+    auto operand = Infer(*u.Expr);
+    if (u.Op.Type == TokenType::MINUS) {
+        type_ = Fits(operand, Type::NUMBER) ? Type::NUMBER : Type::UNKNOWN;
+    } else {
+        type_ = Fits(operand, Type::BOOL) ? Type::BOOL : Type::UNKNOWN;
+    }
+}
+
+void TypeInference::Visit(Grouping& g) { type_ = Infer(*g.Expr); }
+
+void TypeInference::Visit(Variable& v) {
+    auto* variable = Lookup(&v, v.Name);
+    type_ = variable != nullptr ? types_[variable] : Type::UNKNOWN;
+}
+
+void TypeInference::Visit(Assignment& a) {
+    auto value = Infer(*a.Expr);
+    Assign(Lookup(&a, a.Name), value);
+    type_ = value;
+}
+
+void TypeInference::Visit(Logical& lg) {
+    // The result is one of the operands.
+    auto left = Infer(*lg.Left);
+    auto right = Infer(*lg.Right);
+    type_ = Join(left, right);
+}
+
+void TypeInference::Visit(Call& c) {
+    Infer(*c.Callee);
+    for (auto& a : c.Arguments) {
+        Infer(*a);
+    }
+    type_ = Type::UNKNOWN;
+}
+
+// Fields can hold anything.
+void TypeInference::Visit(Get& g) {
+    Infer(*g.Object);
+    type_ = Type::UNKNOWN;
+}
+
+void TypeInference::Visit(Set& s) {
+    Infer(*s.Object);
+    type_ = Infer(*s.Value);
+}
+
+void TypeInference::Visit(Super&) { type_ = Type::UNKNOWN; }
+
+void TypeInference::Visit(ListLiteral& l) {
+    for (auto& e : l.Elements) {
+        Infer(*e);
+    }
+    type_ = Type::UNKNOWN;
+}
+
+void TypeInference::Visit(MapLiteral& m) {
+    for (std::size_t i = 0; i < std::size(m.Keys); ++i) {
+        Infer(*m.Keys[i]);
+        Infer(*m.Values[i]);
+    }
+    type_ = Type::UNKNOWN;
+}
+
+// Like fields, elements can hold anything.
+void TypeInference::Visit(Subscript& s) {
+    Infer(*s.Object);
+    Infer(*s.Key);
+    type_ = Type::UNKNOWN;
+}
+
+void TypeInference::Visit(SetSubscript& s) {
+    Infer(*s.Object);
+    Infer(*s.Key);
+    type_ = Infer(*s.Value);
+}
+
+void TypeInference::Visit(PrintStatement& p) { Infer(*p.Expr); }
+
+void TypeInference::Visit(ExpressionStatement& e) { Infer(*e.Expr); }
+
+void TypeInference::Visit(VariableDeclaration& vdecl) {
+    // A variable without initializer is false.
+    auto value = vdecl.Initializer != nullptr ? Infer(*vdecl.Initializer)
+                                              : Type::BOOL;
+    if (std::empty(scopes_)) {
+        return;  // A global.
+    }
+    scopes_.back().insert_or_assign(vdecl.Name.Value, &vdecl);
+    Assign(&vdecl, value);
+}
+
+void TypeInference::Visit(Block& blk) {
+    scopes_.emplace_back();
+    for (auto& s : blk.Statements) {
+        Infer(*s);
+    }
+    scopes_.pop_back();
+}
+
+void TypeInference::Visit(IfStatement& i) {
+    Infer(*i.Condition);
+    Infer(*i.ThenBranch);
+    if (i.ElseBranch != nullptr) {
+        Infer(*i.ElseBranch);
+    }
+}
+
+void TypeInference::Visit(While& w) {
+    Infer(*w.Condition);
+    Infer(*w.Body);
+}
+
+void TypeInference::Visit(FunctionDeclaration& f) {
+    // Its body is inferred when it is compiled, the function itself is not
+    // a number or a bool.
+    if (!std::empty(scopes_)) {
+        scopes_.back().insert_or_assign(f.Name.Value, nullptr);
+    }
+}
+
+void TypeInference::Visit(ReturnStatement& r) {
+    if (r.Value != nullptr) {
+        Infer(*r.Value);
+    }
+}
+
+void TypeInference::Visit(YieldStatement& y) {
+    if (y.Value != nullptr) {
+        Infer(*y.Value);
+    }
+}
+
+void TypeInference::Visit(ClassDeclaration& c) {
+    if (!std::empty(scopes_)) {
+        scopes_.back().insert_or_assign(c.Name.Value, nullptr);
+    }
+}
+
+}  // namespace lox
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "symbolTable.h"
+#include "syntaxTree.h"
+
+namespace lox {
+
+// Infers which expressions of a function body always produce a double or
+// always a bool, and stores that in Expression::Type.
+//
+// Only locals of the body are tracked. Parameters, globals, locals of
+// enclosing functions and the results of calls can hold anything. A local is
+// a number if its initializer and every value assigned to it are numbers,
+// which is found by iterating to a fixed point: locals start out without a
+// type, so a loop counter such as "i = i + 1" stays a number. Only use it on
+// bodies whose locals can't be captured, a closure could assign anything.
+class TypeInference : ExpressionVisitor, StatementVisitor {
+    // Unlike StaticType, this has a bottom for locals nothing was assigned
+    // to yet.
+    enum class Type : std::uint8_t { NONE, NUMBER, BOOL, UNKNOWN };
+    static Type Join(Type a, Type b);
+
+    const std::map<Expression*, int>& locals_;
+    std::vector<std::unordered_map<Symbol, VariableDeclaration*>> scopes_;
+    std::unordered_map<VariableDeclaration*, Type> types_;
+    Type type_ = Type::NONE;  // Of the last expression visited.
+    bool changed_ = false;
+
+   public:
+    TypeInference(const std::map<Expression*, int>& locals)
+        : locals_(locals) {}
+
+    void Infer(FunctionDeclaration& function);
+    void Infer(std::vector<std::unique_ptr<Statement>>& statements);
+
+   private:
+    Type Infer(Expression& e);
+    void Infer(Statement& s) { s.Accept(*this); }
+    // Declaration of the local variable expr refers to, or nullptr if it's
+    // not a local of the body.
+    VariableDeclaration* Lookup(Expression* expr, const Token& name) const;
+    void Assign(VariableDeclaration* variable, Type type);
+
+    virtual void Visit(Literal&) override;
+    virtual void Visit(BinaryExpr&) override;
+    virtual void Visit(UnaryExpr&) override;
+    virtual void Visit(Grouping&) override;
+    virtual void Visit(Variable&) override;
+    virtual void Visit(Assignment&) override;
+    virtual void Visit(Logical&) override;
+    virtual void Visit(Call&) override;
+    virtual void Visit(Get&) override;
+    virtual void Visit(Set&) override;
+    virtual void Visit(Super&) override;
+    virtual void Visit(ListLiteral&) override;
+    virtual void Visit(MapLiteral&) override;
+    virtual void Visit(Subscript&) override;
+    virtual void Visit(SetSubscript&) override;
+    virtual void Visit(PrintStatement&) override;
+    virtual void Visit(ExpressionStatement&) override;
+    virtual void Visit(VariableDeclaration& vdecl) override;
+    virtual void Visit(Block& blk) override;
+    virtual void Visit(IfStatement&) override;
+    virtual void Visit(While&) override;
+    virtual void Visit(FunctionDeclaration&) override;
+    virtual void Visit(ReturnStatement&) override;
+    virtual void Visit(YieldStatement&) override;
+    virtual void Visit(ClassDeclaration&) override;
+};
+
+}  // namespace lox
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace lox {
+
+// The registers of all frames, in one block of memory that is reserved up
+// front. It never reallocates, so pointers into it stay valid while frames
+// come and go, and running out of room is reported instead of growing it.
+// Memory of the reservation that is never used isn't touched either.
+template <typename TOut>
+class ValueStack {
+    std::vector<TOut> values_;
+    std::size_t capacity_;
+
+   public:
+    explicit ValueStack(std::size_t capacity) : capacity_(capacity) {
+        values_.reserve(capacity);
+    }
+
+    std::size_t size() const { return std::size(values_); }
+    std::size_t capacity() const { return capacity_; }
+    TOut* data() { return values_.data(); }
+    TOut& operator[](std::size_t index) { return values_[index]; }
+
+    // Grow to size values, the new ones are false. Return false if they
+    // don't fit.
+    [[nodiscard]] bool Grow(std::size_t size) {
+        if (size > capacity_) {
+            return false;
+        }
+        if (size > std::size(values_)) {
+            values_.resize(size);
+        }
+        return true;
+    }
+    // Drop the values from size on.
+    void Shrink(std::size_t size) {
+        if (size < std::size(values_)) {
+            values_.resize(size);
+        }
+    }
+
+    [[nodiscard]] bool Push(TOut&& value) {
+        if (std::size(values_) == capacity_) {
+            return false;
+        }
+        values_.push_back(std::move(value));
+        return true;
+    }
+    TOut Pop() {
+        TOut value = std::move(values_.back());
+        values_.pop_back();
+        return value;
+    }
+};
+
+}  // namespace lox